@@ -1,8 +1,14 @@
 #include "audio_engine.h"
 
-#include "gui.h"
+#include "dynamics.h"
+#include "filter.h"
+#include "fx.h"
 #include "init.h"
 #include "lfo.h"
+#include "meter.h"
+#include "mod_matrix.h"
+#include "scope.h"
+#include "spectrum.h"
 #include "voice.h"
 #include "wavetable.h"
 
@@ -11,23 +17,124 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <string.h>
 
 #define NUM_AUDIO_BUFFERS 4
 
+/// Number of audio callbacks accumulated into each profile snapshot.
+#define PROFILE_WINDOW_BLOCKS 16
+
+/// Fraction bits of an oscillator's output gains, which fold the gain
+/// modulation of up to twice unity into the pan gains. Q14 keeps their
+/// product with a 16-bit sample inside 32 bits.
+#define MIX_GAIN_BITS 14
+
+/// Where an oscillator renders for the current block: the stereo mix
+/// buffers, its MIX_GAIN_BITS output gains from the voice and oscillator pan
+/// and the gain modulation, and its Q15 amplitude from the envelope and
+/// oscillator gain, which ramps by amp_step each sample from where the
+/// envelope started the block to where it ends it.
+struct mix_out_s
+{
+    int32_t * l;
+    int32_t * r;
+    int32_t gain_l;
+    int32_t gain_r;
+    int32_t amp;
+    int32_t amp_step;
+};
+
+/// Sample source of a unison sub-oscillator bank.
+enum unison_src_e
+{
+    UNISON_SRC_TABLE,
+    UNISON_SRC_MORPH,
+    UNISON_SRC_DIRECT,
+};
+
 static void audio_engine_callback(short * buffer, size_t num_samples);
 static void audio_engine_synthesize(short * buffer, size_t num_samples);
-static inline int32_t get_next_sample(void);
-static inline void tick_envelopes(size_t num_ticks);
-
-int32_t peak = 0;
+static inline bool render_voice(voice_t * voice, int32_t * mix_l, int32_t * mix_r,
+                                size_t num_samples);
+static inline void render_osc_dispatch(voice_t * voice, size_t wav_idx, short * table,
+                                       uint32_t phase, uint32_t phase_inc,
+                                       struct mix_out_s const * out, size_t num_samples);
+static inline void render_osc(voice_t * voice, size_t wav_idx, short * table,
+                              uint32_t phase, uint32_t phase_inc,
+                              struct mix_out_s const * out, size_t num_samples,
+                              enum wavetable_interp_e interp);
+static inline void render_osc_morph(voice_t * voice, size_t wav_idx, short * table,
+                                    uint16_t num_frames, uint32_t phase, uint32_t phase_inc,
+                                    struct mix_out_s const * out, size_t num_samples,
+                                    enum wavetable_interp_e interp);
+static inline void render_osc_direct(voice_t * voice, size_t wav_idx,
+                                     uint32_t phase, uint32_t phase_inc,
+                                     struct mix_out_s const * out, size_t num_samples,
+                                     enum oscillator_shape_e shape);
+static inline void render_unison_dispatch(voice_t * voice, size_t wav_idx, short * table,
+                                          uint32_t phase_offset,
+                                          struct mix_out_s const * out, size_t num_samples);
+static inline void render_osc_unison(voice_t * voice, size_t wav_idx, short * table,
+                                     uint16_t num_frames, uint32_t phase_offset,
+                                     struct mix_out_s const * out, size_t num_samples,
+                                     enum unison_src_e src, enum wavetable_interp_e interp,
+                                     enum oscillator_shape_e shape);
+static inline void render_filter(voice_t * voice, int32_t * mix_l, int32_t * mix_r,
+                                 size_t num_samples);
+static inline void render_mod_sources(void);
+static inline void render_mod_voice(voice_t * voice, size_t num_samples);
+static inline void render_fx(int32_t * mix_l, int32_t * mix_r, size_t num_samples);
+static inline void render_dynamics(int32_t * mix_l, int32_t * mix_r, size_t num_samples);
+static inline uint32_t get_frame_pos(wavetable_t const * wav, uint32_t env_level,
+                                     int32_t pos_mod, uint16_t num_frames);
+static inline uint16_t get_frame_idx(uint32_t frame_pos, uint16_t num_frames);
+static inline int32_t get_osc_amp(wavetable_t const * wav, uint32_t env_level);
+static inline int32_t get_pitch_offset(voice_t const * voice);
+static inline uint64_t get_out_level(wavetable_t const * wav, uint32_t env_level,
+                                     struct mix_out_s const * out);
+static inline void cull_voice(voice_t * voice);
 
 static uint8_t mix_gain_factor = 64;
 
+/// Modulation sources for the current control block. The shared sources are
+/// set once per block, and each voice fills in its own before evaluating the
+/// matrix.
+static int32_t mod_src[NUM_MOD_SRCS];
+
+/// Level of each of the current voice's envelopes at the start of the block,
+/// before render_mod_voice() advanced them to its end.
+static uint32_t env_start_level[NUM_ENVELOPES];
+
+/// Mix of all voices for the current control block, before the master gain.
+/// Left and right are accumulated separately, each oscillator adding itself
+/// through its pan gains.
+static int32_t mix_buf_l[CONTROL_BLOCK_SIZE];
+static int32_t mix_buf_r[CONTROL_BLOCK_SIZE];
+
+/// Oscillators of a voice for the current block, gathered here instead of
+/// in the mix buffers when the voice filter is on.
+static int32_t voice_buf_l[CONTROL_BLOCK_SIZE];
+static int32_t voice_buf_r[CONTROL_BLOCK_SIZE];
+
+/// Sum of a unison's sub-oscillators for the current block, before its
+/// envelope and gain.
+static int32_t unison_buf_l[CONTROL_BLOCK_SIZE];
+static int32_t unison_buf_r[CONTROL_BLOCK_SIZE];
+
+/// Profile counters accumulated by the audio callback, and the last complete
+/// window handed to the main loop.
+static struct audio_engine_profile_s profile_accum = {0};
+static struct audio_engine_profile_s profile_snapshot = {0};
+static uint8_t profile_blocks = 0;
+
 void audio_engine_init(void)
 {
+    init_stage_begin(ALLOC_MIX_BUF);
+    dynamics_init();
+    fx_init();
     audio_init(SAMPLE_RATE, NUM_AUDIO_BUFFERS);
-    gui_splash(ALLOC_MIX_BUF);
 
+    init_stage_begin(INIT_AUDIO);
     audio_set_buffer_callback(audio_engine_callback);
 
     // Must kick-start audio callback with dummy write
@@ -42,90 +149,803 @@ static void audio_engine_callback(short * buffer, size_t num_samples)
     }
 }
 
+/// Render the audio buffer in control blocks. LFOs are ticked and the shared
+/// modulation sources read once per block, then each voice renders its
+/// oscillators into the mix buffers one after the other, so the
+/// per-oscillator setup is hoisted out of the sample loop.
+/// The master gain is applied to the finished block, which then passes
+/// through the effects bus and the optional limiter and soft clipper, and is
+/// clamped and written in a single pass with both channels of a frame packed
+/// into one 32-bit store.
 void audio_engine_synthesize(short * buffer, size_t num_samples)
 {
     if (buffer && (num_samples > 0))
     {
-        peak = 0;
-        for (uint16_t i = 0; i < num_samples; ++i)
+        uint32_t const start_ticks = TICKS_READ();
+
+        wavetable_swap_commit();
+
+        for (size_t offset = 0; offset < num_samples; offset += CONTROL_BLOCK_SIZE)
         {
-            int32_t sample = get_next_sample();
+            size_t const block_size = ((num_samples - offset) < CONTROL_BLOCK_SIZE)
+                                      ? (num_samples - offset)
+                                      : CONTROL_BLOCK_SIZE;
 
-            tick_envelopes(1);
+            lfo_tick_all(block_size);
+            render_mod_sources();
 
-            lfo_tick_all(1);
+            memset(mix_buf_l, 0, block_size * sizeof(int32_t));
+            memset(mix_buf_r, 0, block_size * sizeof(int32_t));
 
-            if ((sample > 0) && (sample > peak))
+            uint32_t const voice_start_ticks = TICKS_READ();
+            // Idle voices are skipped before their envelopes, LFOs and
+            // modulation matrix are evaluated.
+            for (size_t voice_idx = 0; voice_idx < POLYPHONY_COUNT; ++voice_idx)
             {
-                peak = sample;
+                voice_t * voice = voice_get(voice_idx);
+                if (!voice_is_idle(voice)
+                    && render_voice(voice, mix_buf_l, mix_buf_r, block_size))
+                {
+                    profile_accum.voice_samples += block_size;
+                }
             }
-            else if ((sample < 0 && ((-1 * sample) > peak)))
+
+            // Stolen voices fade out in their shadows.
+            for (size_t shadow_idx = 0; shadow_idx < VOICE_NUM_SHADOWS; ++shadow_idx)
+            {
+                voice_t * shadow = &voice_shadows[shadow_idx];
+                if (!voice_is_idle(shadow)
+                    && render_voice(shadow, mix_buf_l, mix_buf_r, block_size))
+                {
+                    profile_accum.voice_samples += block_size;
+                }
+            }
+            profile_accum.voice_ticks += TICKS_DISTANCE(voice_start_ticks, TICKS_READ());
+
+            for (size_t i = 0; i < block_size; ++i)
             {
-                peak = (-1 * sample);
+                mix_buf_l[i] = (mix_buf_l[i] * mix_gain_factor) / MIDI_MAX_DATA_BYTE;
+                mix_buf_r[i] = (mix_buf_r[i] * mix_gain_factor) / MIDI_MAX_DATA_BYTE;
             }
 
-            if (sample > INT16_MAX)
-                sample = INT16_MAX;
-            else if (sample < INT16_MIN)
-                sample = INT16_MIN;
+            render_fx(mix_buf_l, mix_buf_r, block_size);
+            render_dynamics(mix_buf_l, mix_buf_r, block_size);
+
+            // The buffer is big-endian interleaved stereo, so the left sample
+            // of each frame is the high half of its word. The word is stored
+            // with memcpy, as the taps read the buffer back as shorts; the
+            // buffer is word aligned, so it compiles to a single store.
+            short * const out = (short *)__builtin_assume_aligned(&buffer[offset * 2], 4);
+
+            for (size_t i = 0; i < block_size; ++i)
+            {
+                int32_t sample_l = mix_buf_l[i];
+                int32_t sample_r = mix_buf_r[i];
+
+                if (sample_l > INT16_MAX)
+                    sample_l = INT16_MAX;
+                else if (sample_l < INT16_MIN)
+                    sample_l = INT16_MIN;
+
+                if (sample_r > INT16_MAX)
+                    sample_r = INT16_MAX;
+                else if (sample_r < INT16_MIN)
+                    sample_r = INT16_MIN;
+
+                uint32_t const frame = ((uint32_t)(uint16_t)sample_l << 16) | (uint16_t)sample_r;
+                memcpy(&out[i * 2], &frame, sizeof(frame));
+            }
+        }
+
+        scope_tap(buffer, num_samples);
+        meter_tap(buffer, num_samples);
+        spectrum_tap(buffer, num_samples);
+
+        profile_accum.num_samples += num_samples;
+        profile_accum.synth_ticks += TICKS_DISTANCE(start_ticks, TICKS_READ());
+
+        if (PROFILE_WINDOW_BLOCKS == ++profile_blocks)
+        {
+            profile_snapshot = profile_accum;
+            memset(&profile_accum, 0, sizeof(profile_accum));
+            profile_blocks = 0;
+        }
+    }
+}
 
-            // Write stereo samples
-            // TODO: Add panning
-            buffer[i * 2] = (int16_t)sample;
-            buffer[(i * 2) + 1] = (int16_t)sample;
+/// Read the modulation sources shared by every voice for the block.
+static inline void render_mod_sources(void)
+{
+    for (size_t lfo_idx = 0; lfo_idx < NUM_LFOS; ++lfo_idx)
+    {
+        if (LFO_SYNC_GLOBAL == lfos[lfo_idx].sync)
+        {
+            mod_src[MOD_SRC_LFO_1 + lfo_idx] = lfo_get_value(&lfos[lfo_idx]);
         }
     }
+    mod_src[MOD_SRC_MOD_WHEEL] = (mod_wheel * MOD_VALUE_ONE) / MIDI_MAX_DATA_BYTE;
+    mod_src[MOD_SRC_AFTERTOUCH] = (mod_aftertouch * MOD_VALUE_ONE) / MIDI_MAX_DATA_BYTE;
+}
+
+/// Advance the voice's envelopes to the end of the block and the per-voice
+/// LFOs a route reads, then evaluate the matrix for the block. Each envelope
+/// is ticked once here for everything that reads it.
+static inline void render_mod_voice(voice_t * voice, size_t num_samples)
+{
+    for (size_t lfo_idx = 0; lfo_idx < NUM_LFOS; ++lfo_idx)
+    {
+        lfo_t const * lfo = &lfos[lfo_idx];
+        if ((LFO_SYNC_GLOBAL != lfo->sync) && (mod_lfo_mask & (1u << lfo_idx)))
+        {
+            mod_src[MOD_SRC_LFO_1 + lfo_idx] = lfo_tick_voice(lfo, &voice->lfo_phase[lfo_idx],
+                                                              num_samples);
+        }
+    }
+
+    for (size_t env_idx = 0; env_idx < NUM_ENVELOPES; ++env_idx)
+    {
+        struct envelope_state_s * env = &voice->env_state[env_idx];
+        env_start_level[env_idx] = env->level;
+        envelope_tick(env, env_idx, num_samples);
+        mod_src[MOD_SRC_ENV_1 + env_idx] = env->level >> (32 - MOD_VALUE_BITS);
+    }
+    mod_src[MOD_SRC_VELOCITY] = (voice->velocity * MOD_VALUE_ONE) / MIDI_MAX_DATA_BYTE;
+
+    mod_matrix_eval(mod_src, voice->mod);
 }
 
-static inline int32_t get_next_sample(void)
+/// Run the effects chain over a finished block, profiling each effect.
+static inline void render_fx(int32_t * mix_l, int32_t * mix_r, size_t num_samples)
 {
-    int32_t amplitude = 0;
+    for (size_t stage_idx = 0; stage_idx < fx_chain_len; ++stage_idx)
+    {
+        struct fx_stage_s const * stage = &fx_chain[stage_idx];
+        uint32_t const fx_start_ticks = TICKS_READ();
+
+        stage->process(mix_l, mix_r, num_samples);
+
+        profile_accum.fx_ticks[stage->fx] += TICKS_DISTANCE(fx_start_ticks, TICKS_READ());
+        profile_accum.fx_samples[stage->fx] += num_samples;
+    }
+}
 
-    for (size_t voice_idx = 0; voice_idx < POLYPHONY_COUNT; ++voice_idx)
+/// Run the enabled master bus dynamics over a finished block, profiling each
+/// stage's cost and deepest gain reduction.
+static inline void render_dynamics(int32_t * mix_l, int32_t * mix_r, size_t num_samples)
+{
+    if (dynamics_limit_enabled)
     {
-        voice_t * voice = voice_get(voice_idx);
+        uint32_t const limit_start_ticks = TICKS_READ();
 
-        for (size_t wav_idx = 0; wav_idx < NUM_OSCILLATORS; ++wav_idx)
+        int32_t const reduction = DYN_GAIN_ONE - dynamics_limit(mix_l, mix_r, num_samples);
+        if (reduction > profile_accum.limit_max_reduction)
         {
-            wavetable_t * wav = &oscillators[wav_idx];
+            profile_accum.limit_max_reduction = reduction;
+        }
 
-            if ((IDLE != voice->amp_env_state[wav_idx].stage)
-                && (NONE != wav->shape)
-                && (wav->gain > 0))
-            {
-                short component = wavetable_get_amplitude(voice->phase,
-                                                          wavetable_get(wav->shape));
+        profile_accum.limit_ticks += TICKS_DISTANCE(limit_start_ticks, TICKS_READ());
+        profile_accum.limit_samples += num_samples;
+    }
+    else
+    {
+        dynamics_limit_bypass();
+    }
 
-                component = (short)(((int64_t)component * (int64_t)voice->amp_env_state[wav_idx].level) / UINT32_MAX);
-                component = (component * wav->gain) / MIDI_MAX_DATA_BYTE;
+    if (dynamics_clip_enabled)
+    {
+        uint32_t const clip_start_ticks = TICKS_READ();
 
-                amplitude += component;
+        int32_t const peak = dynamics_clip(mix_l, mix_r, num_samples);
+        if (peak > profile_accum.clip_peak)
+        {
+            profile_accum.clip_peak = peak;
+        }
+
+        profile_accum.clip_ticks += TICKS_DISTANCE(clip_start_ticks, TICKS_READ());
+        profile_accum.clip_samples += num_samples;
+    }
+}
+
+/// Render every active oscillator of a voice into the mix buffers, and
+/// advance each oscillator's phase by the block. The voice's envelopes and
+/// modulation are evaluated first, and pan gains and the amplitude ramp are
+/// set up once per oscillator per block, with the gain modulation folded
+/// into the pan gains. With the filter on, the oscillators are gathered
+/// in the voice buffers and filtered on their way to the mix.
+/// A voice whose oscillators are all releasing, and end the block below the
+/// cull threshold, is cut off so its slot is free for the next note.
+/// Returns true if any oscillator was rendered.
+static inline bool render_voice(voice_t * voice, int32_t * mix_l, int32_t * mix_r,
+                                size_t num_samples)
+{
+    bool active = false;
+    bool sounding = false;
+    bool releasing = true;
+    uint64_t peak = 0;
+    bool const filtered = (FILTER_OFF != filter.mode);
+    struct mix_out_s out = { .l = mix_l, .r = mix_r };
+
+    render_mod_voice(voice, num_samples);
+    int32_t const mod_gain = mod_matrix_gain(voice->mod[MOD_DST_GAIN]);
+    int32_t const mod_pan = (voice->mod[MOD_DST_PAN] * WT_PAN_CENTER) >> MOD_VALUE_BITS;
+    int32_t const pitch_offset = get_pitch_offset(voice);
+
+    if (filtered)
+    {
+        memset(voice_buf_l, 0, num_samples * sizeof(int32_t));
+        memset(voice_buf_r, 0, num_samples * sizeof(int32_t));
+        out.l = voice_buf_l;
+        out.r = voice_buf_r;
+    }
+
+    for (size_t wav_idx = 0; wav_idx < NUM_OSCILLATORS; ++wav_idx)
+    {
+        wavetable_t * wav = &oscillators[wav_idx];
+        struct envelope_state_s const * env = &voice->env_state[wav->amp_env_idx];
+        uint32_t const env_start = env_start_level[wav->amp_env_idx];
+
+        // Idle oscillators keep running, so they stay in step with the rest
+        // of the voice.
+        uint32_t const phase_offset = (uint32_t)wav->phase_offset << WT_PHASE_OFFSET_SHIFT;
+        uint32_t const phase_inc = wavetable_get_pitch_tune(voice->pitch[wav_idx] + pitch_offset);
+        uint32_t const phase = voice->phase[wav_idx] + phase_offset;
+        voice->phase[wav_idx] += phase_inc * num_samples;
+
+        // An envelope that finished during the block still ramps to silence.
+        if (((IDLE == env->stage) && (0u == env_start)) || (NONE == wav->shape))
+        {
+            continue;
+        }
+
+        // Only the last release segment is cut short, as an earlier one
+        // may be on its way back up.
+        sounding = true;
+        if ((IDLE != env->stage)
+            && ((RELEASE != env->stage)
+                || ((env->seg + 1) < envelopes[wav->amp_env_idx].num_segments)))
+        {
+            releasing = false;
+        }
+
+        // Direct oscillators compute their waveform and need no table.
+        short * table = wavetable_get(wav->shape);
+        bool const direct = wav->direct && wavetable_has_direct(wav->shape);
+        if (((NULL == table) && !direct) || (0 == wav->gain))
+        {
+            continue;
+        }
+
+        int32_t pan = (int32_t)wav->pan + voice->pan - WT_PAN_CENTER + mod_pan;
+        if (pan < 0)
+            pan = 0;
+        else if (pan > MIDI_MAX_DATA_BYTE)
+            pan = MIDI_MAX_DATA_BYTE;
+        wavetable_pan_gains((uint8_t)pan, &out.gain_l, &out.gain_r);
+        out.gain_l = (int32_t)(((int64_t)out.gain_l * mod_gain)
+                               >> (MOD_VALUE_BITS + 15 - MIX_GAIN_BITS));
+        out.gain_r = (int32_t)(((int64_t)out.gain_r * mod_gain)
+                               >> (MOD_VALUE_BITS + 15 - MIX_GAIN_BITS));
+
+        out.amp = get_osc_amp(wav, env_start);
+        out.amp_step = (get_osc_amp(wav, env->level) - out.amp) / (int32_t)num_samples;
+
+        if (releasing)
+        {
+            uint64_t const level = get_out_level(wav, env->level, &out);
+            if (level > peak)
+            {
+                peak = level;
             }
         }
 
-        // Increment phase
-        voice->phase += lfo_mod_tune(voice->tune);
+        uint32_t const osc_start_ticks = TICKS_READ();
+
+        uint8_t const unison_count = wavetable_unison[wav_idx].count;
+        if (unison_count > 1)
+        {
+            render_unison_dispatch(voice, wav_idx, table, phase_offset, &out, num_samples);
+        }
+        else
+        {
+            render_osc_dispatch(voice, wav_idx, table, phase, phase_inc, &out, num_samples);
+        }
+
+        uint32_t const osc_ticks = TICKS_DISTANCE(osc_start_ticks, TICKS_READ());
+        size_t const kernel = direct ? AUDIO_PROFILE_KERNEL_DIRECT : wav->interp;
+        profile_accum.kernel_ticks[kernel] += osc_ticks;
+        profile_accum.kernel_samples[kernel] += num_samples;
+        profile_accum.unison_ticks[unison_count - 1] += osc_ticks;
+        profile_accum.unison_samples[unison_count - 1] += num_samples;
+
+        active = true;
     }
 
-    int16_t gain = lfo_mod_gain(mix_gain_factor);
+    if (filtered && active)
+    {
+        render_filter(voice, mix_l, mix_r, num_samples);
+    }
 
-    return (amplitude * gain / MIDI_MAX_DATA_BYTE);
+    if (sounding && releasing && (peak < voice_cull_level))
+    {
+        cull_voice(voice);
+        ++profile_accum.voices_culled;
+    }
+
+    return active;
 }
 
-static inline void tick_envelopes(size_t num_ticks)
+/// Cut a voice off by idling all of its envelopes. The ramp of the block
+/// just rendered ended at its level, below the cull threshold, so the step
+/// to silence is below it too.
+static inline void cull_voice(voice_t * voice)
 {
-    for (size_t voice_idx = 0; voice_idx < POLYPHONY_COUNT; ++voice_idx)
+    for (size_t env_idx = 0; env_idx < NUM_ENVELOPES; ++env_idx)
     {
-        voice_t * voice = voice_get(voice_idx);
-        for (size_t wav_idx = 0; wav_idx < NUM_OSCILLATORS; ++wav_idx)
+        envelope_reset(&voice->env_state[env_idx]);
+    }
+}
+
+/// Filter a voice's block from the voice buffers into the mix buffers. The
+/// cutoff follows the note and the filter envelope, and its coefficients are
+/// derived once for the block.
+static inline void render_filter(voice_t * voice, int32_t * mix_l, int32_t * mix_r,
+                                 size_t num_samples)
+{
+    uint32_t const filter_start_ticks = TICKS_READ();
+
+    struct filter_coefs_s coefs;
+    int32_t const cutoff_mod = (int32_t)(((int64_t)voice->mod[MOD_DST_CUTOFF]
+                                          * (MOD_CUTOFF_RANGE << FILTER_PITCH_FRAC_BITS))
+                                         >> MOD_VALUE_BITS);
+    filter_get_coefs(filter_get_pitch(voice->note, voice->env_state[filter.env_idx].level,
+                                      cutoff_mod),
+                     &coefs);
+
+    switch (filter.mode)
+    {
+        case FILTER_HP:
+            filter_process(&voice->filter_state[0], &coefs, voice_buf_l, num_samples, FILTER_HP);
+            filter_process(&voice->filter_state[1], &coefs, voice_buf_r, num_samples, FILTER_HP);
+            break;
+        case FILTER_BP:
+            filter_process(&voice->filter_state[0], &coefs, voice_buf_l, num_samples, FILTER_BP);
+            filter_process(&voice->filter_state[1], &coefs, voice_buf_r, num_samples, FILTER_BP);
+            break;
+        case FILTER_LP:
+        default:
+            filter_process(&voice->filter_state[0], &coefs, voice_buf_l, num_samples, FILTER_LP);
+            filter_process(&voice->filter_state[1], &coefs, voice_buf_r, num_samples, FILTER_LP);
+            break;
+    }
+
+    for (size_t i = 0; i < num_samples; ++i)
+    {
+        mix_l[i] += voice_buf_l[i];
+        mix_r[i] += voice_buf_r[i];
+    }
+
+    profile_accum.filter_ticks += TICKS_DISTANCE(filter_start_ticks, TICKS_READ());
+    profile_accum.filter_samples += num_samples;
+}
+
+/// Pick the render loop for an oscillator's source and interpolation mode.
+/// Each call below passes a constant mode or shape, so every combination is
+/// compiled into its own loop with the kernel inlined.
+static inline void render_osc_dispatch(voice_t * voice, size_t wav_idx, short * table,
+                                       uint32_t phase, uint32_t phase_inc,
+                                       struct mix_out_s const * out, size_t num_samples)
+{
+    wavetable_t * wav = &oscillators[wav_idx];
+    uint16_t const num_frames = wavetable_get_num_frames(wav->shape);
+
+    if (wav->direct && wavetable_has_direct(wav->shape))
+    {
+        switch (wav->shape)
         {
-            if ((IDLE != voice->amp_env_state[wav_idx].stage)
-                && (NONE != oscillators[wav_idx].shape))
+            case SQUARE:
+                render_osc_direct(voice, wav_idx, phase, phase_inc, out, num_samples, SQUARE);
+                break;
+            case TRIANGLE:
+                render_osc_direct(voice, wav_idx, phase, phase_inc, out, num_samples, TRIANGLE);
+                break;
+            case RAMP:
+            default:
+                render_osc_direct(voice, wav_idx, phase, phase_inc, out, num_samples, RAMP);
+                break;
+        }
+    }
+    else if (num_frames > 1)
+    {
+        profile_accum.morph_samples += num_samples;
+
+        switch (wav->interp)
+        {
+            case WT_INTERP_NONE:
+                render_osc_morph(voice, wav_idx, table, num_frames, phase, phase_inc,
+                                 out, num_samples, WT_INTERP_NONE);
+                break;
+            case WT_INTERP_CUBIC:
+                render_osc_morph(voice, wav_idx, table, num_frames, phase, phase_inc,
+                                 out, num_samples, WT_INTERP_CUBIC);
+                break;
+            case WT_INTERP_LINEAR:
+            default:
+                render_osc_morph(voice, wav_idx, table, num_frames, phase, phase_inc,
+                                 out, num_samples, WT_INTERP_LINEAR);
+                break;
+        }
+    }
+    else
+    {
+        switch (wav->interp)
+        {
+            case WT_INTERP_NONE:
+                render_osc(voice, wav_idx, table, phase, phase_inc, out, num_samples, WT_INTERP_NONE);
+                break;
+            case WT_INTERP_CUBIC:
+                render_osc(voice, wav_idx, table, phase, phase_inc, out, num_samples, WT_INTERP_CUBIC);
+                break;
+            case WT_INTERP_LINEAR:
+            default:
+                render_osc(voice, wav_idx, table, phase, phase_inc, out, num_samples, WT_INTERP_LINEAR);
+                break;
+        }
+    }
+}
+
+/// Render a single-frame oscillator.
+__attribute__((always_inline))
+static inline void render_osc(voice_t * voice, size_t wav_idx, short * table,
+                              uint32_t phase, uint32_t phase_inc,
+                              struct mix_out_s const * out, size_t num_samples,
+                              enum wavetable_interp_e interp)
+{
+    int32_t const gain_l = out->gain_l;
+    int32_t const gain_r = out->gain_r;
+    int32_t const amp_step = out->amp_step;
+    int32_t amp = out->amp;
+
+    for (size_t i = 0; i < num_samples; ++i)
+    {
+        short component = wavetable_lookup(phase, table, interp);
+
+        component = (short)((component * amp) >> 15);
+
+        out->l[i] += (component * gain_l) >> MIX_GAIN_BITS;
+        out->r[i] += (component * gain_r) >> MIX_GAIN_BITS;
+
+        amp += amp_step;
+        phase += phase_inc;
+    }
+}
+
+/// Render a direct oscillator. Needs no table: the waveform is computed from
+/// the phase, with PolyBLEP or PolyBLAMP residuals at its corners sized by
+/// the phase increment, which keeps aliasing down at every pitch.
+__attribute__((always_inline))
+static inline void render_osc_direct(voice_t * voice, size_t wav_idx,
+                                     uint32_t phase, uint32_t phase_inc,
+                                     struct mix_out_s const * out, size_t num_samples,
+                                     enum oscillator_shape_e shape)
+{
+    int32_t const gain_l = out->gain_l;
+    int32_t const gain_r = out->gain_r;
+    int32_t const amp_step = out->amp_step;
+    int32_t amp = out->amp;
+
+    uint32_t const inv_dt = wavetable_direct_inv_dt(phase_inc);
+    int32_t const direct_gain = wavetable_direct_gain[shape];
+
+    for (size_t i = 0; i < num_samples; ++i)
+    {
+        short component = (short)((wavetable_direct(phase, phase_inc, inv_dt, shape)
+                                   * direct_gain) >> 15);
+
+        component = (short)((component * amp) >> 15);
+
+        out->l[i] += (component * gain_l) >> MIX_GAIN_BITS;
+        out->r[i] += (component * gain_r) >> MIX_GAIN_BITS;
+
+        amp += amp_step;
+        phase += phase_inc;
+    }
+}
+
+/// Render a multi-frame oscillator, interpolating between the two frames
+/// either side of its position.
+/// The frame pair is resolved once per block from the position at the end of
+/// the block. The fraction between them ramps from where the previous block
+/// ended, so slow position changes scan smoothly without touching the frame
+/// pointers in the sample loop.
+__attribute__((always_inline))
+static inline void render_osc_morph(voice_t * voice, size_t wav_idx, short * table,
+                                    uint16_t num_frames, uint32_t phase, uint32_t phase_inc,
+                                    struct mix_out_s const * out, size_t num_samples,
+                                    enum wavetable_interp_e interp)
+{
+    wavetable_t * wav = &oscillators[wav_idx];
+    int32_t const gain_l = out->gain_l;
+    int32_t const gain_r = out->gain_r;
+    int32_t const amp_step = out->amp_step;
+    int32_t amp = out->amp;
+
+    uint32_t const frame_pos = get_frame_pos(wav, voice->env_state[wav->amp_env_idx].level,
+                                             voice->mod[MOD_DST_POSITION], num_frames);
+    uint16_t const frame_idx = get_frame_idx(frame_pos, num_frames);
+
+    short * frame_0 = wavetable_get_frame(table, frame_idx);
+    short * frame_1 = wavetable_get_frame(table, frame_idx + 1);
+
+    int32_t const frame_base = (int32_t)frame_idx << WT_POSITION_BITS;
+    int32_t const frac_end = (int32_t)frame_pos - frame_base;
+    int32_t frac = frac_end;
+
+    if (VOICE_MORPH_POS_NONE != voice->morph_pos[wav_idx])
+    {
+        frac = (int32_t)voice->morph_pos[wav_idx] - frame_base;
+        if (frac < 0)
+            frac = 0;
+        else if (frac > WT_POSITION_ONE)
+            frac = WT_POSITION_ONE;
+    }
+    voice->morph_pos[wav_idx] = frame_pos;
+
+    int32_t const frac_step = (frac_end - frac) / (int32_t)num_samples;
+
+    for (size_t i = 0; i < num_samples; ++i)
+    {
+        frac += frac_step;
+
+        short component = wavetable_get_morph_amplitude(phase, frame_0, frame_1,
+            frac >> (WT_POSITION_BITS - WT_MORPH_FRAC_BITS), interp);
+
+        component = (short)((component * amp) >> 15);
+
+        out->l[i] += (component * gain_l) >> MIX_GAIN_BITS;
+        out->r[i] += (component * gain_r) >> MIX_GAIN_BITS;
+
+        amp += amp_step;
+        phase += phase_inc;
+    }
+}
+
+/// Pick the unison render loop for an oscillator's source and interpolation
+/// mode, passing constants as render_osc_dispatch() does.
+static inline void render_unison_dispatch(voice_t * voice, size_t wav_idx, short * table,
+                                          uint32_t phase_offset,
+                                          struct mix_out_s const * out, size_t num_samples)
+{
+    wavetable_t * wav = &oscillators[wav_idx];
+    uint16_t const num_frames = wavetable_get_num_frames(wav->shape);
+
+    if (wav->direct && wavetable_has_direct(wav->shape))
+    {
+        switch (wav->shape)
+        {
+            case SQUARE:
+                render_osc_unison(voice, wav_idx, table, num_frames, phase_offset, out,
+                                  num_samples, UNISON_SRC_DIRECT, WT_INTERP_NONE, SQUARE);
+                break;
+            case TRIANGLE:
+                render_osc_unison(voice, wav_idx, table, num_frames, phase_offset, out,
+                                  num_samples, UNISON_SRC_DIRECT, WT_INTERP_NONE, TRIANGLE);
+                break;
+            case RAMP:
+            default:
+                render_osc_unison(voice, wav_idx, table, num_frames, phase_offset, out,
+                                  num_samples, UNISON_SRC_DIRECT, WT_INTERP_NONE, RAMP);
+                break;
+        }
+    }
+    else if (num_frames > 1)
+    {
+        profile_accum.morph_samples += num_samples;
+
+        switch (wav->interp)
+        {
+            case WT_INTERP_NONE:
+                render_osc_unison(voice, wav_idx, table, num_frames, phase_offset, out,
+                                  num_samples, UNISON_SRC_MORPH, WT_INTERP_NONE, NONE);
+                break;
+            case WT_INTERP_CUBIC:
+                render_osc_unison(voice, wav_idx, table, num_frames, phase_offset, out,
+                                  num_samples, UNISON_SRC_MORPH, WT_INTERP_CUBIC, NONE);
+                break;
+            case WT_INTERP_LINEAR:
+            default:
+                render_osc_unison(voice, wav_idx, table, num_frames, phase_offset, out,
+                                  num_samples, UNISON_SRC_MORPH, WT_INTERP_LINEAR, NONE);
+                break;
+        }
+    }
+    else
+    {
+        switch (wav->interp)
+        {
+            case WT_INTERP_NONE:
+                render_osc_unison(voice, wav_idx, table, num_frames, phase_offset, out,
+                                  num_samples, UNISON_SRC_TABLE, WT_INTERP_NONE, NONE);
+                break;
+            case WT_INTERP_CUBIC:
+                render_osc_unison(voice, wav_idx, table, num_frames, phase_offset, out,
+                                  num_samples, UNISON_SRC_TABLE, WT_INTERP_CUBIC, NONE);
+                break;
+            case WT_INTERP_LINEAR:
+            default:
+                render_osc_unison(voice, wav_idx, table, num_frames, phase_offset, out,
+                                  num_samples, UNISON_SRC_TABLE, WT_INTERP_LINEAR, NONE);
+                break;
+        }
+    }
+}
+
+/// Render an oscillator as a bank of detuned sub-oscillators spread across
+/// the stereo field.
+/// Each sub-oscillator runs its own tight loop over the block, reading its
+/// phase from the voice's packed unison array and its detune from the unison
+/// settings, and summing into the unison buffers with its pan gains. The
+/// envelope and gain are then applied once per sample to the sum rather than
+/// to every sub-oscillator.
+/// A morphing table holds its frame pair and fraction for the block.
+__attribute__((always_inline))
+static inline void render_osc_unison(voice_t * voice, size_t wav_idx, short * table,
+                                     uint16_t num_frames, uint32_t phase_offset,
+                                     struct mix_out_s const * out, size_t num_samples,
+                                     enum unison_src_e src, enum wavetable_interp_e interp,
+                                     enum oscillator_shape_e shape)
+{
+    wavetable_t * wav = &oscillators[wav_idx];
+    struct wavetable_unison_s const * unison = &wavetable_unison[wav_idx];
+
+    uint32_t * sub_phase = voice->unison_phase[wav_idx];
+    int32_t const pitch = voice->pitch[wav_idx] + get_pitch_offset(voice);
+
+    short * frame_0 = table;
+    short * frame_1 = table;
+    uint32_t morph_frac = 0;
+
+    if (UNISON_SRC_MORPH == src)
+    {
+        uint32_t const frame_pos = get_frame_pos(wav, voice->env_state[wav->amp_env_idx].level,
+                                                 voice->mod[MOD_DST_POSITION], num_frames);
+        uint16_t const frame_idx = get_frame_idx(frame_pos, num_frames);
+
+        frame_0 = wavetable_get_frame(table, frame_idx);
+        frame_1 = wavetable_get_frame(table, frame_idx + 1);
+        morph_frac = (frame_pos - ((uint32_t)frame_idx << WT_POSITION_BITS))
+                     >> (WT_POSITION_BITS - WT_MORPH_FRAC_BITS);
+
+        voice->morph_pos[wav_idx] = frame_pos;
+    }
+
+    memset(unison_buf_l, 0, num_samples * sizeof(int32_t));
+    memset(unison_buf_r, 0, num_samples * sizeof(int32_t));
+
+    for (size_t sub_idx = 0; sub_idx < unison->count; ++sub_idx)
+    {
+        uint32_t const phase_inc = wavetable_get_pitch_tune(pitch + unison->detune_pitch[sub_idx]);
+        uint32_t phase = sub_phase[sub_idx] + phase_offset;
+
+        int32_t gain_l = unison->gain_l[sub_idx];
+        int32_t gain_r = unison->gain_r[sub_idx];
+        uint32_t inv_dt = 0;
+
+        if (UNISON_SRC_DIRECT == src)
+        {
+            inv_dt = wavetable_direct_inv_dt(phase_inc);
+            gain_l = (gain_l * wavetable_direct_gain[shape]) >> 15;
+            gain_r = (gain_r * wavetable_direct_gain[shape]) >> 15;
+        }
+
+        for (size_t i = 0; i < num_samples; ++i)
+        {
+            int32_t component;
+            if (UNISON_SRC_DIRECT == src)
             {
-                envelope_tick(&voice->amp_env_state[wav_idx], oscillators[wav_idx].amp_env_idx, num_ticks);
+                component = wavetable_direct(phase, phase_inc, inv_dt, shape);
             }
+            else if (UNISON_SRC_MORPH == src)
+            {
+                component = wavetable_get_morph_amplitude(phase, frame_0, frame_1,
+                                                          morph_frac, interp);
+            }
+            else
+            {
+                component = wavetable_lookup(phase, table, interp);
+            }
+
+            unison_buf_l[i] += (component * gain_l) >> 15;
+            unison_buf_r[i] += (component * gain_r) >> 15;
+
+            phase += phase_inc;
         }
+
+        sub_phase[sub_idx] += phase_inc * num_samples;
     }
+
+    int32_t const amp_step = out->amp_step;
+    int32_t amp = out->amp;
+
+    for (size_t i = 0; i < num_samples; ++i)
+    {
+        int32_t const level_l = (amp * out->gain_l) >> MIX_GAIN_BITS;
+        int32_t const level_r = (amp * out->gain_r) >> MIX_GAIN_BITS;
+
+        // The sum of the bank can exceed full scale before the envelope.
+        out->l[i] += (int32_t)(((int64_t)unison_buf_l[i] * level_l) >> 15);
+        out->r[i] += (int32_t)(((int64_t)unison_buf_r[i] * level_r) >> 15);
+
+        amp += amp_step;
+    }
+}
+
+/// Return the frame index of the first of the pair of frames either side of
+/// a frame position. The last frame is reached as the pair
+/// (num_frames - 2, num_frames - 1) at a fraction of one.
+static inline uint16_t get_frame_idx(uint32_t frame_pos, uint16_t num_frames)
+{
+    uint16_t frame_idx = (uint16_t)(frame_pos >> WT_POSITION_BITS);
+    if (frame_idx > (num_frames - 2))
+    {
+        frame_idx = num_frames - 2;
+    }
+    return frame_idx;
+}
+
+/// Return the modulated position of an oscillator as a frame index, with
+/// WT_POSITION_BITS of fraction. A full scale position modulation sweeps the
+/// whole frame range.
+static inline uint32_t get_frame_pos(wavetable_t const * wav, uint32_t env_level,
+                                     int32_t pos_mod, uint16_t num_frames)
+{
+    int32_t pos = ((int32_t)wav->position << WT_POSITION_BITS) / MIDI_MAX_DATA_BYTE;
+
+    pos += ((int32_t)(env_level >> (32 - WT_POSITION_BITS)) * wav->pos_env_amt)
+           / MIDI_MAX_DATA_BYTE;
+
+    pos += pos_mod << (WT_POSITION_BITS - MOD_VALUE_BITS);
+
+    if (pos < 0)
+        pos = 0;
+    else if (pos > WT_POSITION_ONE)
+        pos = WT_POSITION_ONE;
+
+    return (uint32_t)pos * (num_frames - 1);
+}
+
+/// Return the Q15 amplitude of an oscillator at an envelope level.
+static inline int32_t get_osc_amp(wavetable_t const * wav, uint32_t env_level)
+{
+    return (int32_t)(((env_level >> 17) * wav->gain) / MIDI_MAX_DATA_BYTE);
+}
+
+/// Return the pitch offset of a voice for the block, the pitch bend plus its
+/// pitch modulation, in WT_PITCH_FRAC_BITS fixed point semitones.
+static inline int32_t get_pitch_offset(voice_t const * voice)
+{
+    return voice_pitch_bend
+           + (int32_t)(((int64_t)voice->mod[MOD_DST_PITCH] * (MOD_PITCH_RANGE << WT_PITCH_FRAC_BITS))
+                       >> MOD_VALUE_BITS);
+}
+
+/// Return the level an oscillator reaches the output at, on the envelope
+/// scale: its envelope level through its gain, the louder of its output
+/// gains, which carry the pan and the gain modulation, and the master gain.
+/// A hard panned side is up to 3 dB above center.
+static inline uint64_t get_out_level(wavetable_t const * wav, uint32_t env_level,
+                                     struct mix_out_s const * out)
+{
+    uint64_t const out_gain = (out->gain_l > out->gain_r) ? out->gain_l : out->gain_r;
+    uint64_t const level = ((uint64_t)env_level * wav->gain) / MIDI_MAX_DATA_BYTE;
+    return (((level * out_gain) >> MIX_GAIN_BITS) * mix_gain_factor) / MIDI_MAX_DATA_BYTE;
+}
+
+/// Copy the most recent profile window.
+void audio_engine_get_profile(struct audio_engine_profile_s * profile)
+{
+    disable_interrupts();
+    *profile = profile_snapshot;
+    enable_interrupts();
 }
 
 void audio_engine_set_gain(uint8_t data)
@@ -2,16 +2,61 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "fx.h"
+#include "wavetable.h"
+
 #ifndef AUDIO_ENGINE_H
 #define AUDIO_ENGINE_H
 
 #define SAMPLE_RATE 44100
 
-extern int32_t peak;
+/// Number of samples rendered per control block. Modulation sources and
+/// wavetable frame pointers are updated once per block, and effects process
+/// at most this many samples at a time.
+#define CONTROL_BLOCK_SIZE 32
+
+/// Oscillator kernels profiled separately: each interpolation mode of the
+/// table path, then the direct oscillators.
+#define AUDIO_PROFILE_KERNEL_DIRECT NUM_WT_INTERP
+#define NUM_AUDIO_PROFILE_KERNELS (NUM_WT_INTERP + 1)
+
+/// Synthesis cost over a window of audio callbacks, in timer ticks.
+/// voice_samples counts one per sample per voice rendered, and morph_samples
+/// one per sample per oscillator rendered with frame morphing. Oscillator
+/// render time and samples are also split by kernel, and by unison count.
+/// Filter time and samples are the part of the voice totals spent in the
+/// voice filters. Each effect on the bus reports its own time and samples.
+/// The master bus dynamics report their cost, the limiter its deepest gain
+/// reduction in Q16 and the soft clipper the largest magnitude it received.
+/// voices_culled counts voices cut off in their release once inaudible.
+struct audio_engine_profile_s
+{
+    uint32_t num_samples;
+    uint32_t voice_samples;
+    uint32_t voices_culled;
+    uint32_t morph_samples;
+    uint32_t synth_ticks;
+    uint32_t voice_ticks;
+    uint32_t kernel_samples[NUM_AUDIO_PROFILE_KERNELS];
+    uint32_t kernel_ticks[NUM_AUDIO_PROFILE_KERNELS];
+    uint32_t unison_samples[WT_MAX_UNISON];
+    uint32_t unison_ticks[WT_MAX_UNISON];
+    uint32_t filter_samples;
+    uint32_t filter_ticks;
+    uint32_t fx_samples[NUM_FX];
+    uint32_t fx_ticks[NUM_FX];
+    uint32_t limit_samples;
+    uint32_t limit_ticks;
+    int32_t limit_max_reduction;
+    uint32_t clip_samples;
+    uint32_t clip_ticks;
+    int32_t clip_peak;
+};
 
 void audio_engine_init(void);
 
 void audio_engine_set_gain(uint8_t data);
+void audio_engine_get_profile(struct audio_engine_profile_s * profile);
 
 
 #endif
\ No newline at end of file
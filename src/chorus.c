@@ -0,0 +1,142 @@
+#include "chorus.h"
+
+#include "lfo.h"
+#include "wavetable.h"
+
+#include <midi64.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/// The lines are as long as a wavetable, so a read position in the phase
+/// accumulator's format wraps around the line on its own, and its fraction
+/// is in the bits wavetable_interpolate() expects.
+#define CHORUS_LINE_LEN WT_SIZE
+
+struct chorus_s chorus;
+
+/// Left and right delay lines.
+static int16_t lines[2][CHORUS_LINE_LEN];
+static uint32_t write_idx = 0;
+
+/// The sweep's LFO, private to the chorus so it runs whatever the voice LFOs
+/// are doing. The right channel reads it with a phase offset.
+static lfo_t sweep_lfo;
+
+/// Delay of each channel at the end of the last block, in the phase
+/// accumulator's format. Each block ramps from here to its new delay.
+static uint32_t delay_pos[2];
+
+static inline void chorus_process_line(int16_t * line, int32_t * mix, size_t num_samples,
+                                       uint32_t delay_start, int32_t delay_step, int32_t wet);
+static inline int16_t chorus_saturate(int32_t sample);
+
+void chorus_init(void)
+{
+    chorus.enabled = false;
+    chorus.depth = 48;
+    chorus.delay = 32;
+    chorus.mix = 64;
+    chorus.spread = MIDI_MAX_DATA_BYTE;
+
+    sweep_lfo.shape = SINE;
+    sweep_lfo.phase_pos = 0u;
+    sweep_lfo.cur_amplitude = 0;
+    sweep_lfo.depth = 0;
+    sweep_lfo.direct = false;
+    chorus_set_rate(24);
+
+    chorus_reset();
+}
+
+size_t chorus_get_mem_bytes(void)
+{
+    return sizeof(lines);
+}
+
+void chorus_set_rate(uint8_t rate)
+{
+    chorus.rate = rate;
+    sweep_lfo.rate = ((rate + 1) * CHORUS_RATE_MAX_HZ) / (MIDI_MAX_DATA_BYTE + 1);
+    sweep_lfo.tune = wavetable_get_freq_tune(sweep_lfo.rate);
+}
+
+/// Silence the delay lines. Must not run while the chorus is in the effects
+/// chain.
+void chorus_reset(void)
+{
+    memset(lines, 0, sizeof(lines));
+    delay_pos[0] = (uint32_t)CHORUS_DELAY_MIN_FRAMES << FRAC_BITS;
+    delay_pos[1] = (uint32_t)CHORUS_DELAY_MIN_FRAMES << FRAC_BITS;
+}
+
+/// Add the chorus to a block of the bus. The sweep LFO ticks once per block,
+/// and each channel's delay ramps linearly across the block to the new
+/// setting, so the sample loop only interpolates the lines.
+void chorus_process(int32_t * mix_l, int32_t * mix_r, size_t num_samples)
+{
+    lfo_tick(&sweep_lfo, num_samples);
+
+    uint32_t const base = (uint32_t)(CHORUS_DELAY_MIN_FRAMES
+                                     + ((chorus.delay * (CHORUS_DELAY_MAX_FRAMES - CHORUS_DELAY_MIN_FRAMES))
+                                        / MIDI_MAX_DATA_BYTE)) << FRAC_BITS;
+    uint32_t const depth = (uint32_t)((((uint64_t)chorus.depth * CHORUS_DEPTH_MAX_FRAMES) << FRAC_BITS)
+                                      / MIDI_MAX_DATA_BYTE);
+    uint32_t const spread = chorus.spread * ((1u << 31) / MIDI_MAX_DATA_BYTE);
+    int32_t const wet = (chorus.mix * INT16_MAX) / MIDI_MAX_DATA_BYTE;
+
+    int32_t const amp[2] =
+    {
+        sweep_lfo.cur_amplitude,
+        wavetable_get_amplitude(sweep_lfo.phase_pos + spread, wavetable_get(SINE)),
+    };
+    int32_t * const mix[2] = { mix_l, mix_r };
+
+    for (size_t ch = 0; ch < 2; ++ch)
+    {
+        // Unipolar sweep, so the delay never drops below the base.
+        uint32_t const target = base + (uint32_t)(((uint64_t)depth * (uint32_t)(amp[ch] + 32768)) >> 16);
+        int32_t const step = ((int32_t)(target - delay_pos[ch])) / (int32_t)num_samples;
+
+        chorus_process_line(lines[ch], mix[ch], num_samples, delay_pos[ch], step, wet);
+        delay_pos[ch] = target;
+    }
+
+    write_idx = (write_idx + num_samples) & (CHORUS_LINE_LEN - 1);
+}
+
+/// Run a block through one line: write the dry signal, then add the
+/// interpolated read from the swept delay behind it.
+__attribute__((always_inline))
+static inline void chorus_process_line(int16_t * line, int32_t * mix, size_t num_samples,
+                                       uint32_t delay_start, int32_t delay_step, int32_t wet)
+{
+    uint32_t delay_cur = delay_start;
+
+    for (size_t i = 0; i < num_samples; ++i)
+    {
+        uint32_t const w_idx = (write_idx + i) & (CHORUS_LINE_LEN - 1);
+        line[w_idx] = chorus_saturate(mix[i]);
+
+        delay_cur += delay_step;
+        uint32_t const read_pos = (w_idx << FRAC_BITS) - delay_cur;
+        uint32_t const r_idx = read_pos >> FRAC_BITS;
+
+        int16_t const y0 = line[r_idx];
+        int16_t const y1 = line[(r_idx + 1) & (CHORUS_LINE_LEN - 1)];
+        int32_t const out = y0 + wavetable_interpolate(y0, y1, read_pos & ((1 << FRAC_BITS) - 1));
+
+        mix[i] += (out * wet) >> 15;
+    }
+}
+
+static inline int16_t chorus_saturate(int32_t sample)
+{
+    if (sample > INT16_MAX)
+        return INT16_MAX;
+    else if (sample < INT16_MIN)
+        return INT16_MIN;
+    return (int16_t)sample;
+}
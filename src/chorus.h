@@ -0,0 +1,42 @@
+#ifndef CHORUS_H
+#define CHORUS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Chorus delay range in frames. The modulation sweeps from the base delay
+/// up by as much as the depth, so the longest read is their sum.
+#define CHORUS_DELAY_MIN_FRAMES 44    // 1 ms
+#define CHORUS_DELAY_MAX_FRAMES 1102  // 25 ms
+#define CHORUS_DEPTH_MAX_FRAMES 441   // 10 ms
+
+/// Modulation rate at the top of the rate setting.
+#define CHORUS_RATE_MAX_HZ 5.0f
+
+/// Chorus settings.
+/// rate, depth, delay, mix and spread in [0,MIDI_MAX_DATA_BYTE]. rate and
+/// depth set the speed and width of the delay sweep, delay the base delay it
+/// sweeps up from, and mix the level of the delayed signal added to the bus.
+/// spread offsets the right channel's sweep from the left by up to half a
+/// cycle.
+/// rate is changed through chorus_set_rate(), which retunes the LFO.
+struct chorus_s
+{
+    bool enabled;
+    uint8_t rate;
+    uint8_t depth;
+    uint8_t delay;
+    uint8_t mix;
+    uint8_t spread;
+};
+
+extern struct chorus_s chorus;
+
+void chorus_init(void);
+size_t chorus_get_mem_bytes(void);
+void chorus_set_rate(uint8_t rate);
+void chorus_reset(void);
+void chorus_process(int32_t * mix_l, int32_t * mix_r, size_t num_samples);
+
+#endif
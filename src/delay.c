@@ -0,0 +1,192 @@
+#include "delay.h"
+
+#include "tempo.h"
+
+#include <midi64.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Feedback low pass coefficient at full damping, Q15. Leaves the repeats a
+/// cutoff of a few hundred hertz.
+#define DELAY_DAMP_COEF_MIN 2048
+
+struct delay_s delay;
+
+/// Length of each note division in twelfths of a beat.
+uint8_t const delay_div_twelfths[NUM_DELAY_DIVS] =
+{
+    [DELAY_DIV_HALF]            = 24,
+    [DELAY_DIV_QUARTER_DOTTED]  = 18,
+    [DELAY_DIV_QUARTER]         = 12,
+    [DELAY_DIV_EIGHTH_DOTTED]   = 9,
+    [DELAY_DIV_QUARTER_TRIPLET] = 8,
+    [DELAY_DIV_EIGHTH]          = 6,
+    [DELAY_DIV_EIGHTH_TRIPLET]  = 4,
+    [DELAY_DIV_SIXTEENTH]       = 3,
+};
+
+/// Left and right delay lines, one allocation with the right line after the
+/// left. The length is a power of two, so indices wrap with a mask and every
+/// block reads and writes each line in sequence.
+static int16_t * line_l = NULL;
+static int16_t * line_r = NULL;
+static uint32_t line_len = 0;
+static uint32_t write_idx = 0;
+
+/// Feedback low pass state of each line.
+static int32_t damp_l = 0;
+static int32_t damp_r = 0;
+
+static inline void delay_process_lines(int32_t * mix_l, int32_t * mix_r, size_t num_samples,
+                                       uint32_t delay_frames, int32_t feedback,
+                                       int32_t damp_coef, int32_t wet, bool ping_pong);
+static inline int16_t delay_saturate(int32_t sample);
+
+/// Allocate the delay lines once, as long as the memory ceiling allows, and
+/// shorter if RDRAM is short.
+void delay_init(void)
+{
+    size_t frames = DELAY_MEM_CEILING / (2 * sizeof(int16_t));
+
+    while (frames >= DELAY_MIN_FRAMES)
+    {
+        line_l = malloc(frames * 2 * sizeof(int16_t));
+        if (line_l)
+        {
+            line_r = line_l + frames;
+            line_len = frames;
+            break;
+        }
+        frames >>= 1;
+    }
+
+    delay_reset();
+
+    delay.enabled = false;
+    delay.division = DELAY_DIV_EIGHTH_DOTTED;
+    delay.feedback = 48;
+    delay.damping = 32;
+    delay.mix = 40;
+    delay.ping_pong = false;
+}
+
+bool delay_is_ready(void)
+{
+    return (NULL != line_l);
+}
+
+size_t delay_get_mem_bytes(void)
+{
+    return (size_t)line_len * 2 * sizeof(int16_t);
+}
+
+/// Silence the delay lines. Must not run while the delay is in the effects
+/// chain.
+void delay_reset(void)
+{
+    if (line_l)
+    {
+        memset(line_l, 0, delay_get_mem_bytes());
+    }
+    damp_l = 0;
+    damp_r = 0;
+}
+
+/// Return the delay time in frames for the current division and tempo.
+/// A slow tempo can ask for more than the line holds, in which case the time
+/// is held at the longest the line allows and clamped, if given, is set so
+/// the GUI can show that the delay no longer follows the tempo.
+uint32_t delay_get_frames(bool * clamped)
+{
+    uint32_t delay_frames = (tempo.samples_per_beat * delay_div_twelfths[delay.division]) / 12;
+    bool const over = (delay_frames >= line_len);
+
+    if (over)
+    {
+        delay_frames = line_len - 1;
+    }
+    else if (0 == delay_frames)
+    {
+        delay_frames = 1;
+    }
+
+    if (clamped)
+    {
+        *clamped = over;
+    }
+
+    return delay_frames;
+}
+
+/// Add the delayed signal to a block of the bus, and feed the block back
+/// into the lines. The delay time follows the tempo, read once per block.
+void delay_process(int32_t * mix_l, int32_t * mix_r, size_t num_samples)
+{
+    uint32_t const delay_frames = delay_get_frames(NULL);
+
+    int32_t const feedback = (delay.feedback * DELAY_FEEDBACK_MAX) / MIDI_MAX_DATA_BYTE;
+    int32_t const damp_coef = INT16_MAX - ((delay.damping * (INT16_MAX - DELAY_DAMP_COEF_MIN))
+                                           / MIDI_MAX_DATA_BYTE);
+    int32_t const wet = (delay.mix * INT16_MAX) / MIDI_MAX_DATA_BYTE;
+
+    if (delay.ping_pong)
+    {
+        delay_process_lines(mix_l, mix_r, num_samples, delay_frames,
+                            feedback, damp_coef, wet, true);
+    }
+    else
+    {
+        delay_process_lines(mix_l, mix_r, num_samples, delay_frames,
+                            feedback, damp_coef, wet, false);
+    }
+
+    write_idx = (write_idx + num_samples) & (line_len - 1);
+}
+
+__attribute__((always_inline))
+static inline void delay_process_lines(int32_t * mix_l, int32_t * mix_r, size_t num_samples,
+                                       uint32_t delay_frames, int32_t feedback,
+                                       int32_t damp_coef, int32_t wet, bool ping_pong)
+{
+    uint32_t const mask = line_len - 1;
+    uint32_t const read_idx = write_idx - delay_frames;
+    int32_t state_l = damp_l;
+    int32_t state_r = damp_r;
+
+    for (size_t i = 0; i < num_samples; ++i)
+    {
+        uint32_t const r_idx = (read_idx + i) & mask;
+        uint32_t const w_idx = (write_idx + i) & mask;
+
+        int32_t const out_l = line_l[r_idx];
+        int32_t const out_r = line_r[r_idx];
+
+        state_l += (((ping_pong ? out_r : out_l) - state_l) * damp_coef) >> 15;
+        state_r += (((ping_pong ? out_l : out_r) - state_r) * damp_coef) >> 15;
+
+        int32_t const in_l = ping_pong ? ((mix_l[i] + mix_r[i]) >> 1) : mix_l[i];
+        int32_t const in_r = ping_pong ? 0 : mix_r[i];
+
+        line_l[w_idx] = delay_saturate(in_l + ((state_l * feedback) >> 15));
+        line_r[w_idx] = delay_saturate(in_r + ((state_r * feedback) >> 15));
+
+        mix_l[i] += (out_l * wet) >> 15;
+        mix_r[i] += (out_r * wet) >> 15;
+    }
+
+    damp_l = state_l;
+    damp_r = state_r;
+}
+
+static inline int16_t delay_saturate(int32_t sample)
+{
+    if (sample > INT16_MAX)
+        return INT16_MAX;
+    else if (sample < INT16_MIN)
+        return INT16_MIN;
+    return (int16_t)sample;
+}
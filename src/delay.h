@@ -0,0 +1,59 @@
+#ifndef DELAY_H
+#define DELAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Ceiling on the RDRAM taken by the delay lines. Each stereo frame costs
+/// four bytes, so 256 KiB holds about 1.5 seconds.
+#define DELAY_MEM_CEILING (256 * 1024)
+
+/// Smallest line worth allocating if RDRAM is short, in frames.
+#define DELAY_MIN_FRAMES 4096
+
+/// Feedback at full amount, Q15, just short of unity so the repeats always
+/// die away.
+#define DELAY_FEEDBACK_MAX 31130
+
+/// Note values the delay time is synced to, in twelfths of a beat.
+enum delay_division_e
+{
+    DELAY_DIV_HALF,
+    DELAY_DIV_QUARTER_DOTTED,
+    DELAY_DIV_QUARTER,
+    DELAY_DIV_EIGHTH_DOTTED,
+    DELAY_DIV_QUARTER_TRIPLET,
+    DELAY_DIV_EIGHTH,
+    DELAY_DIV_EIGHTH_TRIPLET,
+    DELAY_DIV_SIXTEENTH,
+    NUM_DELAY_DIVS
+};
+
+/// Delay settings.
+/// feedback, damping and mix in [0,MIDI_MAX_DATA_BYTE]. damping darkens each
+/// repeat through a one-pole low pass in the feedback path, and mix is the
+/// level of the delayed signal sent back to the bus.
+/// ping_pong feeds the mono sum into the left line and crosses the feedback
+/// between the lines, so repeats alternate sides.
+struct delay_s
+{
+    bool enabled;
+    enum delay_division_e division;
+    uint8_t feedback;
+    uint8_t damping;
+    uint8_t mix;
+    bool ping_pong;
+};
+
+extern struct delay_s delay;
+extern uint8_t const delay_div_twelfths[NUM_DELAY_DIVS];
+
+void delay_init(void);
+bool delay_is_ready(void);
+size_t delay_get_mem_bytes(void);
+void delay_reset(void);
+uint32_t delay_get_frames(bool * clamped);
+void delay_process(int32_t * mix_l, int32_t * mix_r, size_t num_samples);
+
+#endif
@@ -0,0 +1,148 @@
+#include "dynamics.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/// Soft clipper output magnitude for each LUT segment boundary above the
+/// knee.
+int16_t dynamics_clip_lut[DYN_CLIP_LUT_SIZE];
+
+bool dynamics_clip_enabled = false;
+bool dynamics_limit_enabled = false;
+
+/// Limiter delay line, holding the last DYN_LOOKAHEAD samples while the
+/// ones before them are output. limit_delay_gain holds the gain each sample
+/// requires, the gain of the block it arrived in, so every sample waiting
+/// in the line is covered however the blocks were sized.
+static int32_t limit_delay_l[DYN_LOOKAHEAD];
+static int32_t limit_delay_r[DYN_LOOKAHEAD];
+static int32_t limit_delay_gain[DYN_LOOKAHEAD];
+static uint32_t limit_delay_idx = 0;
+
+/// Gain at the end of the last output block.
+static int32_t limit_gain = DYN_GAIN_ONE;
+
+/// Cleared while the limiter is bypassed, so the delay line is flushed of
+/// stale audio when it is enabled again.
+static bool limit_active = false;
+
+/// Generate the soft clipper LUT. Above the knee the curve is
+/// knee + (1 - knee) * tanh(over / (1 - knee)), which meets the linear
+/// region with a matching slope and approaches full scale.
+void dynamics_init(void)
+{
+    float const headroom = (float)(INT16_MAX - DYN_CLIP_KNEE);
+
+    for (size_t idx = 0; idx < DYN_CLIP_LUT_SIZE; ++idx)
+    {
+        float const over = (float)(idx << DYN_CLIP_SEG_SHIFT);
+        dynamics_clip_lut[idx] = (int16_t)lroundf(DYN_CLIP_KNEE + (headroom * tanhf(over / headroom)));
+    }
+}
+
+/// Lookahead peak limiter over a block of stereo samples, in place.
+/// The block is written into the delay line and the samples it displaces
+/// come out. The gain ramps linearly across the output block to the lowest
+/// gain required by the new block or anything still in the delay line, so
+/// it is already down when a peak leaves the line and never overshoots the
+/// ceiling, even after a short block. Recovery moves a fraction of the way
+/// back to unity each block.
+/// Returns the lowest gain applied, in Q16.
+int32_t dynamics_limit(int32_t * mix_l, int32_t * mix_r, size_t num_samples)
+{
+    if (!limit_active)
+    {
+        memset(limit_delay_l, 0, sizeof(limit_delay_l));
+        memset(limit_delay_r, 0, sizeof(limit_delay_r));
+        for (size_t idx = 0; idx < DYN_LOOKAHEAD; ++idx)
+        {
+            limit_delay_gain[idx] = DYN_GAIN_ONE;
+        }
+        limit_gain = DYN_GAIN_ONE;
+        limit_active = true;
+    }
+
+    int32_t peak = 0;
+    for (size_t i = 0; i < num_samples; ++i)
+    {
+        int32_t const sign_l = mix_l[i] >> 31;
+        int32_t const sign_r = mix_r[i] >> 31;
+        int32_t const magnitude_l = (mix_l[i] ^ sign_l) - sign_l;
+        int32_t const magnitude_r = (mix_r[i] ^ sign_r) - sign_r;
+
+        if (magnitude_l > peak)
+        {
+            peak = magnitude_l;
+        }
+        if (magnitude_r > peak)
+        {
+            peak = magnitude_r;
+        }
+    }
+
+    int32_t in_gain = DYN_GAIN_ONE;
+    if (peak > DYN_LIMIT_CEILING)
+    {
+        in_gain = (int32_t)(((int64_t)DYN_LIMIT_CEILING << DYN_GAIN_BITS) / peak);
+    }
+
+    int32_t target = in_gain;
+    for (size_t idx = 0; idx < DYN_LOOKAHEAD; ++idx)
+    {
+        if (limit_delay_gain[idx] < target)
+        {
+            target = limit_delay_gain[idx];
+        }
+    }
+
+    int32_t step;
+    if (target > limit_gain)
+    {
+        target = limit_gain + ((target - limit_gain) >> DYN_LIMIT_RELEASE_SHIFT);
+        step = (target - limit_gain) / (int32_t)num_samples;
+    }
+    else
+    {
+        // Round the attack away from zero, so the ramp reaches the target by
+        // the last sample.
+        step = -(int32_t)(((limit_gain - target) + (num_samples - 1)) / num_samples);
+    }
+
+    int32_t const min_gain = (target < limit_gain) ? target : limit_gain;
+    int32_t gain = limit_gain;
+
+    for (size_t i = 0; i < num_samples; ++i)
+    {
+        gain += step;
+        if ((step < 0) && (gain < target))
+        {
+            gain = target;
+        }
+
+        size_t const idx = (limit_delay_idx + i) & (DYN_LOOKAHEAD - 1);
+
+        int32_t const out_l = (int32_t)(((int64_t)limit_delay_l[idx] * gain) >> DYN_GAIN_BITS);
+        int32_t const out_r = (int32_t)(((int64_t)limit_delay_r[idx] * gain) >> DYN_GAIN_BITS);
+
+        limit_delay_l[idx] = mix_l[i];
+        limit_delay_r[idx] = mix_r[i];
+        limit_delay_gain[idx] = in_gain;
+
+        mix_l[i] = out_l;
+        mix_r[i] = out_r;
+    }
+
+    limit_delay_idx += num_samples;
+    limit_gain = gain;
+
+    return min_gain;
+}
+
+/// Note that the limiter was skipped for a block.
+void dynamics_limit_bypass(void)
+{
+    limit_active = false;
+}
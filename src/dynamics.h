@@ -0,0 +1,99 @@
+#ifndef DYNAMICS_H
+#define DYNAMICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Soft clipper: magnitudes up to the knee pass unchanged, and above it
+/// follow a tanh curve from the LUT toward full scale. The LUT spans
+/// 2^(DYN_CLIP_LUT_BITS + DYN_CLIP_SEG_SHIFT) above the knee, about 4.5 times
+/// full scale; anything beyond saturates.
+#define DYN_CLIP_KNEE 16384
+#define DYN_CLIP_LUT_BITS 8
+#define DYN_CLIP_SEG_SHIFT 9
+#define DYN_CLIP_LUT_SIZE ((1 << DYN_CLIP_LUT_BITS) + 1)
+#define DYN_CLIP_RANGE (1 << (DYN_CLIP_LUT_BITS + DYN_CLIP_SEG_SHIFT))
+
+/// Limiter gains are Q16, with DYN_GAIN_ONE meaning no reduction.
+#define DYN_GAIN_BITS 16
+#define DYN_GAIN_ONE (1 << DYN_GAIN_BITS)
+
+/// Lookahead of the limiter in samples, and the depth of its delay line.
+/// Must be a power of two, at least as long as a control block.
+#define DYN_LOOKAHEAD 32
+
+/// Limiter ceiling, about -0.3 dBFS.
+#define DYN_LIMIT_CEILING 31650
+
+/// Gain recovered per block after a reduction, as a shift of the distance
+/// back to unity. 5 releases over roughly 32 blocks, about 25 ms.
+#define DYN_LIMIT_RELEASE_SHIFT 5
+
+extern int16_t dynamics_clip_lut[DYN_CLIP_LUT_SIZE];
+extern bool dynamics_clip_enabled;
+extern bool dynamics_limit_enabled;
+
+void dynamics_init(void);
+int32_t dynamics_limit(int32_t * mix_l, int32_t * mix_r, size_t num_samples);
+void dynamics_limit_bypass(void);
+
+/// Return a sample passed through the soft clipper.
+static inline int32_t dynamics_clip_sample(int32_t sample)
+{
+    int32_t const sign = sample >> 31;
+    int32_t magnitude = (sample ^ sign) - sign;
+
+    if (magnitude <= DYN_CLIP_KNEE)
+    {
+        return sample;
+    }
+
+    uint32_t const over = (uint32_t)(magnitude - DYN_CLIP_KNEE);
+    if (over >= DYN_CLIP_RANGE)
+    {
+        magnitude = dynamics_clip_lut[DYN_CLIP_LUT_SIZE - 1];
+    }
+    else
+    {
+        size_t const idx = over >> DYN_CLIP_SEG_SHIFT;
+        int32_t const frac = (int32_t)(over & ((1 << DYN_CLIP_SEG_SHIFT) - 1));
+        int32_t const y0 = dynamics_clip_lut[idx];
+        int32_t const y1 = dynamics_clip_lut[idx + 1];
+        magnitude = y0 + (((y1 - y0) * frac) >> DYN_CLIP_SEG_SHIFT);
+    }
+
+    return (magnitude ^ sign) - sign;
+}
+
+/// Soft clip a block of stereo samples in place.
+/// Returns the largest input magnitude, from which the deepest gain reduction
+/// of the block follows since the curve is monotonic.
+static inline int32_t dynamics_clip(int32_t * mix_l, int32_t * mix_r, size_t num_samples)
+{
+    int32_t peak = 0;
+
+    for (size_t i = 0; i < num_samples; ++i)
+    {
+        int32_t const sign_l = mix_l[i] >> 31;
+        int32_t const sign_r = mix_r[i] >> 31;
+        int32_t const magnitude_l = (mix_l[i] ^ sign_l) - sign_l;
+        int32_t const magnitude_r = (mix_r[i] ^ sign_r) - sign_r;
+
+        if (magnitude_l > peak)
+        {
+            peak = magnitude_l;
+        }
+        if (magnitude_r > peak)
+        {
+            peak = magnitude_r;
+        }
+
+        mix_l[i] = dynamics_clip_sample(mix_l[i]);
+        mix_r[i] = dynamics_clip_sample(mix_r[i]);
+    }
+
+    return peak;
+}
+
+#endif
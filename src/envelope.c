@@ -3,10 +3,25 @@
 #include <math.h>
 #include "audio_engine.h"
 
+/// Shortest segment in samples, so a segment's rate always fits in 32 bits.
+#define ENV_MIN_SAMPLES 2
+
+/// Steepness of the EXP and LOG curves. The curve covers this many time
+/// constants, about 43 dB of an exponential's fall, and is rescaled to land
+/// exactly on the target.
+#define ENV_CURVE_STEEPNESS 5.0f
+
 uint64_t env_sample_lut[MIDI_MAX_NRPN_VAL + 1] = {0};
 struct envelope_s envelopes[NUM_ENVELOPES];
 
+/// Shapes of the curved segments, indexed by curve less one, as linear
+/// segments need no table.
+static uint16_t env_curve_lut[NUM_ENV_CURVES - 1][(1 << ENV_CURVE_LUT_BITS) + 1];
+
 static void init_env_sample_lut(float t_min, float t_max);
+static void init_env_curve_lut(void);
+static void envelope_start_segment(struct envelope_state_s * env_state, uint8_t idx, uint8_t seg);
+static void envelope_hold(struct envelope_state_s * env_state);
 
 static void init_env_sample_lut(float t_min, float t_max)
 {
@@ -17,55 +32,278 @@ static void init_env_sample_lut(float t_min, float t_max)
     }
 }
 
+static void init_env_curve_lut(void)
+{
+    float const exp_norm = 1.0f - expf(-ENV_CURVE_STEEPNESS);
+
+    for (size_t step = 0; step <= (1 << ENV_CURVE_LUT_BITS); ++step)
+    {
+        float const x = (float)step / (1 << ENV_CURVE_LUT_BITS);
+        float const exp_x = (1.0f - expf(-ENV_CURVE_STEEPNESS * x)) / exp_norm;
+        float const log_x = 1.0f - ((1.0f - expf(-ENV_CURVE_STEEPNESS * (1.0f - x))) / exp_norm);
+        float const s_x = 0.5f - (0.5f * cosf((float)M_PI * x));
+
+        env_curve_lut[ENV_CURVE_EXP - 1][step] = (uint16_t)lroundf(exp_x * ENV_CURVE_ONE);
+        env_curve_lut[ENV_CURVE_LOG - 1][step] = (uint16_t)lroundf(log_x * ENV_CURVE_ONE);
+        env_curve_lut[ENV_CURVE_S - 1][step] = (uint16_t)lroundf(s_x * ENV_CURVE_ONE);
+    }
+}
+
+/// Every envelope starts as a linear ADSR: attack to full, decay to the
+/// sustain level, then release to silence after note off.
 void envelope_init(void)
 {
     init_env_sample_lut(0.001f, 10.0f);
+    init_env_curve_lut();
 
     for (size_t env_idx = 0; env_idx < NUM_ENVELOPES; ++env_idx)
     {
-        envelopes[env_idx].attack = MIDI_MAX_NRPN_VAL / 2;
-        envelopes[env_idx].decay = MIDI_MAX_NRPN_VAL;
-        envelopes[env_idx].sustain_level = UINT32_MAX / 2;
-        envelopes[env_idx].release = MIDI_MAX_NRPN_VAL / 2;
+        envelopes[env_idx].num_segments = 3;
+        envelopes[env_idx].sustain = 2;
+        envelopes[env_idx].loop = ENV_NO_LOOP;
+
+        for (size_t seg = 0; seg < ENV_MAX_SEGMENTS; ++seg)
+        {
+            envelope_set_target(env_idx, seg, 0);
+            envelope_set_time(env_idx, seg, MIDI_MAX_NRPN_VAL / 2);
+            envelope_set_curve(env_idx, seg, ENV_CURVE_LINEAR);
+        }
+
+        envelope_set_target(env_idx, 0, UINT32_MAX);
+        envelope_set_attack(env_idx, MIDI_MAX_NRPN_VAL / 2);
+        envelope_set_decay(env_idx, MIDI_MAX_NRPN_VAL);
+        envelope_set_sustain(env_idx, UINT32_MAX / 2);
+        envelope_set_release(env_idx, MIDI_MAX_NRPN_VAL / 2);
     }
 }
 
+/// The ADSR setters address an envelope by its sustain point: attack is the
+/// first segment, decay the last before the sustain point and sets its
+/// level, and release the first after it.
 void envelope_set_attack(uint8_t idx, uint16_t data)
 {
-    envelopes[idx].attack = data;
+    envelope_set_time(idx, 0, data);
 }
 
 void envelope_set_decay(uint8_t idx, uint16_t data)
 {
-    envelopes[idx].decay = data;
+    envelope_set_time(idx, envelopes[idx].sustain - 1, data);
 }
 
 void envelope_set_sustain(uint8_t idx, uint32_t data)
 {
-    envelopes[idx].sustain_level = data;
+    envelope_set_target(idx, envelopes[idx].sustain - 1, data);
 }
 
 void envelope_set_release(uint8_t idx, uint16_t data)
 {
-    envelopes[idx].release = data;
+    if (envelopes[idx].sustain < envelopes[idx].num_segments)
+    {
+        envelope_set_time(idx, envelopes[idx].sustain, data);
+    }
 }
 
-uint64_t envelope_get_trans_samples(uint8_t idx, enum envelope_stage_e stage)
+void envelope_set_time(uint8_t idx, uint8_t seg, uint16_t time)
 {
-    uint64_t num_samples = 0;
-    switch (stage)
+    struct envelope_segment_s * segment = &envelopes[idx].segments[seg];
+    uint32_t samples = (uint32_t)env_sample_lut[time];
+    if (samples < ENV_MIN_SAMPLES)
     {
-        case ATTACK:
-            num_samples = env_sample_lut[envelopes[idx].attack];
-            break;
-        case DECAY:
-            num_samples = env_sample_lut[envelopes[idx].decay];
+        samples = ENV_MIN_SAMPLES;
+    }
+
+    segment->time = time;
+    segment->samples = samples;
+    segment->pos_inc = (uint32_t)((1ull << 32) / samples);
+}
+
+void envelope_set_target(uint8_t idx, uint8_t seg, uint32_t target)
+{
+    envelopes[idx].segments[seg].target = target;
+}
+
+void envelope_set_curve(uint8_t idx, uint8_t seg, enum envelope_curve_e curve)
+{
+    struct envelope_segment_s * segment = &envelopes[idx].segments[seg];
+
+    if (NUM_ENV_CURVES <= curve)
+    {
+        return;
+    }
+
+    segment->curve = curve;
+    segment->shape = (ENV_CURVE_LINEAR == curve) ? NULL : env_curve_lut[curve - 1];
+}
+
+/// Change the number of segments, keeping the sustain point and loop inside
+/// the table.
+void envelope_set_num_segments(uint8_t idx, uint8_t num_segments)
+{
+    struct envelope_s * env = &envelopes[idx];
+
+    if ((0 == num_segments) || (ENV_MAX_SEGMENTS < num_segments))
+    {
+        return;
+    }
+
+    env->num_segments = num_segments;
+    if (env->sustain > num_segments)
+    {
+        envelope_set_sustain_point(idx, num_segments);
+    }
+}
+
+void envelope_set_sustain_point(uint8_t idx, uint8_t sustain)
+{
+    struct envelope_s * env = &envelopes[idx];
+
+    if ((0 == sustain) || (env->num_segments < sustain))
+    {
+        return;
+    }
+
+    env->sustain = sustain;
+    if ((ENV_NO_LOOP != env->loop) && (env->loop >= sustain))
+    {
+        env->loop = ENV_NO_LOOP;
+    }
+}
+
+void envelope_set_loop(uint8_t idx, uint8_t loop)
+{
+    struct envelope_s * env = &envelopes[idx];
+
+    if ((ENV_NO_LOOP == loop) || (loop < env->sustain))
+    {
+        env->loop = loop;
+    }
+}
+
+void envelope_reset(struct envelope_state_s * env_state)
+{
+    env_state->stage = IDLE;
+    env_state->seg = 0;
+    env_state->level = 0u;
+    envelope_hold(env_state);
+}
+
+/// Start the held part of an envelope at note on, from its current level.
+void envelope_trigger(struct envelope_state_s * env_state, uint8_t idx)
+{
+    env_state->stage = HELD;
+    envelope_start_segment(env_state, idx, 0);
+}
+
+/// Start the release part of an envelope at note off, from its current
+/// level. An envelope with no release segments goes straight to idle.
+void envelope_release(struct envelope_state_s * env_state, uint8_t idx)
+{
+    if (IDLE == env_state->stage)
+    {
+        return;
+    }
+
+    if (envelopes[idx].sustain < envelopes[idx].num_segments)
+    {
+        env_state->stage = RELEASE;
+        envelope_start_segment(env_state, idx, envelopes[idx].sustain);
+    }
+    else
+    {
+        envelope_reset(env_state);
+    }
+}
+
+/// Ramp an envelope linearly to silence over the given number of samples, and
+/// go idle, whatever its segments would have done. The fade runs as the last
+/// release segment, so the envelope counts as on its way out.
+void envelope_fade(struct envelope_state_s * env_state, uint8_t idx, uint32_t samples)
+{
+    if (IDLE == env_state->stage)
+    {
+        return;
+    }
+
+    env_state->stage = RELEASE;
+    env_state->seg = envelopes[idx].num_segments - 1;
+    env_state->shape = NULL;
+    env_state->rate = -(int32_t)(env_state->level / samples);
+    env_state->remaining = samples;
+}
+
+/// Finish the current segment and start the next, loop or hold at the end
+/// of the held part, or go idle at the end of the release. Called from
+/// envelope_tick() when a segment's count runs out. The table may have been
+/// edited since the segment started, so the index is checked against it.
+void envelope_next_segment(struct envelope_state_s * env_state, uint8_t idx)
+{
+    struct envelope_s const * env = &envelopes[idx];
+    uint8_t const next = env_state->seg + 1;
+
+    switch (env_state->stage)
+    {
+        case HELD:
+            env_state->level = env->segments[env_state->seg].target;
+            if (next < env->sustain)
+            {
+                envelope_start_segment(env_state, idx, next);
+            }
+            else if (ENV_NO_LOOP != env->loop)
+            {
+                envelope_start_segment(env_state, idx, env->loop);
+            }
+            else
+            {
+                envelope_hold(env_state);
+            }
             break;
         case RELEASE:
-            num_samples = env_sample_lut[envelopes[idx].release];
+            env_state->level = env->segments[env_state->seg].target;
+            if (next < env->num_segments)
+            {
+                envelope_start_segment(env_state, idx, next);
+            }
+            else
+            {
+                envelope_reset(env_state);
+            }
             break;
+        case IDLE:
         default:
+            envelope_hold(env_state);
             break;
     }
-    return num_samples;
+}
+
+/// Load a segment from the current level. A linear segment derives the rate
+/// that takes the level to its target over its length, the one division per
+/// segment; a curved one scales its shape by the distance to travel.
+static void envelope_start_segment(struct envelope_state_s * env_state, uint8_t idx, uint8_t seg)
+{
+    struct envelope_segment_s const * segment = &envelopes[idx].segments[seg];
+    int64_t const delta = (int64_t)segment->target - env_state->level;
+
+    env_state->seg = seg;
+    env_state->remaining = segment->samples;
+    env_state->shape = segment->shape;
+
+    if (NULL == segment->shape)
+    {
+        env_state->rate = (int32_t)(delta / (int64_t)segment->samples);
+    }
+    else
+    {
+        env_state->start = env_state->level;
+        env_state->delta = delta;
+        env_state->pos = 0u;
+        env_state->pos_inc = segment->pos_inc;
+    }
+}
+
+/// Keep the level where it is until the next note event.
+static void envelope_hold(struct envelope_state_s * env_state)
+{
+    env_state->shape = NULL;
+    env_state->rate = 0;
+    env_state->remaining = UINT32_MAX;
 }
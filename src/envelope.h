@@ -2,37 +2,94 @@
 #define ENVELOPE_H
 
 #include <midi64.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #define NUM_ENVELOPES 3
 
-/// Enum representing each envelope stage.
+/// Most segments an envelope can hold, held and release parts together.
+#define ENV_MAX_SEGMENTS 8
+
+/// Envelope loop value meaning the held part does not loop.
+#define ENV_NO_LOOP UINT8_MAX
+
+/// Curve shapes are tables of 2^ENV_CURVE_LUT_BITS steps plus a guard entry,
+/// holding the fraction of a segment's travel done in [0,ENV_CURVE_ONE].
+#define ENV_CURVE_LUT_BITS 8
+#define ENV_CURVE_BITS 15
+#define ENV_CURVE_ONE (1 << ENV_CURVE_BITS)
+
+/// Enum representing the shape of a segment between its start and target.
+/// EXP moves fast then settles, like an RC charge or an exponential decay.
+/// LOG starts slow and ends fast. S eases in and out.
+enum envelope_curve_e {
+    ENV_CURVE_LINEAR,
+    ENV_CURVE_EXP,
+    ENV_CURVE_LOG,
+    ENV_CURVE_S,
+    NUM_ENV_CURVES
+};
+
+/// Enum representing where an envelope is in its note.
+/// HELD runs the segments before the sustain point, then loops or holds.
+/// RELEASE runs the segments from the sustain point to the end, then the
+/// envelope goes IDLE.
 enum envelope_stage_e {
     IDLE,
-    ATTACK,
-    DECAY,
-    SUSTAIN,
+    HELD,
     RELEASE,
     NUM_ENVELOPE_STAGES
 };
 
-/// Struct containing the envelope settings.
-/// Sustain is represented as an absolute level between [0,UINT32_MAX].
-/// Attack, decay, and release are represented as 14 bit numbers and can be set
-/// between [0,MIDI_MAX_NRPN_VAL].
+/// One segment of an envelope, which moves from wherever the envelope is to
+/// target over time, following curve.
+/// target is an absolute level between [0,UINT32_MAX]. time is a 14 bit
+/// number between [0,MIDI_MAX_NRPN_VAL], and samples is its length in
+/// samples. samples, the curve position increment pos_inc and the curve's
+/// table shape are precomputed when the segment is set; shape is NULL for a
+/// linear segment.
+struct envelope_segment_s
+{
+    uint32_t target;
+    uint16_t time;
+    enum envelope_curve_e curve;
+    uint32_t samples;
+    uint32_t pos_inc;
+    uint16_t const * shape;
+};
+
+/// Struct containing the envelope settings, a table of num_segments segments.
+/// Segments [0,sustain) run from note on. At the end of them the envelope
+/// jumps back to segment loop, or holds its level if loop is ENV_NO_LOOP.
+/// Note off runs segments [sustain,num_segments) from the current level.
+/// sustain is at least one and at most num_segments, and loop is before
+/// sustain.
 struct envelope_s
 {
-    uint16_t attack;
-    uint16_t decay;
-    uint32_t sustain_level;
-    uint16_t release;
+    struct envelope_segment_s segments[ENV_MAX_SEGMENTS];
+    uint8_t num_segments;
+    uint8_t sustain;
+    uint8_t loop;
 };
 
+/// Per-note state of an envelope. remaining counts down the samples left in
+/// segment seg. On a linear segment rate is added to level every sample. On
+/// a curved one pos walks shape by pos_inc every sample, and level is start
+/// plus delta scaled by the shape.
+/// A held or idle envelope is linear with a rate of zero, and never expires
+/// in practice.
 struct envelope_state_s
 {
     enum envelope_stage_e stage;
+    uint8_t seg;
     uint32_t level;
-    uint64_t rate;
+    int32_t rate;
+    uint32_t remaining;
+    uint16_t const * shape;
+    uint32_t start;
+    int64_t delta;
+    uint32_t pos;
+    uint32_t pos_inc;
 };
 
 extern uint64_t env_sample_lut[MIDI_MAX_NRPN_VAL + 1];
@@ -44,63 +101,58 @@ void envelope_set_decay(uint8_t idx, uint16_t data);
 void envelope_set_sustain(uint8_t idx, uint32_t data);
 void envelope_set_release(uint8_t idx, uint16_t data);
 
-uint64_t envelope_get_trans_samples(uint8_t idx, enum envelope_stage_e stage);
+void envelope_set_time(uint8_t idx, uint8_t seg, uint16_t time);
+void envelope_set_target(uint8_t idx, uint8_t seg, uint32_t target);
+void envelope_set_curve(uint8_t idx, uint8_t seg, enum envelope_curve_e curve);
+void envelope_set_num_segments(uint8_t idx, uint8_t num_segments);
+void envelope_set_sustain_point(uint8_t idx, uint8_t sustain);
+void envelope_set_loop(uint8_t idx, uint8_t loop);
 
+void envelope_reset(struct envelope_state_s * env_state);
+void envelope_trigger(struct envelope_state_s * env_state, uint8_t idx);
+void envelope_release(struct envelope_state_s * env_state, uint8_t idx);
+void envelope_fade(struct envelope_state_s * env_state, uint8_t idx, uint32_t samples);
+void envelope_next_segment(struct envelope_state_s * env_state, uint8_t idx);
+
+/// Look up the fraction of travel at a curve position, interpolating
+/// between table steps so long segments do not step audibly.
+static inline uint32_t envelope_curve_lookup(uint16_t const * shape, uint32_t pos)
+{
+    uint32_t const step = pos >> (32 - ENV_CURVE_LUT_BITS);
+    int32_t const frac = (pos >> (16 - ENV_CURVE_LUT_BITS)) & 0xFFFF;
+    int32_t const a = shape[step];
+    int32_t const b = shape[step + 1];
+
+    return (uint32_t)(a + (((b - a) * frac) >> 16));
+}
+
+/// Tick the envelope by the given number of ticks. Within a linear segment
+/// this is one add and one decrement, and a curved one adds a table lookup
+/// and two multiplies; the segment table is only consulted when the
+/// segment's count runs out.
+/// The rate is applied modulo 2^32, which is exact as a segment never takes
+/// the level outside of its range.
 static inline void envelope_tick(struct envelope_state_s * env_state, uint8_t idx, size_t ticks)
 {
-    switch (env_state->stage)
+    while (ticks >= env_state->remaining)
+    {
+        ticks -= env_state->remaining;
+        envelope_next_segment(env_state, idx);
+    }
+
+    env_state->remaining -= ticks;
+
+    if (NULL == env_state->shape)
+    {
+        env_state->level += (uint32_t)env_state->rate * ticks;
+    }
+    else
     {
-        case IDLE:
-            break;
-        case ATTACK:
-            if (UINT32_MAX > env_state->level)
-            {
-                if ((UINT32_MAX - env_state->level) <= (ticks * env_state->rate))
-                {
-                    env_state->level = UINT32_MAX;
-                    env_state->stage = DECAY;
-                    env_state->rate = (UINT32_MAX - envelopes[idx].sustain_level) / env_sample_lut[envelopes[idx].decay];
-                }
-                else
-                {
-                    env_state->level += (ticks * env_state->rate);
-                }
-            }
-            break;
-        case DECAY:
-            if (envelopes[idx].sustain_level < env_state->level)
-            {
-                if ((env_state->level - envelopes[idx].sustain_level)
-                    <= (ticks * env_state->rate))
-                {
-                    env_state->level = envelopes[idx].sustain_level;
-                    env_state->stage = SUSTAIN;
-                }
-                else
-                {
-                    env_state->level -= (ticks * env_state->rate);
-                }
-            }
-            break;
-        case SUSTAIN:
-            break;
-        case RELEASE:
-            if (0 < env_state->level)
-            {
-                if ((env_state->level) <= (ticks * env_state->rate))
-                {
-                    env_state->level = 0;
-                    env_state->stage = IDLE;
-                }
-                else
-                {
-                    env_state->level -= (ticks * env_state->rate);
-                }
-            }
-            break;
-        case NUM_ENVELOPE_STAGES:
-        default:
-            break;
+        env_state->pos += env_state->pos_inc * ticks;
+        env_state->level = (uint32_t)(env_state->start
+                                      + ((env_state->delta
+                                          * envelope_curve_lookup(env_state->shape, env_state->pos))
+                                         >> ENV_CURVE_BITS));
     }
 }
 
@@ -0,0 +1,57 @@
+#include "filter.h"
+
+#include "audio_engine.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FILTER_CUTOFF_MAX_RATIO 0.45f
+
+/// Q of the filter at full resonance is 2^FILTER_RESONANCE_OCTAVES times the
+/// Butterworth Q.
+#define FILTER_RESONANCE_OCTAVES 4.0f
+
+struct filter_s filter;
+
+/// Prewarped integrator gain tan(pi * fc / fs) for each semitone of cutoff.
+int32_t filter_g_lut[FILTER_LUT_SIZE];
+
+void filter_init(void)
+{
+    for (size_t pitch = 0; pitch < FILTER_LUT_SIZE; ++pitch)
+    {
+        float freq = filter_get_cutoff_hz(pitch);
+        if (freq > (FILTER_CUTOFF_MAX_RATIO * SAMPLE_RATE))
+        {
+            freq = FILTER_CUTOFF_MAX_RATIO * SAMPLE_RATE;
+        }
+        filter_g_lut[pitch] = (int32_t)lroundf(tanf((float)M_PI * freq / SAMPLE_RATE)
+                                               * FILTER_COEF_ONE);
+    }
+
+    filter.mode = FILTER_OFF;
+    filter.cutoff = FILTER_PITCH_MAX;
+    filter.env_idx = 0;
+    filter.env_amt = 0;
+    filter.key_track = 0;
+    filter_set_resonance(0);
+}
+
+/// Set the resonance and derive the damping 1/Q from it. Q rises
+/// exponentially from the Butterworth 1/sqrt(2), so the control feels even
+/// across its range.
+void filter_set_resonance(uint8_t resonance)
+{
+    filter.resonance = resonance;
+
+    float const q = (float)M_SQRT1_2
+                    * exp2f((FILTER_RESONANCE_OCTAVES * resonance) / MIDI_MAX_DATA_BYTE);
+    filter.damping = (int32_t)lroundf(FILTER_COEF_ONE / q);
+}
+
+/// Return the cutoff frequency of a pitch in semitones.
+float filter_get_cutoff_hz(uint8_t cutoff)
+{
+    return 440.0f * exp2f(((float)cutoff - 69) / 12);
+}
@@ -0,0 +1,171 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <midi64.h>
+
+/// Highest cutoff in semitones, as a MIDI note. Just under 0.45 times the
+/// sample rate, where the prewarped coefficient is still well conditioned.
+#define FILTER_PITCH_MAX 134
+#define FILTER_LUT_SIZE (FILTER_PITCH_MAX + 1)
+
+/// Cutoff pitches are Q8 semitones.
+#define FILTER_PITCH_FRAC_BITS 8
+
+/// Filter coefficients are Q24.
+#define FILTER_COEF_BITS 24
+#define FILTER_COEF_ONE (1 << FILTER_COEF_BITS)
+
+/// Cutoff sweep in semitones of an envelope at full amount.
+#define FILTER_ENV_RANGE 96
+
+enum filter_mode_e
+{
+    FILTER_OFF,
+    FILTER_LP,
+    FILTER_BP,
+    FILTER_HP,
+    NUM_FILTER_MODES
+};
+
+/// Filter settings shared by every voice.
+/// cutoff is a MIDI note in [0,FILTER_PITCH_MAX].
+/// resonance in [0,MIDI_MAX_DATA_BYTE], from a flat Butterworth response to a
+/// Q of about 11.
+/// env_amt in [-MIDI_MAX_DATA_BYTE,MIDI_MAX_DATA_BYTE] scales the cutoff
+/// sweep of envelope env_idx.
+/// key_track in [0,MIDI_MAX_DATA_BYTE], where full tracking moves the cutoff
+/// a semitone per semitone away from middle C.
+/// damping is derived from resonance by filter_set_resonance().
+struct filter_s
+{
+    enum filter_mode_e mode;
+    uint8_t cutoff;
+    uint8_t resonance;
+    uint8_t env_idx;
+    int8_t env_amt;
+    uint8_t key_track;
+    int32_t damping;
+};
+
+/// Coefficients of a voice's filter for one control block, Q24.
+struct filter_coefs_s
+{
+    int32_t g;
+    int32_t g_damped;
+    int32_t norm;
+    int32_t damping;
+};
+
+/// Integrator state of one channel of a voice's filter.
+struct filter_state_s
+{
+    int32_t s1;
+    int32_t s2;
+};
+
+extern struct filter_s filter;
+extern int32_t filter_g_lut[FILTER_LUT_SIZE];
+
+void filter_init(void);
+void filter_set_resonance(uint8_t resonance);
+float filter_get_cutoff_hz(uint8_t cutoff);
+
+/// Return the cutoff pitch of a voice playing the given note with its filter
+/// envelope at the given level, offset by pitch_mod in Q8 semitones, in Q8
+/// semitones clamped to the table.
+static inline int32_t filter_get_pitch(uint8_t note, uint32_t env_level, int32_t pitch_mod)
+{
+    int32_t pitch = ((int32_t)filter.cutoff << FILTER_PITCH_FRAC_BITS) + pitch_mod;
+
+    pitch += ((((int32_t)note - 60) << FILTER_PITCH_FRAC_BITS) * filter.key_track)
+             / MIDI_MAX_DATA_BYTE;
+    pitch += (((int32_t)(env_level >> 16) * filter.env_amt * FILTER_ENV_RANGE)
+              / MIDI_MAX_DATA_BYTE) >> (16 - FILTER_PITCH_FRAC_BITS);
+
+    if (pitch < 0)
+    {
+        pitch = 0;
+    }
+    else if (pitch > (FILTER_PITCH_MAX << FILTER_PITCH_FRAC_BITS))
+    {
+        pitch = FILTER_PITCH_MAX << FILTER_PITCH_FRAC_BITS;
+    }
+
+    return pitch;
+}
+
+/// Derive the coefficients for a cutoff pitch. The prewarped gain is
+/// interpolated from the semitone table, and the normalisation costs one
+/// division, made once per voice per control block.
+static inline void filter_get_coefs(int32_t pitch, struct filter_coefs_s * coefs)
+{
+    size_t const idx = pitch >> FILTER_PITCH_FRAC_BITS;
+    int32_t g = filter_g_lut[idx];
+
+    if (idx < FILTER_PITCH_MAX)
+    {
+        int32_t const frac = pitch & ((1 << FILTER_PITCH_FRAC_BITS) - 1);
+        g += (int32_t)(((int64_t)(filter_g_lut[idx + 1] - g) * frac) >> FILTER_PITCH_FRAC_BITS);
+    }
+
+    int32_t const damping = filter.damping;
+    int64_t const denom = (int64_t)FILTER_COEF_ONE
+                          + (((int64_t)damping * g) >> FILTER_COEF_BITS)
+                          + (((int64_t)g * g) >> FILTER_COEF_BITS);
+
+    coefs->g = g;
+    coefs->g_damped = g + damping;
+    coefs->norm = (int32_t)(((int64_t)1 << (2 * FILTER_COEF_BITS)) / denom);
+    coefs->damping = damping;
+}
+
+/// Filter one channel of a block in place. A topology-preserving state
+/// variable filter: unlike the Chamberlin form it stays stable and keeps its
+/// tuning all the way up the table.
+__attribute__((always_inline))
+static inline void filter_process(struct filter_state_s * state,
+                                  struct filter_coefs_s const * coefs,
+                                  int32_t * buf, size_t num_samples,
+                                  enum filter_mode_e mode)
+{
+    int32_t s1 = state->s1;
+    int32_t s2 = state->s2;
+
+    for (size_t i = 0; i < num_samples; ++i)
+    {
+        int32_t const x = buf[i];
+
+        int32_t const hp = (int32_t)(((int64_t)(x - (int32_t)(((int64_t)coefs->g_damped * s1)
+                                                               >> FILTER_COEF_BITS) - s2)
+                                      * coefs->norm) >> FILTER_COEF_BITS);
+        int32_t const v1 = (int32_t)(((int64_t)coefs->g * hp) >> FILTER_COEF_BITS);
+        int32_t const bp = v1 + s1;
+        s1 = bp + v1;
+        int32_t const v2 = (int32_t)(((int64_t)coefs->g * bp) >> FILTER_COEF_BITS);
+        int32_t const lp = v2 + s2;
+        s2 = lp + v2;
+
+        switch (mode)
+        {
+            case FILTER_HP:
+                buf[i] = hp;
+                break;
+            case FILTER_BP:
+                // Scaled by the damping for unity gain at the peak.
+                buf[i] = (int32_t)(((int64_t)coefs->damping * bp) >> FILTER_COEF_BITS);
+                break;
+            case FILTER_LP:
+            default:
+                buf[i] = lp;
+                break;
+        }
+    }
+
+    state->s1 = s1;
+    state->s2 = s2;
+}
+
+#endif
@@ -0,0 +1,73 @@
+#include "fx.h"
+
+#include "chorus.h"
+#include "delay.h"
+#include "reverb.h"
+
+#include <libdragon.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+struct fx_stage_s fx_chain[NUM_FX];
+size_t fx_chain_len = 0;
+
+/// Effects in the current chain, so one coming back in is cleared first.
+static bool fx_active[NUM_FX] = {0};
+
+/// Allocate the effects' memory. Called once at init, before audio starts.
+void fx_init(void)
+{
+    chorus_init();
+    delay_init();
+    reverb_init();
+}
+
+/// Rebuild the chain from the effects' enable switches. An effect joining
+/// the chain has its state cleared while the audio callback cannot reach it,
+/// so it starts silent rather than replaying what it held when bypassed.
+void fx_update(void)
+{
+    struct fx_stage_s chain[NUM_FX];
+    bool active[NUM_FX] = {0};
+    size_t chain_len = 0;
+
+    if (chorus.enabled)
+    {
+        if (!fx_active[FX_CHORUS])
+        {
+            chorus_reset();
+        }
+        active[FX_CHORUS] = true;
+        chain[chain_len++] = (struct fx_stage_s){ .fx = FX_CHORUS, .process = chorus_process };
+    }
+
+    if (delay.enabled && delay_is_ready())
+    {
+        if (!fx_active[FX_DELAY])
+        {
+            delay_reset();
+        }
+        active[FX_DELAY] = true;
+        chain[chain_len++] = (struct fx_stage_s){ .fx = FX_DELAY, .process = delay_process };
+    }
+
+    if (reverb.enabled && reverb_is_ready())
+    {
+        if (!fx_active[FX_REVERB])
+        {
+            reverb_reset();
+        }
+        active[FX_REVERB] = true;
+        chain[chain_len++] = (struct fx_stage_s){ .fx = FX_REVERB, .process = reverb_process };
+    }
+
+    disable_interrupts();
+    memcpy(fx_chain, chain, chain_len * sizeof(struct fx_stage_s));
+    fx_chain_len = chain_len;
+    enable_interrupts();
+
+    memcpy(fx_active, active, sizeof(fx_active));
+}
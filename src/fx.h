@@ -0,0 +1,33 @@
+#ifndef FX_H
+#define FX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Effects on the bus, in the order they process it.
+enum fx_e
+{
+    FX_CHORUS,
+    FX_DELAY,
+    FX_REVERB,
+    NUM_FX
+};
+
+typedef void (*fx_process_fn)(int32_t * mix_l, int32_t * mix_r, size_t num_samples);
+
+struct fx_stage_s
+{
+    enum fx_e fx;
+    fx_process_fn process;
+};
+
+/// Enabled effects, rebuilt by fx_update() whenever one is switched, so a
+/// bypassed effect is not in the render path at all. Only read by the audio
+/// callback.
+extern struct fx_stage_s fx_chain[NUM_FX];
+extern size_t fx_chain_len;
+
+void fx_init(void);
+void fx_update(void);
+
+#endif
@@ -2,9 +2,21 @@
 
 #include "init.h"
 #include "audio_engine.h"
+#include "chorus.h"
+#include "delay.h"
+#include "dynamics.h"
 #include "envelope.h"
+#include "filter.h"
+#include "fx.h"
 #include "lfo.h"
+#include "mod_matrix.h"
+#include "meter.h"
+#include "reverb.h"
+#include "scope.h"
+#include "spectrum.h"
+#include "tempo.h"
 #include "voice.h"
+#include "wav_import.h"
 #include "wavetable.h"
 
 #include <libdragon.h>
@@ -13,12 +25,16 @@
 #include <rdpq_rect.h>
 #include <rdpq_text.h>
 
+#include <math.h>
 #include <stddef.h>
+#include <stdio.h>
 
 enum menu_screen_e
 {
     SCREEN_OSC_ENV,
     SCREEN_LFO,
+    SCREEN_FILTER,
+    SCREEN_FX,
     SCREEN_FILE,
     SCREEN_DEBUG,
     SCREEN_SETTINGS
@@ -35,6 +51,21 @@ enum main_sel_e
 
     SEL_LFO_1,
     SEL_LFO_2,
+    SEL_MOD_MATRIX,
+
+    SEL_FILTER,
+
+    SEL_FX_CHORUS,
+    SEL_FX_DELAY,
+    SEL_FX_REVERB,
+
+    SEL_FILE_LIST,
+
+    SEL_SETTINGS_HARMONICS,
+    SEL_SETTINGS_VOICE_PAN,
+    SEL_SETTINGS_VOICE_CULL,
+    SEL_SETTINGS_SOFT_CLIP,
+    SEL_SETTINGS_LIMITER,
 };
 
 enum osc_subsel_e
@@ -42,14 +73,38 @@ enum osc_subsel_e
     OSC_SUBSEL_SHAPE,
     OSC_SUBSEL_AMP_ENV,
     OSC_SUBSEL_GAIN,
+    OSC_SUBSEL_POSITION,
+    OSC_SUBSEL_POS_ENV,
+    OSC_SUBSEL_INTERP,
+    OSC_SUBSEL_DIRECT,
+    OSC_SUBSEL_COARSE,
+    OSC_SUBSEL_FINE,
+    OSC_SUBSEL_PHASE,
+    OSC_SUBSEL_PAN,
+    OSC_SUBSEL_UNISON,
+    OSC_SUBSEL_UNISON_DETUNE,
+    OSC_SUBSEL_UNISON_SPREAD,
 };
 
+/// Fields of an envelope box. SEG picks the segment the next three edit.
 enum env_subsel_e
 {
-    ENV_SUBSEL_A,
-    ENV_SUBSEL_D,
-    ENV_SUBSEL_S,
-    ENV_SUBSEL_R,
+    ENV_SUBSEL_SEG,
+    ENV_SUBSEL_TIME,
+    ENV_SUBSEL_LEVEL,
+    ENV_SUBSEL_CURVE,
+    ENV_SUBSEL_POINT,
+    ENV_SUBSEL_NUM,
+    NUM_ENV_SUBSELS
+};
+
+enum debug_page_e
+{
+    DEBUG_PAGE_PROFILE,
+    DEBUG_PAGE_UNISON,
+    DEBUG_PAGE_FX,
+    DEBUG_PAGE_BOOT,
+    NUM_DEBUG_PAGES
 };
 
 enum lfo_subsel_e
@@ -57,8 +112,60 @@ enum lfo_subsel_e
     LFO_SUBSEL_SHAPE,
     LFO_SUBSEL_RATE,
     LFO_SUBSEL_DEPTH,
-    LFO_SUBSEL_DST_AMP,
-    LFO_SUBSEL_DST_PITCH,
+    LFO_SUBSEL_SYNC,
+    LFO_SUBSEL_DIRECT,
+};
+
+/// Columns of a mod matrix slot. The matrix subsel walks the cells slot by
+/// slot, NUM_MOD_COLS to a slot.
+enum mod_col_e
+{
+    MOD_COL_SRC,
+    MOD_COL_DST,
+    MOD_COL_DEPTH,
+    NUM_MOD_COLS
+};
+
+enum filter_subsel_e
+{
+    FILTER_SUBSEL_MODE,
+    FILTER_SUBSEL_CUTOFF,
+    FILTER_SUBSEL_RESONANCE,
+    FILTER_SUBSEL_ENV,
+    FILTER_SUBSEL_ENV_AMT,
+    FILTER_SUBSEL_KEY_TRACK,
+};
+
+enum chorus_subsel_e
+{
+    CHORUS_SUBSEL_ENABLE,
+    CHORUS_SUBSEL_RATE,
+    CHORUS_SUBSEL_DEPTH,
+    CHORUS_SUBSEL_DELAY,
+    CHORUS_SUBSEL_MIX,
+    CHORUS_SUBSEL_SPREAD,
+};
+
+enum delay_subsel_e
+{
+    DELAY_SUBSEL_ENABLE,
+    DELAY_SUBSEL_DIVISION,
+    DELAY_SUBSEL_SYNC,
+    DELAY_SUBSEL_BPM,
+    DELAY_SUBSEL_FEEDBACK,
+    DELAY_SUBSEL_DAMPING,
+    DELAY_SUBSEL_MIX,
+    DELAY_SUBSEL_PING_PONG,
+};
+
+enum reverb_subsel_e
+{
+    REVERB_SUBSEL_ENABLE,
+    REVERB_SUBSEL_QUALITY,
+    REVERB_SUBSEL_SIZE,
+    REVERB_SUBSEL_DAMPING,
+    REVERB_SUBSEL_MIX,
+    REVERB_SUBSEL_WIDTH,
 };
 
 static struct {
@@ -70,6 +177,11 @@ static struct {
         enum osc_subsel_e osc;
         enum env_subsel_e env;
         enum lfo_subsel_e lfo;
+        unsigned int mod;
+        enum filter_subsel_e filter;
+        enum chorus_subsel_e chorus;
+        enum delay_subsel_e delay;
+        enum reverb_subsel_e reverb;
     } subsel;
 } gui_state =
 {
@@ -79,6 +191,22 @@ static struct {
     .subsel.osc = OSC_SUBSEL_SHAPE,
 };
 
+/// Page shown in the left column of the DEBUG screen.
+static enum debug_page_e debug_page = DEBUG_PAGE_PROFILE;
+
+/// Segment edited in the selected envelope box.
+static uint8_t env_seg = 0;
+
+/// FILE screen cursor and the user slot the next import is written to.
+static struct {
+    size_t file_idx;
+    enum oscillator_shape_e slot;
+} file_state =
+{
+    .file_idx = 0,
+    .slot = USER_1,
+};
+
 static void gui_draw_header(display_context_t disp);
 static void gui_draw_footer(display_context_t disp);
 static void gui_draw_menu(display_context_t disp);
@@ -86,10 +214,27 @@ static void gui_draw_menu(display_context_t disp);
 static void gui_draw_osc_env(display_context_t disp);
 static void gui_draw_osc(uint8_t osc_idx, int x_base, int y_base);
 static void gui_draw_env(uint8_t env_idx, int x_base, int y_base);
+static void gui_draw_env_segment(float x0, uint32_t level0, float x1, uint32_t level1, int y_base);
+static uint8_t gui_get_env_seg(struct envelope_s const * env);
+static void gui_draw_scope(display_context_t disp);
+static void gui_draw_meter_bar(int32_t level, int y_top, int y_bottom);
+static void gui_draw_waveform(short const * samples, size_t num_samples,
+                              int x_start, int x_end,
+                              int y_mid, int half_height);
 
 static void gui_draw_lfo(void);
 
-static char * get_osc_shape_str(enum oscillator_shape_e osc_shape);
+static void gui_draw_debug(display_context_t disp);
+static void gui_draw_boot(void);
+static void gui_draw_profile(void);
+static void gui_draw_unison_profile(void);
+static void gui_draw_fx_profile(void);
+static void gui_draw_spectrum(display_context_t disp);
+static int gui_spectrum_freq_x(float freq_hz);
+
+static char const * get_osc_shape_str(enum oscillator_shape_e osc_shape);
+static char const * get_interp_str(enum wavetable_interp_e interp);
+static char const * get_pan_str(uint8_t pan);
 
 static void gui_nav_osc_env_right(void);
 static void gui_nav_osc_env_left(void);
@@ -110,6 +255,41 @@ static void gui_nav_lfo_left(void);
 static void gui_nav_lfo_right(void);
 static void gui_nav_lfo_up(void);
 static void gui_nav_lfo_down(void);
+static void gui_draw_mod_matrix(void);
+static void gui_nav_mod_adjust(bool increase);
+
+static void gui_draw_filter(void);
+static void gui_nav_filter_left(void);
+static void gui_nav_filter_right(void);
+static void gui_nav_filter_up(void);
+static void gui_nav_filter_down(void);
+
+static void gui_draw_fx(void);
+static void gui_draw_chorus(int x_base, int y_base);
+static void gui_draw_delay(int x_base, int y_base);
+static void gui_draw_reverb(int x_base, int y_base);
+static void gui_nav_fx_left(void);
+static void gui_nav_fx_right(void);
+static void gui_nav_fx_up(void);
+static void gui_nav_fx_down(void);
+static void gui_nav_chorus_adjust(bool increase);
+static void gui_nav_delay_adjust(bool increase);
+static void gui_nav_reverb_adjust(bool increase);
+
+static void gui_draw_settings(void);
+static void gui_nav_settings_left(void);
+static void gui_nav_settings_right(void);
+static void gui_nav_settings_up(void);
+static void gui_nav_settings_down(void);
+
+static void gui_nav_debug_left(void);
+static void gui_nav_debug_right(void);
+
+static void gui_draw_file(void);
+static void gui_nav_file_left(void);
+static void gui_nav_file_right(void);
+static void gui_nav_file_up(void);
+static void gui_nav_file_down(void);
 
 static color_t color_red = RGBA32(0xFF, 0, 0, 0xFF);
 static color_t color_green = RGBA32(0, 0xFF, 0, 0xFF);
@@ -121,6 +301,57 @@ static color_t color_gray = RGBA32(0x44, 0x44, 0x44, 0xFF);
 
 static rdpq_font_t * font;
 
+/// Splash screen text for each serial boot stage: in progress, then done.
+static char const * const splash_str[LAST_BOOT_STATE + 1][2] =
+{
+    [INIT]           = { "", "" },
+    [INIT_INPUT]     = { "Initializing input...", "Input initialized." },
+    [INIT_FILESYSTEM] = { "Mounting filesystem...", "Filesystem mounted." },
+    [INIT_ENVELOPES] = { "Initializing envelopes...", "Envelopes initialized." },
+    [INIT_LFOS]      = { "Initializing LFOs...", "LFOs initialized." },
+    [INIT_SPECTRUM]  = { "Initializing spectrum analyzer...", "Spectrum analyzer initialized." },
+    [GEN_SINE]       = { "Generating sine wave...", "Sine wave generated." },
+    [GEN_FREQ_TBL]   = { "Generating MIDI note frequency LUT...", "MIDI note frequency LUT generated." },
+    [INIT_VOICES]    = { "Initializing voices...", "Voices initialized." },
+    [ALLOC_MIX_BUF]  = { "Allocating mix buffer...", "Mix buffer allocated." },
+    [INIT_AUDIO]     = { "Initializing audio subsystem...", "Audio subsystem initialized." },
+};
+
+/// Short stage names for the boot summary on the DEBUG screen. Lazy stages,
+/// generated after audio starts, are marked with an asterisk.
+static char const * const boot_stage_str[NUM_INIT_STATES] =
+{
+    [INIT]           = "Display",
+    [INIT_INPUT]     = "Input",
+    [INIT_FILESYSTEM] = "Filesystem",
+    [INIT_ENVELOPES] = "Envelopes",
+    [INIT_LFOS]      = "LFOs",
+    [INIT_SPECTRUM]  = "Spectrum",
+    [GEN_SINE]       = "Sine table",
+    [GEN_FREQ_TBL]   = "Freq LUT",
+    [INIT_VOICES]    = "Voices",
+    [ALLOC_MIX_BUF]  = "Mix buffer",
+    [INIT_AUDIO]     = "Audio",
+    [GEN_SQUARE]     = "Square*",
+    [GEN_TRIANGLE]   = "Triangle*",
+    [GEN_RAMP]       = "Ramp*",
+};
+
+#define METER_TOTAL_BOXES 35
+
+#define SCOPE_X 26
+#define SCOPE_Y 162
+#define SCOPE_WIDTH 204
+#define SCOPE_HEIGHT 30
+
+#define SPECTRUM_X 256
+#define SPECTRUM_Y 50
+#define SPECTRUM_HEIGHT 130
+
+/// The CPU runs at twice the rate of the timer tick counter.
+#define CPU_CYCLES_PER_TICK 2
+#define SPECTRUM_BAR_WIDTH 5
+
 void gui_init(void)
 {
     display_init(RESOLUTION_512x240, DEPTH_16_BPP, NUM_DISP_BUFFERS, GAMMA_NONE, FILTERS_RESAMPLE);
@@ -152,11 +383,20 @@ void gui_draw_screen(void)
         case SCREEN_LFO:
             gui_draw_lfo();
             break;
+        case SCREEN_FILTER:
+            gui_draw_filter();
+            break;
+        case SCREEN_FX:
+            gui_draw_fx();
+            break;
         case SCREEN_FILE:
+            gui_draw_file();
             break;
         case SCREEN_DEBUG:
+            gui_draw_debug(disp);
             break;
         case SCREEN_SETTINGS:
+            gui_draw_settings();
             break;
         default:
             break;
@@ -177,67 +417,21 @@ void gui_splash(enum init_state_e init_state)
     gui_draw_header(disp);
     gui_draw_footer(disp);
 
-    if (GEN_SINE == init_state)
-    {
-        rdpq_text_print(NULL, 1, 60, 76, "Generating sine wave...");
-    }
-    else if (GEN_SINE < init_state)
-    {
-        rdpq_text_print(NULL, 1, 60, 76, "Sine wave generated.");
-    }
-
-    if (GEN_SQUARE == init_state)
-    {
-        rdpq_text_print(NULL, 1, 60, 84, "Generating square wave...");
-    }
-    else if (GEN_SQUARE < init_state)
-    {
-        rdpq_text_print(NULL, 1, 60, 84, "Square wave generated.");
-    }
-
-    if (GEN_TRIANGLE == init_state)
-    {
-        rdpq_text_print(NULL, 1, 60, 92, "Generating triangle wave...");
-    }
-    else if (GEN_TRIANGLE < init_state)
-    {
-        rdpq_text_print(NULL, 1, 60, 92, "Triangle wave generated.");
-    }
-
-    if (GEN_RAMP == init_state)
-    {
-        rdpq_text_print(NULL, 1, 60, 100, "Generating ramp wave...");
-    }
-    else if (GEN_RAMP < init_state)
-    {
-        rdpq_text_print(NULL, 1, 60, 100, "Ramp wave generated.");
-    }
-
-    if (GEN_FREQ_TBL == init_state)
-    {
-        rdpq_text_print(NULL, 1, 60, 108, "Generating MIDI note frequency LUT...");
-    }
-    else if (GEN_FREQ_TBL < init_state)
-    {
-        rdpq_text_print(NULL, 1, 60, 108, "MIDI note frequency LUT generated.");
-    }
-
-    if (ALLOC_MIX_BUF == init_state)
-    {
-        rdpq_text_print(NULL, 1, 60, 116, "Allocating mix buffer...");
-    }
-    else if (ALLOC_MIX_BUF < init_state)
-    {
-        rdpq_text_print(NULL, 1, 60, 116, "Mix buffer allocated.");
-    }
-
-    if (INIT_AUDIO == init_state)
-    {
-        rdpq_text_print(NULL, 1, 60, 124, "Initializing audio subsystem...");
-    }
-    else if (INIT_AUDIO < init_state)
+    int y_pos = 76;
+    for (enum init_state_e stage = INIT_INPUT; stage <= LAST_BOOT_STATE; ++stage)
     {
-        rdpq_text_print(NULL, 1, 60, 124, "Audio subsystem initialized.");
+        if (stage == init_state)
+        {
+            rdpq_text_print(NULL, 1, 60, y_pos, splash_str[stage][0]);
+        }
+        else if (stage < init_state)
+        {
+            rdpq_text_printf(NULL, 1, 60, y_pos, "%s (%lu.%lu ms)",
+                             splash_str[stage][1],
+                             init_stage_us[stage] / 1000,
+                             (init_stage_us[stage] / 100) % 10);
+        }
+        y_pos += 8;
     }
 
     rdpq_detach_show();
@@ -269,34 +463,75 @@ static void gui_draw_menu(display_context_t disp)
     switch (gui_state.screen)
     {
         case SCREEN_OSC_ENV:
-            rdpq_fill_rectangle(108, 19, 170, 30);
+            rdpq_fill_rectangle(84, 19, 146, 30);
             break;
         case SCREEN_LFO:
-            rdpq_fill_rectangle(196, 19, 222, 30);
+            rdpq_fill_rectangle(162, 19, 188, 30);
+            break;
+        case SCREEN_FILTER:
+            rdpq_fill_rectangle(204, 19, 248, 30);
+            break;
+        case SCREEN_FX:
+            rdpq_fill_rectangle(264, 19, 282, 30);
             break;
         case SCREEN_FILE:
-            rdpq_fill_rectangle(248, 19, 280, 30);
+            rdpq_fill_rectangle(298, 19, 330, 30);
             break;
         case SCREEN_DEBUG:
-            rdpq_fill_rectangle(306, 19, 344, 30);
+            rdpq_fill_rectangle(346, 19, 384, 30);
             break;
         case SCREEN_SETTINGS:
-            rdpq_fill_rectangle(372, 19, 428, 30);
+            rdpq_fill_rectangle(400, 19, 456, 30);
             break;
         default:
             break;
     }
 
     rdpq_text_print(NULL, 1, 28, 28, "<< L");
-    rdpq_text_print(NULL, 1, 112, 28, "OSC & ENV");
-    rdpq_text_print(NULL, 1, 200, 28, "LFO");
-    rdpq_text_print(NULL, 1, 252, 28, "FILE");
-    rdpq_text_print(NULL, 1, 310, 28, "DEBUG");
-    rdpq_text_print(NULL, 1, 376, 28, "SETTINGS");
+    rdpq_text_print(NULL, 1, 88, 28, "OSC & ENV");
+    rdpq_text_print(NULL, 1, 166, 28, "LFO");
+    rdpq_text_print(NULL, 1, 208, 28, "FILTER");
+    rdpq_text_print(NULL, 1, 268, 28, "FX");
+    rdpq_text_print(NULL, 1, 302, 28, "FILE");
+    rdpq_text_print(NULL, 1, 350, 28, "DEBUG");
+    rdpq_text_print(NULL, 1, 404, 28, "SETTINGS");
     rdpq_text_print(NULL, 1, 488, 28, "R >>");
 
 }
 
+/// Redraw only the regions fed by the audio engine: the level meter and, on
+/// the OSC & ENV screen, the live oscilloscope.
+void gui_draw_live(void)
+{
+    display_context_t disp = display_get();
+    rdpq_attach(disp, NULL);
+
+    if (SCREEN_OSC_ENV == gui_state.screen)
+    {
+        gui_draw_scope(disp);
+    }
+    else if (SCREEN_DEBUG == gui_state.screen)
+    {
+        gui_draw_spectrum(disp);
+        if (DEBUG_PAGE_PROFILE == debug_page)
+        {
+            gui_draw_profile();
+        }
+        else if (DEBUG_PAGE_UNISON == debug_page)
+        {
+            gui_draw_unison_profile();
+        }
+        else if (DEBUG_PAGE_FX == debug_page)
+        {
+            gui_draw_fx_profile();
+        }
+    }
+
+    gui_draw_level_meter(disp);
+
+    rdpq_detach_show();
+}
+
 void gui_draw_level_meter(display_context_t disp)
 {
     bool detach_disp = false;
@@ -312,20 +547,49 @@ void gui_draw_level_meter(display_context_t disp)
 
     rdpq_text_print(NULL, 1, 30, 216, "LEVEL:");
 
-    size_t const total_boxes = 35;
-    size_t const warn_level = total_boxes * 65 / 100;
-    size_t const clip_level = total_boxes * 9 / 10;
-    size_t const break_level = total_boxes * 11 / 10;
+    // Peak bar on top, RMS bar underneath.
+    gui_draw_meter_bar(meter_display.peak, 208, 213);
+    gui_draw_meter_bar(meter_display.rms, 214, 217);
+
+    size_t const hold_box = (meter_display.peak_hold * METER_TOTAL_BOXES) / INT16_MAX;
+    if (hold_box > 0)
+    {
+        int const x_pos = 80 + ((hold_box - 1) * 10);
+        rdpq_set_mode_fill(color_white);
+        rdpq_fill_rectangle(x_pos, 208, x_pos + 8, 213);
+    }
+
+    if (meter_display.clip)
+    {
+        rdpq_set_mode_fill(color_red);
+        rdpq_fill_rectangle(438, 208, 472, 218);
+        rdpq_text_print(NULL, 1, 440, 216, "CLIP");
+    }
+
+    if (detach_disp)
+    {
+        rdpq_detach_show();
+    }
+}
+
+/// Draw a row of level boxes for a linear level in [0, INT16_MAX], colored
+/// green, then yellow past the warning level, then red near full scale.
+static void gui_draw_meter_bar(int32_t level, int y_top, int y_bottom)
+{
+    size_t const warn_level = METER_TOTAL_BOXES * 65 / 100;
+    size_t const clip_level = METER_TOTAL_BOXES * 9 / 10;
 
-    size_t num_boxes = (peak * total_boxes) / INT16_MAX;
+    size_t num_boxes = (level * METER_TOTAL_BOXES) / INT16_MAX;
+    if (num_boxes > METER_TOTAL_BOXES)
+    {
+        num_boxes = METER_TOTAL_BOXES;
+    }
 
     int x_pos = 80;
     rdpq_set_mode_fill(color_green);
 
     for (size_t idx = 0; idx < num_boxes; ++idx)
     {
-        rdpq_fill_rectangle(x_pos, 208, x_pos + 8, 216);
-
         if (warn_level == idx)
         {
             rdpq_set_mode_fill(color_yellow);
@@ -334,17 +598,10 @@ void gui_draw_level_meter(display_context_t disp)
         {
             rdpq_set_mode_fill(color_red);
         }
-        else if (break_level == idx)
-        {
-            break;
-        }
 
-        x_pos += 10;
-    }
+        rdpq_fill_rectangle(x_pos, y_top, x_pos + 8, y_bottom);
 
-    if (detach_disp)
-    {
-        rdpq_detach_show();
+        x_pos += 10;
     }
 }
 
@@ -368,6 +625,75 @@ static void gui_draw_osc_env(display_context_t disp)
 
         y_base += 58;
     }
+
+    rdpq_set_mode_fill(color_gray);
+    rdpq_fill_rectangle(SCOPE_X - 4, SCOPE_Y, SCOPE_X + SCOPE_WIDTH + 4, SCOPE_Y + SCOPE_HEIGHT + 14);
+    rdpq_text_print(NULL, 1, SCOPE_X, SCOPE_Y + 10, "SCOPE");
+
+    gui_draw_scope(disp);
+}
+
+/// Draw the live oscilloscope from the scope ring.
+/// Twice the view width is snapshotted so the trace can start on a rising
+/// zero crossing, which keeps periodic waveforms steady between frames.
+static void gui_draw_scope(display_context_t disp)
+{
+    static int16_t snapshot[SCOPE_WIDTH * 2];
+
+    int const y_top = SCOPE_Y + 12;
+    int const y_mid = y_top + (SCOPE_HEIGHT / 2);
+
+    if (!scope_read(snapshot, SCOPE_WIDTH * 2))
+    {
+        // Torn read, keep the previous trace.
+        return;
+    }
+
+    size_t trigger_idx = 0;
+    for (size_t idx = 1; idx < SCOPE_WIDTH; ++idx)
+    {
+        if ((snapshot[idx - 1] < 0) && (snapshot[idx] >= 0))
+        {
+            trigger_idx = idx;
+            break;
+        }
+    }
+
+    rdpq_set_mode_fill(color_black);
+    rdpq_fill_rectangle(SCOPE_X, y_top, SCOPE_X + SCOPE_WIDTH, y_top + SCOPE_HEIGHT);
+
+    rdpq_set_fill_color(color_gray);
+    rdpq_fill_rectangle(SCOPE_X, y_mid, SCOPE_X + SCOPE_WIDTH, y_mid + 1);
+
+    rdpq_set_fill_color(color_green);
+    gui_draw_waveform(&snapshot[trigger_idx], SCOPE_WIDTH,
+                      SCOPE_X, SCOPE_X + SCOPE_WIDTH,
+                      y_mid, (SCOPE_HEIGHT / 2) - 1);
+}
+
+/// Draw a trace of the given samples across [x_start, x_end) using the
+/// current fill color. Samples are resampled to one per column, and each
+/// column is filled from the previous point to the current point so steep
+/// edges stay connected.
+static void gui_draw_waveform(short const * samples, size_t num_samples,
+                              int x_start, int x_end,
+                              int y_mid, int half_height)
+{
+    int const width = x_end - x_start;
+    int y_prev = y_mid - ((samples[0] * half_height) / INT16_MAX);
+
+    for (int col = 0; col < width; ++col)
+    {
+        size_t const sample_idx = ((size_t)col * num_samples) / width;
+        int const y_cur = y_mid - ((samples[sample_idx] * half_height) / INT16_MAX);
+
+        int const y_lo = (y_cur < y_prev) ? y_cur : y_prev;
+        int const y_hi = (y_cur < y_prev) ? y_prev : y_cur;
+
+        rdpq_fill_rectangle(x_start + col, y_lo, x_start + col + 1, y_hi + 1);
+
+        y_prev = y_cur;
+    }
 }
 
 static void gui_draw_osc(uint8_t osc_idx, int x_base, int y_base)
@@ -381,7 +707,7 @@ static void gui_draw_osc(uint8_t osc_idx, int x_base, int y_base)
     {
         rdpq_set_mode_fill(color_gray);
     }
-    rdpq_fill_rectangle(x_base - 4, y_base, x_base + 100, y_base + 62);
+    rdpq_fill_rectangle(x_base - 4, y_base, x_base + 100, y_base + 124);
 
     if (gui_state.selected
         && (((0 == osc_idx) && (SEL_OSC_1 == gui_state.sel))
@@ -394,36 +720,125 @@ static void gui_draw_osc(uint8_t osc_idx, int x_base, int y_base)
                 rdpq_fill_rectangle(x_base - 2, y_base + 1, x_base + 98, y_base + 12);
                 break;
             case OSC_SUBSEL_AMP_ENV:
-                rdpq_fill_rectangle(x_base - 2, y_base + 40, x_base + 98, y_base + 51);
+                rdpq_fill_rectangle(x_base - 2, y_base + 32, x_base + 98, y_base + 43);
                 break;
             case OSC_SUBSEL_GAIN:
-                rdpq_fill_rectangle(x_base - 2, y_base + 50, x_base + 98, y_base + 61);
+                rdpq_fill_rectangle(x_base - 2, y_base + 42, x_base + 98, y_base + 53);
+                break;
+            case OSC_SUBSEL_POSITION:
+                rdpq_fill_rectangle(x_base - 2, y_base + 52, x_base + 98, y_base + 63);
+                break;
+            case OSC_SUBSEL_POS_ENV:
+                rdpq_fill_rectangle(x_base - 2, y_base + 62, x_base + 98, y_base + 73);
+                break;
+            case OSC_SUBSEL_INTERP:
+                rdpq_fill_rectangle(x_base - 2, y_base + 72, x_base + 98, y_base + 83);
+                break;
+            case OSC_SUBSEL_DIRECT:
+                rdpq_fill_rectangle(x_base - 2, y_base + 82, x_base + 98, y_base + 93);
+                break;
+            case OSC_SUBSEL_COARSE:
+                rdpq_fill_rectangle(x_base - 2, y_base + 92, x_base + 62, y_base + 103);
+                break;
+            case OSC_SUBSEL_FINE:
+                rdpq_fill_rectangle(x_base + 62, y_base + 92, x_base + 98, y_base + 103);
+                break;
+            case OSC_SUBSEL_PHASE:
+                rdpq_fill_rectangle(x_base - 2, y_base + 102, x_base + 46, y_base + 113);
+                break;
+            case OSC_SUBSEL_PAN:
+                rdpq_fill_rectangle(x_base + 46, y_base + 102, x_base + 98, y_base + 113);
+                break;
+            case OSC_SUBSEL_UNISON:
+                rdpq_fill_rectangle(x_base - 2, y_base + 112, x_base + 38, y_base + 123);
+                break;
+            case OSC_SUBSEL_UNISON_DETUNE:
+                rdpq_fill_rectangle(x_base + 38, y_base + 112, x_base + 70, y_base + 123);
+                break;
+            case OSC_SUBSEL_UNISON_SPREAD:
+                rdpq_fill_rectangle(x_base + 70, y_base + 112, x_base + 98, y_base + 123);
                 break;
         }
     }
 
-    // TODO: Draw osc waveform
+    wavetable_t * osc = &oscillators[osc_idx];
+
     rdpq_set_fill_color(color_black);
-    rdpq_fill_rectangle(x_base + 4, y_base + 12, x_base + 92, y_base + 40);
+    rdpq_fill_rectangle(x_base + 4, y_base + 12, x_base + 92, y_base + 32);
+
+    // Static preview of one cycle of the selected table, at the unmodulated
+    // position for multi-frame tables.
+    if ((NONE != osc->shape) && (NULL != wavetable_get(osc->shape)))
+    {
+        uint16_t const frame_idx = (osc->position * (wavetable_get_num_frames(osc->shape) - 1))
+                                   / MIDI_MAX_DATA_BYTE;
+
+        rdpq_set_fill_color(color_white);
+        gui_draw_waveform(wavetable_get_frame(wavetable_get(osc->shape), frame_idx), WT_SIZE,
+                          x_base + 4, x_base + 92,
+                          y_base + 22, 9);
+    }
 
-    wavetable_t * osc = &oscillators[osc_idx];
     int gain_width = (62 * osc->gain) / MIDI_MAX_DATA_BYTE;
     rdpq_set_fill_color(color_white);
-    rdpq_fill_rectangle(x_base + 32, y_base + 52, x_base + 32 + gain_width, y_base + 59);
+    rdpq_fill_rectangle(x_base + 32, y_base + 44, x_base + 32 + gain_width, y_base + 51);
+
+    int pos_width = (62 * osc->position) / MIDI_MAX_DATA_BYTE;
+    rdpq_fill_rectangle(x_base + 32, y_base + 54, x_base + 32 + pos_width, y_base + 61);
 
     rdpq_text_printf(NULL, 1, x_base, y_base + 10,  "OSC %d: %s",
                      osc_idx + 1, get_osc_shape_str(osc->shape));
-    rdpq_text_printf(NULL, 1, x_base, y_base + 49, "AMP ENV: ENV %d",
+    rdpq_text_printf(NULL, 1, x_base, y_base + 41, "AMP ENV: ENV %d",
                      osc->amp_env_idx + 1);
-    rdpq_text_print(NULL, 1, x_base, y_base + 59, "GAIN:");
+    rdpq_text_print(NULL, 1, x_base, y_base + 51, "GAIN:");
+    rdpq_text_print(NULL, 1, x_base, y_base + 61, "POS:");
+    rdpq_text_printf(NULL, 1, x_base, y_base + 71, "POS ENV: %+d", osc->pos_env_amt);
+    rdpq_text_printf(NULL, 1, x_base, y_base + 81, "INTRP: %s", get_interp_str(osc->interp));
+    rdpq_text_printf(NULL, 1, x_base, y_base + 91, "POLYBLEP: %c", osc->direct ? 'Y':'N');
+    rdpq_text_printf(NULL, 1, x_base, y_base + 101, "TUNE: %+3d %+3dc", osc->coarse, osc->fine);
+    rdpq_text_printf(NULL, 1, x_base, y_base + 111, "PH:%-3d PAN:%s",
+                     (osc->phase_offset * 360) / (MIDI_MAX_DATA_BYTE + 1),
+                     get_pan_str(osc->pan));
+    rdpq_text_printf(NULL, 1, x_base, y_base + 121, "UNI:%d D%-3d S%-3d",
+                     osc->unison, osc->unison_detune, osc->unison_spread);
+}
+
+/// Width of the held level drawn at the sustain point, and of the longest
+/// segment in an envelope of num segments.
+#define ENV_GRAPH_WIDTH 240
+#define ENV_SUSTAIN_WIDTH 32
+#define ENV_SEGMENT_WIDTH(num) ((ENV_GRAPH_WIDTH - ENV_SUSTAIN_WIDTH) / (num))
+#define ENV_FIELD_WIDTH (ENV_GRAPH_WIDTH / NUM_ENV_SUBSELS)
+
+/// Strips a curved segment is drawn in.
+#define ENV_CURVE_DRAW_STEPS 8
+
+static char const * get_env_curve_str(enum envelope_curve_e curve)
+{
+    switch (curve)
+    {
+        case ENV_CURVE_LINEAR:
+            return "LIN";
+        case ENV_CURVE_EXP:
+            return "EXP";
+        case ENV_CURVE_LOG:
+            return "LOG";
+        case ENV_CURVE_S:
+            return "S";
+        default:
+            return "Unknown";
+    }
 }
 
 static void gui_draw_env(uint8_t env_idx, int x_base, int y_base)
 {
-    rdpq_set_mode_fill(color_gray);
-    if (((0 == env_idx) && (SEL_ENV_1 == gui_state.sel))
-        || ((1 == env_idx) && (SEL_ENV_2 == gui_state.sel))
-        || ((2 == env_idx) && (SEL_ENV_3 == gui_state.sel)))
+    struct envelope_s const * env = &envelopes[env_idx];
+    bool const env_sel = (((0 == env_idx) && (SEL_ENV_1 == gui_state.sel))
+                          || ((1 == env_idx) && (SEL_ENV_2 == gui_state.sel))
+                          || ((2 == env_idx) && (SEL_ENV_3 == gui_state.sel)));
+    uint8_t const seg_sel = gui_get_env_seg(env);
+
+    if (env_sel)
     {
         rdpq_set_mode_fill(color_blue);
     }
@@ -433,57 +848,149 @@ static void gui_draw_env(uint8_t env_idx, int x_base, int y_base)
     }
     rdpq_fill_rectangle(x_base - 4, y_base, x_base + 244, y_base + 56);
 
-    if (gui_state.selected
-        && (((env_idx == 0) && (SEL_ENV_1 == gui_state.sel))
-            || ((env_idx == 1) && (SEL_ENV_2 == gui_state.sel))
-            || ((env_idx == 2) && (SEL_ENV_3 == gui_state.sel))))
+    if (gui_state.selected && env_sel)
     {
+        int const x_field = x_base + (gui_state.subsel.env * ENV_FIELD_WIDTH);
         rdpq_set_fill_color(color_green);
-        switch (gui_state.subsel.env)
+        rdpq_fill_rectangle(x_field - 2, y_base + 45, x_field + ENV_FIELD_WIDTH - 2, y_base + 55);
+    }
+
+    // Segments run from the left, with a plateau after the last held one.
+    float x = (float)x_base;
+    uint32_t level = 0u;
+    float const seg_width = ENV_SEGMENT_WIDTH(env->num_segments);
+    for (uint8_t seg = 0; seg < env->num_segments; ++seg)
+    {
+        struct envelope_segment_s const * segment = &env->segments[seg];
+        float const x_end = x + (seg_width * ((float)segment->time / MIDI_MAX_NRPN_VAL));
+
+        if (seg == env->loop)
         {
-            case ENV_SUBSEL_A:
-                rdpq_fill_rectangle(x_base - 2, y_base + 45, x_base + 56, y_base + 55);
-                break;
-            case ENV_SUBSEL_D:
-                rdpq_fill_rectangle(x_base + 58, y_base + 45, x_base + 116, y_base + 55);
-                break;
-            case ENV_SUBSEL_S:
-                rdpq_fill_rectangle(x_base + 118, y_base + 45, x_base + 176, y_base + 55);
-                break;
-            case ENV_SUBSEL_R:
-                rdpq_fill_rectangle(x_base + 178, y_base + 45, x_base + 236, y_base + 55);
-                break;
-            default:
-                break;
+            rdpq_set_fill_color(color_yellow);
+            rdpq_fill_rectangle(x, y_base + 2, x + 1, y_base + 45);
+        }
+
+        rdpq_set_fill_color((env_sel && (seg == seg_sel)) ? color_green : color_white);
+        if (NULL == segment->shape)
+        {
+            gui_draw_env_segment(x, level, x_end, segment->target, y_base);
+        }
+        else
+        {
+            // Follow the curve in strips, from the same table the audio
+            // reads.
+            int64_t const delta = (int64_t)segment->target - level;
+            float x_step = x;
+            uint32_t level_step = level;
+            for (size_t step = 1; step <= ENV_CURVE_DRAW_STEPS; ++step)
+            {
+                uint32_t const pos = (uint32_t)(((uint64_t)step << 32) / ENV_CURVE_DRAW_STEPS);
+                float const x_next = x + (((x_end - x) * step) / ENV_CURVE_DRAW_STEPS);
+                uint32_t const level_next = (ENV_CURVE_DRAW_STEPS == step)
+                    ? segment->target
+                    : (uint32_t)(level + ((delta * envelope_curve_lookup(segment->shape, pos))
+                                          >> ENV_CURVE_BITS));
+
+                gui_draw_env_segment(x_step, level_step, x_next, level_next, y_base);
+                x_step = x_next;
+                level_step = level_next;
+            }
+        }
+
+        x = x_end;
+        level = segment->target;
+
+        if ((seg + 1) == env->sustain)
+        {
+            rdpq_set_fill_color(color_white);
+            gui_draw_env_segment(x, level, x + ENV_SUSTAIN_WIDTH, level, y_base);
+            x += ENV_SUSTAIN_WIDTH;
         }
     }
 
-    rdpq_set_fill_color(color_white);
-    float a1[] = {(float)x_base, (float)(y_base + 44)};
-    float a2[] = {x_base + (60 * ((float)envelopes[env_idx].attack / MIDI_MAX_NRPN_VAL)), (float)(y_base + 4)};
-    float a3[] = {a2[0], a1[1]};
-    float d1[] = {a2[0], a2[1]}; // same as a2
-    float d2[] = {a2[0], y_base + 4 + (40 * ((float)(UINT32_MAX - envelopes[env_idx].sustain_level) / UINT32_MAX))};
-    float d3[] = {a2[0] + (60 * ((float)envelopes[env_idx].decay / MIDI_MAX_NRPN_VAL)), d2[1]};
-    float r1[] = {(float)x_base + 240, a1[1]};
-    float r2[] = {r1[0] - (60 * ((float)envelopes[env_idx].release / MIDI_MAX_NRPN_VAL)), a1[1]};
-    float r3[] = {r2[0], d2[1]};
-
-    rdpq_triangle(&TRIFMT_FILL, a1, a2, a3);
-    rdpq_triangle(&TRIFMT_FILL, d1, d2, d3);
-    rdpq_triangle(&TRIFMT_FILL, r3, r2, r1);
-    rdpq_fill_rectangle(a2[0], d2[1], r2[0], a1[1]);
+    char const * point_str = "-";
+    if ((seg_sel + 1 == env->sustain) && (seg_sel == env->loop))
+    {
+        point_str = "S+L";
+    }
+    else if (seg_sel + 1 == env->sustain)
+    {
+        point_str = "SUS";
+    }
+    else if (seg_sel == env->loop)
+    {
+        point_str = "LOOP";
+    }
+
+    uint32_t const time_ms = (uint32_t)(env->segments[seg_sel].samples / 44.1f);
 
     rdpq_text_printf(NULL, 1, x_base + 208, y_base + 14, "ENV %d",
                      env_idx + 1);
-    rdpq_text_printf(NULL, 1, x_base,       y_base + 54, "A:%lums",
-                     (uint32_t)(env_sample_lut[envelopes[env_idx].attack] / 44.1f));
-    rdpq_text_printf(NULL, 1, x_base + 60,  y_base + 54, "D:%lums",
-                     (uint32_t)(env_sample_lut[envelopes[env_idx].decay] / 44.1f));
-    rdpq_text_printf(NULL, 1, x_base + 120, y_base + 54, "S: %2.1f%%",
-                     (float)(envelopes[env_idx].sustain_level) * 100 / UINT32_MAX);
-    rdpq_text_printf(NULL, 1, x_base + 180, y_base + 54, "R:%lums",
-                     (uint32_t)(env_sample_lut[envelopes[env_idx].release] / 44.1f));
+    rdpq_text_printf(NULL, 1, x_base,       y_base + 54, "#%d/%d",
+                     seg_sel + 1, env->num_segments);
+    if (time_ms < 1000)
+    {
+        rdpq_text_printf(NULL, 1, x_base + 40, y_base + 54, "%lums", time_ms);
+    }
+    else if (time_ms < 10000)
+    {
+        rdpq_text_printf(NULL, 1, x_base + 40, y_base + 54, "%lu.%02lus",
+                         time_ms / 1000, (time_ms % 1000) / 10);
+    }
+    else
+    {
+        rdpq_text_printf(NULL, 1, x_base + 40, y_base + 54, "%lus", time_ms / 1000);
+    }
+    rdpq_text_printf(NULL, 1, x_base + 80,  y_base + 54, "L%lu%%",
+                     (uint32_t)(((uint64_t)env->segments[seg_sel].target * 100) / UINT32_MAX));
+    rdpq_text_printf(NULL, 1, x_base + 120, y_base + 54, "%s",
+                     get_env_curve_str(env->segments[seg_sel].curve));
+    rdpq_text_printf(NULL, 1, x_base + 160, y_base + 54, "%s", point_str);
+    rdpq_text_printf(NULL, 1, x_base + 200, y_base + 54, "N:%d",
+                     env->num_segments);
+}
+
+/// Fill the area under one segment of an envelope graph, a trapezoid from
+/// level0 at x0 to level1 at x1, as two triangles.
+static void gui_draw_env_segment(float x0, uint32_t level0, float x1, uint32_t level1, int y_base)
+{
+    float const y_bottom = (float)(y_base + 44);
+    float const y0 = y_base + 4 + (40 * ((float)(UINT32_MAX - level0) / UINT32_MAX));
+    float const y1 = y_base + 4 + (40 * ((float)(UINT32_MAX - level1) / UINT32_MAX));
+
+    float v0[] = {x0, y_bottom};
+    float v1[] = {x0, y0};
+    float v2[] = {x1, y1};
+    float v3[] = {x1, y_bottom};
+
+    rdpq_triangle(&TRIFMT_FILL, v0, v1, v2);
+    rdpq_triangle(&TRIFMT_FILL, v0, v2, v3);
+}
+
+/// Segment edited in an envelope, kept inside its table as segments are
+/// removed or another envelope is selected.
+static uint8_t gui_get_env_seg(struct envelope_s const * env)
+{
+    if (env_seg >= env->num_segments)
+    {
+        env_seg = env->num_segments - 1;
+    }
+    return env_seg;
+}
+
+static char const * get_lfo_sync_str(enum lfo_sync_e sync)
+{
+    switch (sync)
+    {
+        case LFO_SYNC_GLOBAL:
+            return "GLOBAL";
+        case LFO_SYNC_KEY:
+            return "KEY";
+        case LFO_SYNC_RANDOM:
+            return "RANDOM";
+        default:
+            return "Unknown";
+    }
 }
 
 static void gui_draw_lfo(void)
@@ -520,10 +1027,10 @@ static void gui_draw_lfo(void)
                 case LFO_SUBSEL_DEPTH:
                     rdpq_fill_rectangle(x_base - 2, y_base + 21, x_base + 92, y_base + 32);
                     break;
-                case LFO_SUBSEL_DST_AMP:
+                case LFO_SUBSEL_SYNC:
                     rdpq_fill_rectangle(x_base - 2, y_base + 31, x_base + 92, y_base + 42);
                     break;
-                case LFO_SUBSEL_DST_PITCH:
+                case LFO_SUBSEL_DIRECT:
                     rdpq_fill_rectangle(x_base - 2, y_base + 41, x_base + 92, y_base + 52);
                     break;
                 default:
@@ -537,36 +1044,519 @@ static void gui_draw_lfo(void)
         rdpq_text_printf(NULL, 1, x_base, y_base + 10, "SHAPE: %s", get_osc_shape_str(lfo->shape));
         rdpq_text_printf(NULL, 1, x_base, y_base + 20, "RATE: %.2f Hz", lfo->rate);
         rdpq_text_printf(NULL, 1, x_base, y_base + 30, "DEPTH: %.2f%%", ((float)lfo->depth * 100) / INT16_MAX);
-        rdpq_text_printf(NULL, 1, x_base, y_base + 40, "TREMOLO......%c", (LFO_DST_AMP & lfo->dst) ? 'Y':'N' );
-        rdpq_text_printf(NULL, 1, x_base, y_base + 50, "VIBRATO......%c", (LFO_DST_FREQ & lfo->dst) ? 'Y':'N' );
+        rdpq_text_printf(NULL, 1, x_base, y_base + 40, "SYNC: %s", get_lfo_sync_str(lfo->sync));
+        rdpq_text_printf(NULL, 1, x_base, y_base + 50, "POLYBLEP.....%c", lfo->direct ? 'Y':'N' );
 
         x_base += 105;
     }
+
+    gui_draw_mod_matrix();
 }
 
-void gui_screen_next(void)
+static char const * get_mod_src_str(enum mod_src_e src)
 {
-    if (SCREEN_SETTINGS == gui_state.screen)
-    {
-        gui_state.screen = SCREEN_OSC_ENV;
+    switch (src)
+    {
+        case MOD_SRC_NONE:
+            return "---";
+        case MOD_SRC_LFO_1:
+            return "LFO 1";
+        case MOD_SRC_LFO_2:
+            return "LFO 2";
+        case MOD_SRC_ENV_1:
+            return "ENV 1";
+        case MOD_SRC_ENV_2:
+            return "ENV 2";
+        case MOD_SRC_ENV_3:
+            return "ENV 3";
+        case MOD_SRC_VELOCITY:
+            return "VELO";
+        case MOD_SRC_MOD_WHEEL:
+            return "WHEEL";
+        case MOD_SRC_AFTERTOUCH:
+            return "AFTTCH";
+        default:
+            return "?";
     }
-    else
-    {
-        ++gui_state.screen;
+}
+
+static char const * get_mod_dst_str(enum mod_dst_e dst)
+{
+    switch (dst)
+    {
+        case MOD_DST_PITCH:
+            return "PITCH";
+        case MOD_DST_GAIN:
+            return "GAIN";
+        case MOD_DST_PAN:
+            return "PAN";
+        case MOD_DST_CUTOFF:
+            return "CUTOFF";
+        case MOD_DST_POSITION:
+            return "POS";
+        case MOD_DST_LFO_1_DEPTH:
+            return "L1DPTH";
+        case MOD_DST_LFO_2_DEPTH:
+            return "L2DPTH";
+        default:
+            return "?";
     }
+}
 
-    switch(gui_state.screen)
+/// Draw the mod matrix, a row per slot of source, destination and depth.
+/// The selected cell is highlighted on its own.
+static void gui_draw_mod_matrix(void)
+{
+    int const x_base = 250;
+    int const y_base = 45;
+
+    rdpq_set_mode_fill((SEL_MOD_MATRIX == gui_state.sel) ? color_blue : color_gray);
+    rdpq_fill_rectangle(x_base - 4, y_base - 10, x_base + 166, y_base + 83);
+
+    if (gui_state.selected && (SEL_MOD_MATRIX == gui_state.sel))
+    {
+        static int const col_x[NUM_MOD_COLS] = { 16, 72, 128 };
+        static int const col_w[NUM_MOD_COLS] = { 48, 48, 32 };
+
+        size_t const slot_idx = gui_state.subsel.mod / NUM_MOD_COLS;
+        size_t const col = gui_state.subsel.mod % NUM_MOD_COLS;
+        int const y_row = y_base + 11 + (10 * slot_idx);
+
+        rdpq_set_mode_fill(color_green);
+        rdpq_fill_rectangle(x_base + col_x[col] - 2, y_row,
+                            x_base + col_x[col] + col_w[col] + 2, y_row + 11);
+    }
+
+    rdpq_text_print(NULL, 1, x_base, y_base, "MOD  SOURCE DEST   AMT");
+    for (size_t slot_idx = 0; slot_idx < MOD_MATRIX_SLOTS; ++slot_idx)
+    {
+        struct mod_slot_s const * slot = &mod_slots[slot_idx];
+
+        rdpq_text_printf(NULL, 1, x_base, y_base + 10 + (10 * slot_idx), "%u %-6s %-6s %4d",
+                         (unsigned)(slot_idx + 1),
+                         get_mod_src_str(slot->src),
+                         get_mod_dst_str(slot->dst),
+                         (int)slot->depth);
+    }
+}
+
+/// Step the selected cell of the mod matrix one way or the other, and
+/// recompile the routes.
+static void gui_nav_mod_adjust(bool increase)
+{
+    struct mod_slot_s * slot = &mod_slots[gui_state.subsel.mod / NUM_MOD_COLS];
+
+    switch (gui_state.subsel.mod % NUM_MOD_COLS)
+    {
+        case MOD_COL_SRC:
+            if (increase && ((NUM_MOD_SRCS - 1) > slot->src))
+            {
+                ++slot->src;
+            }
+            else if (!increase && (MOD_SRC_NONE < slot->src))
+            {
+                --slot->src;
+            }
+            break;
+        case MOD_COL_DST:
+            if (increase && ((NUM_MOD_DSTS - 1) > slot->dst))
+            {
+                ++slot->dst;
+            }
+            else if (!increase && (MOD_DST_PITCH < slot->dst))
+            {
+                --slot->dst;
+            }
+            break;
+        case MOD_COL_DEPTH:
+            if (increase && (MIDI_MAX_DATA_BYTE > slot->depth))
+            {
+                ++slot->depth;
+            }
+            else if (!increase && (-MIDI_MAX_DATA_BYTE < slot->depth))
+            {
+                --slot->depth;
+            }
+            break;
+        default:
+            break;
+    }
+
+    mod_matrix_compile();
+}
+
+/// Draw the DEBUG screen: the boot summary, the synthesis profile, the
+/// unison cost or the effects cost on the left, selected with left and right,
+/// and the spectrum analyzer on the right.
+static void gui_draw_debug(display_context_t disp)
+{
+    if (DEBUG_PAGE_BOOT == debug_page)
+    {
+        gui_draw_boot();
+    }
+    else if (DEBUG_PAGE_UNISON == debug_page)
+    {
+        gui_draw_unison_profile();
+    }
+    else if (DEBUG_PAGE_FX == debug_page)
+    {
+        gui_draw_fx_profile();
+    }
+    else
+    {
+        gui_draw_profile();
+    }
+
+    rdpq_set_mode_fill(color_gray);
+    rdpq_fill_rectangle(SPECTRUM_X - 4, 34, SPECTRUM_X + (SPECTRUM_NUM_BARS * SPECTRUM_BAR_WIDTH) + 4, 206);
+    rdpq_text_print(NULL, 1, SPECTRUM_X, 44, "SPECTRUM");
+
+    gui_draw_spectrum(disp);
+}
+
+static void gui_draw_boot(void)
+{
+    rdpq_set_mode_fill(color_gray);
+    rdpq_fill_rectangle(16, 34, 244, 206);
+    rdpq_text_print(NULL, 1, 20, 44, "BOOT                  < >");
+
+    int y_pos = 56;
+    for (enum init_state_e stage = INIT; stage < NUM_INIT_STATES; ++stage)
+    {
+        rdpq_text_printf(NULL, 1, 20, y_pos, "%-10s %6lu.%lu ms",
+                         boot_stage_str[stage],
+                         init_stage_us[stage] / 1000,
+                         (init_stage_us[stage] / 100) % 10);
+        y_pos += 9;
+    }
+
+    y_pos += 4;
+    rdpq_text_printf(NULL, 1, 20, y_pos, "First note %6lu.%lu ms",
+                     init_first_note_us / 1000, (init_first_note_us / 100) % 10);
+    y_pos += 9;
+    if (init_all_ready_us > 0)
+    {
+        rdpq_text_printf(NULL, 1, 20, y_pos, "All tables %6lu.%lu ms",
+                         init_all_ready_us / 1000, (init_all_ready_us / 100) % 10);
+    }
+    else
+    {
+        rdpq_text_print(NULL, 1, 20, y_pos, "All tables    pending");
+    }
+}
+
+/// Draw the log-frequency spectrum bars with grid lines every 24 dB and
+/// decade markers along the bottom.
+static void gui_draw_spectrum(display_context_t disp)
+{
+    int const x_end = SPECTRUM_X + (SPECTRUM_NUM_BARS * SPECTRUM_BAR_WIDTH);
+    int const y_bottom = SPECTRUM_Y + SPECTRUM_HEIGHT;
+
+    rdpq_set_mode_fill(color_black);
+    rdpq_fill_rectangle(SPECTRUM_X, SPECTRUM_Y, x_end, y_bottom + 24);
+
+    rdpq_set_fill_color(color_gray);
+    for (int db = 24; db < SPECTRUM_FLOOR_DB; db += 24)
+    {
+        int const y_grid = SPECTRUM_Y + ((db * SPECTRUM_HEIGHT) / SPECTRUM_FLOOR_DB);
+        rdpq_fill_rectangle(SPECTRUM_X, y_grid, x_end, y_grid + 1);
+    }
+
+    for (size_t bar = 0; bar < SPECTRUM_NUM_BARS; ++bar)
+    {
+        int const height = (spectrum_bars[bar] * SPECTRUM_HEIGHT) / SPECTRUM_FLOOR_DB;
+        int const x_pos = SPECTRUM_X + (bar * SPECTRUM_BAR_WIDTH);
+
+        if (height > 0)
+        {
+            rdpq_set_fill_color(color_green);
+            rdpq_fill_rectangle(x_pos, y_bottom - height, x_pos + SPECTRUM_BAR_WIDTH - 1, y_bottom);
+        }
+    }
+
+    rdpq_set_fill_color(color_white);
+    rdpq_fill_rectangle(gui_spectrum_freq_x(100.0f), y_bottom, gui_spectrum_freq_x(100.0f) + 1, y_bottom + 4);
+    rdpq_fill_rectangle(gui_spectrum_freq_x(1000.0f), y_bottom, gui_spectrum_freq_x(1000.0f) + 1, y_bottom + 4);
+    rdpq_fill_rectangle(gui_spectrum_freq_x(10000.0f), y_bottom, gui_spectrum_freq_x(10000.0f) + 1, y_bottom + 4);
+
+    rdpq_text_print(NULL, 1, gui_spectrum_freq_x(100.0f) - 8, y_bottom + 13, "100");
+    rdpq_text_print(NULL, 1, gui_spectrum_freq_x(1000.0f) - 4, y_bottom + 13, "1k");
+    rdpq_text_print(NULL, 1, gui_spectrum_freq_x(10000.0f) - 8, y_bottom + 13, "10k");
+    rdpq_text_printf(NULL, 1, SPECTRUM_X, y_bottom + 23, "FFT %d: %luus",
+                     SPECTRUM_FFT_SIZE, spectrum_fft_us);
+}
+
+/// Draw the synthesis cost from the audio engine's last profile window: total
+/// CPU load, the average voice count, the cost of a voice per sample, and the
+/// cost of an oscillator per sample with each interpolation kernel and with
+/// the PolyBLEP direct oscillators. THD+N is measured from the spectrum
+/// analyzer's capture, so holding a single note and switching the kernel
+/// compares their noise.
+static void gui_draw_profile(void)
+{
+    static char const * const kernel_label_str[NUM_AUDIO_PROFILE_KERNELS] =
+    {
+        [WT_INTERP_NONE]              = "  Trunc",
+        [WT_INTERP_LINEAR]            = "  Linear",
+        [WT_INTERP_CUBIC]             = "  Cubic",
+        [AUDIO_PROFILE_KERNEL_DIRECT] = "  PolyBLEP",
+    };
+
+    struct audio_engine_profile_s profile;
+    audio_engine_get_profile(&profile);
+
+    rdpq_set_mode_fill(color_gray);
+    rdpq_fill_rectangle(16, 34, 244, 206);
+    rdpq_text_print(NULL, 1, 20, 44, "PROFILE               < >");
+
+    if (0 == profile.num_samples)
+    {
+        return;
+    }
+
+    int y_pos = 56;
+
+    uint32_t const load = ((uint64_t)profile.synth_ticks * SAMPLE_RATE * 1000)
+                          / ((uint64_t)profile.num_samples * TICKS_PER_SECOND);
+    rdpq_text_printf(NULL, 1, 20, y_pos, "Synth      %3lu.%lu%% CPU",
+                     load / 10, load % 10);
+    y_pos += 9;
+
+    uint32_t const avg_voices = (profile.voice_samples * 10) / profile.num_samples;
+    rdpq_text_printf(NULL, 1, 20, y_pos, "Voices     %3lu.%lu avg, %lu culled",
+                     avg_voices / 10, avg_voices % 10, profile.voices_culled);
+    y_pos += 9;
+
+    if (profile.voice_samples > 0)
+    {
+        rdpq_text_printf(NULL, 1, 20, y_pos, "Voice      %5lu cyc/smp",
+                         (profile.voice_ticks * CPU_CYCLES_PER_TICK) / profile.voice_samples);
+    }
+    y_pos += 9;
+
+    if (profile.filter_samples > 0)
+    {
+        uint32_t const ticks_per_sample = TICKS_PER_SECOND / SAMPLE_RATE;
+        uint32_t const max_voices = ((uint64_t)ticks_per_sample * profile.voice_samples)
+                                    / profile.voice_ticks;
+        uint32_t const max_unfiltered = ((uint64_t)ticks_per_sample * profile.voice_samples)
+                                        / (profile.voice_ticks - profile.filter_ticks);
+
+        rdpq_text_printf(NULL, 1, 20, y_pos, "Filter     %5lu cyc/smp",
+                         (profile.filter_ticks * CPU_CYCLES_PER_TICK) / profile.filter_samples);
+        y_pos += 9;
+        rdpq_text_printf(NULL, 1, 20, y_pos, "Max voices %5lu, %lu unfilt.",
+                         max_voices, max_unfiltered);
+    }
+    else
+    {
+        rdpq_text_print(NULL, 1, 20, y_pos, "Filter         -");
+    }
+    y_pos += 9;
+
+    uint32_t const avg_morph = (profile.morph_samples * 10) / profile.num_samples;
+    rdpq_text_printf(NULL, 1, 20, y_pos, "Morphing   %3lu.%lu osc avg",
+                     avg_morph / 10, avg_morph % 10);
+    y_pos += 13;
+
+    rdpq_text_print(NULL, 1, 20, y_pos, "Oscillator by kernel");
+    y_pos += 9;
+    for (size_t kernel = 0; kernel < NUM_AUDIO_PROFILE_KERNELS; ++kernel)
+    {
+        if (profile.kernel_samples[kernel] > 0)
+        {
+            rdpq_text_printf(NULL, 1, 20, y_pos, "%-10s %5lu cyc/smp",
+                             kernel_label_str[kernel],
+                             (profile.kernel_ticks[kernel] * CPU_CYCLES_PER_TICK)
+                                 / profile.kernel_samples[kernel]);
+        }
+        else
+        {
+            rdpq_text_printf(NULL, 1, 20, y_pos, "%-10s     -", kernel_label_str[kernel]);
+        }
+        y_pos += 9;
+    }
+    y_pos += 4;
+
+    rdpq_text_printf(NULL, 1, 20, y_pos, "THD+N      %5d dB", spectrum_thdn_db);
+    y_pos += 13;
+
+    if (profile.limit_samples > 0)
+    {
+        float const limit_gr_db = -20.0f * log10f(1.0f - ((float)profile.limit_max_reduction
+                                                           / DYN_GAIN_ONE));
+        rdpq_text_printf(NULL, 1, 20, y_pos, "Limiter    %5lu cyc/smp %4.1f dB",
+                         (profile.limit_ticks * CPU_CYCLES_PER_TICK) / profile.limit_samples,
+                         limit_gr_db);
+    }
+    else
+    {
+        rdpq_text_print(NULL, 1, 20, y_pos, "Limiter        -");
+    }
+    y_pos += 9;
+
+    if (profile.clip_samples > 0)
+    {
+        float clip_gr_db = 0.0f;
+        if (profile.clip_peak > DYN_CLIP_KNEE)
+        {
+            clip_gr_db = -20.0f * log10f((float)dynamics_clip_sample(profile.clip_peak)
+                                         / profile.clip_peak);
+        }
+        rdpq_text_printf(NULL, 1, 20, y_pos, "Soft clip  %5lu cyc/smp %4.1f dB",
+                         (profile.clip_ticks * CPU_CYCLES_PER_TICK) / profile.clip_samples,
+                         clip_gr_db);
+    }
+    else
+    {
+        rdpq_text_print(NULL, 1, 20, y_pos, "Soft clip      -");
+    }
+}
+
+/// Draw the cost of an oscillator per sample at each unison count seen in
+/// the last profile window, and how many such oscillators the whole CPU could
+/// render. Playing a held chord while stepping the unison count shows the
+/// polyphony given up for each extra sub-oscillator.
+static void gui_draw_unison_profile(void)
+{
+    struct audio_engine_profile_s profile;
+    audio_engine_get_profile(&profile);
+
+    rdpq_set_mode_fill(color_gray);
+    rdpq_fill_rectangle(16, 34, 244, 206);
+    rdpq_text_print(NULL, 1, 20, 44, "UNISON COST           < >");
+    rdpq_text_print(NULL, 1, 20, 56, "Count  cyc/smp  Max osc");
+
+    int y_pos = 68;
+    for (size_t unison_idx = 0; unison_idx < WT_MAX_UNISON; ++unison_idx)
+    {
+        if ((profile.unison_samples[unison_idx] > 0) && (profile.unison_ticks[unison_idx] > 0))
+        {
+            uint32_t const ticks_per_sample = TICKS_PER_SECOND / SAMPLE_RATE;
+            uint32_t const max_osc = ((uint64_t)ticks_per_sample * profile.unison_samples[unison_idx])
+                                     / profile.unison_ticks[unison_idx];
+
+            rdpq_text_printf(NULL, 1, 20, y_pos, "  %u    %5lu    %5lu",
+                             (unsigned)(unison_idx + 1),
+                             (profile.unison_ticks[unison_idx] * CPU_CYCLES_PER_TICK)
+                                 / profile.unison_samples[unison_idx],
+                             max_osc);
+        }
+        else
+        {
+            rdpq_text_printf(NULL, 1, 20, y_pos, "  %u        -        -", (unsigned)(unison_idx + 1));
+        }
+        y_pos += 9;
+    }
+}
+
+/// Draw the cost of each effect on the bus per sample over the last profile
+/// window, and the RDRAM it holds.
+static void gui_draw_fx_profile(void)
+{
+    static char const * const fx_label_str[NUM_FX] =
+    {
+        [FX_CHORUS] = "Chorus",
+        [FX_DELAY]  = "Delay",
+        [FX_REVERB] = "Reverb",
+    };
+
+    size_t const fx_mem_bytes[NUM_FX] =
+    {
+        [FX_CHORUS] = chorus_get_mem_bytes(),
+        [FX_DELAY]  = delay_get_mem_bytes(),
+        [FX_REVERB] = reverb_get_mem_bytes(),
+    };
+
+    struct audio_engine_profile_s profile;
+    audio_engine_get_profile(&profile);
+
+    rdpq_set_mode_fill(color_gray);
+    rdpq_fill_rectangle(16, 34, 244, 206);
+    rdpq_text_print(NULL, 1, 20, 44, "FX COST               < >");
+    rdpq_text_print(NULL, 1, 20, 56, "Effect cyc/blk cyc/smp  KB");
+
+    int y_pos = 68;
+    for (size_t fx = 0; fx < NUM_FX; ++fx)
+    {
+        if (profile.fx_samples[fx] > 0)
+        {
+            uint32_t const cycles_per_sample = (profile.fx_ticks[fx] * CPU_CYCLES_PER_TICK)
+                                               / profile.fx_samples[fx];
+            rdpq_text_printf(NULL, 1, 20, y_pos, "%-6s %7lu %7lu %3u",
+                             fx_label_str[fx],
+                             cycles_per_sample * CONTROL_BLOCK_SIZE,
+                             cycles_per_sample,
+                             (unsigned)(fx_mem_bytes[fx] / 1024));
+        }
+        else
+        {
+            rdpq_text_printf(NULL, 1, 20, y_pos, "%-6s       -       - %3u",
+                             fx_label_str[fx], (unsigned)(fx_mem_bytes[fx] / 1024));
+        }
+        y_pos += 9;
+    }
+}
+
+/// Return the x position of the spectrum bar containing the given frequency.
+static int gui_spectrum_freq_x(float freq_hz)
+{
+    uint16_t const bin = (uint16_t)((freq_hz * SPECTRUM_FFT_SIZE) / SAMPLE_RATE);
+
+    size_t bar = 0;
+    while (((bar + 1) < SPECTRUM_NUM_BARS) && (spectrum_bar_bins[bar + 1] <= bin))
+    {
+        ++bar;
+    }
+
+    return SPECTRUM_X + (bar * SPECTRUM_BAR_WIDTH);
+}
+
+void gui_screen_next(void)
+{
+    if (SCREEN_SETTINGS == gui_state.screen)
+    {
+        gui_state.screen = SCREEN_OSC_ENV;
+    }
+    else
+    {
+        ++gui_state.screen;
+    }
+
+    switch(gui_state.screen)
     {
         case SCREEN_OSC_ENV:
             gui_state.sel = SEL_OSC_1;
             break;
         case SCREEN_LFO:
             gui_state.sel = SEL_LFO_1;
+            gui_state.subsel.lfo = LFO_SUBSEL_SHAPE;
+            break;
+        case SCREEN_FILTER:
+            gui_state.sel = SEL_FILTER;
+            gui_state.subsel.filter = FILTER_SUBSEL_MODE;
+            break;
+        case SCREEN_FX:
+            gui_state.sel = SEL_FX_CHORUS;
+            gui_state.subsel.chorus = CHORUS_SUBSEL_ENABLE;
+            break;
+        case SCREEN_FILE:
+            gui_state.sel = SEL_FILE_LIST;
+            wav_import_scan();
+            if (file_state.file_idx >= wav_import_num_files)
+            {
+                file_state.file_idx = 0;
+            }
+            break;
+        case SCREEN_SETTINGS:
+            gui_state.sel = SEL_SETTINGS_HARMONICS;
             break;
         default:
             break;
     }
 
+    spectrum_enable(SCREEN_DEBUG == gui_state.screen);
+
     gui_state.selected = false;
 }
 
@@ -588,16 +1578,49 @@ void gui_screen_prev(void)
             break;
         case SCREEN_LFO:
             gui_state.sel = SEL_LFO_1;
+            gui_state.subsel.lfo = LFO_SUBSEL_SHAPE;
+            break;
+        case SCREEN_FILTER:
+            gui_state.sel = SEL_FILTER;
+            gui_state.subsel.filter = FILTER_SUBSEL_MODE;
+            break;
+        case SCREEN_FX:
+            gui_state.sel = SEL_FX_CHORUS;
+            gui_state.subsel.chorus = CHORUS_SUBSEL_ENABLE;
+            break;
+        case SCREEN_FILE:
+            gui_state.sel = SEL_FILE_LIST;
+            wav_import_scan();
+            if (file_state.file_idx >= wav_import_num_files)
+            {
+                file_state.file_idx = 0;
+            }
+            break;
+        case SCREEN_SETTINGS:
+            gui_state.sel = SEL_SETTINGS_HARMONICS;
             break;
         default:
             break;
     }
 
+    spectrum_enable(SCREEN_DEBUG == gui_state.screen);
+
     gui_state.selected = false;
 }
 
-static char * get_osc_shape_str(enum oscillator_shape_e osc_shape)
+static char const * get_osc_shape_str(enum oscillator_shape_e osc_shape)
 {
+    static char const * const user_str[WT_NUM_USER_TABLES] =
+    {
+        "USER 1", "USER 2", "USER 3", "USER 4",
+    };
+
+    if ((osc_shape >= USER_1) && (osc_shape < NUM_OSC_TYPES))
+    {
+        char const * name = wavetable_get_name(osc_shape);
+        return ('\0' != name[0]) ? name : user_str[osc_shape - USER_1];
+    }
+
     switch (osc_shape)
     {
         case SINE:
@@ -615,6 +1638,42 @@ static char * get_osc_shape_str(enum oscillator_shape_e osc_shape)
     }
 }
 
+static char const * get_interp_str(enum wavetable_interp_e interp)
+{
+    switch (interp)
+    {
+        case WT_INTERP_NONE:
+            return "TRUNC";
+        case WT_INTERP_LINEAR:
+            return "LINEAR";
+        case WT_INTERP_CUBIC:
+            return "CUBIC";
+        default:
+            return "Unknown";
+    }
+}
+
+/// Return a pan position as text, "C" at the centre or the side and distance
+/// from it. The string is overwritten by the next call.
+static char const * get_pan_str(uint8_t pan)
+{
+    static char pan_str[4];
+
+    if (WT_PAN_CENTER == pan)
+    {
+        return "C";
+    }
+    else if (pan < WT_PAN_CENTER)
+    {
+        snprintf(pan_str, sizeof(pan_str), "L%d", WT_PAN_CENTER - pan);
+    }
+    else
+    {
+        snprintf(pan_str, sizeof(pan_str), "R%d", pan - WT_PAN_CENTER);
+    }
+    return pan_str;
+}
+
 void gui_nav_right(void)
 {
     switch (gui_state.screen)
@@ -624,6 +1683,22 @@ void gui_nav_right(void)
             break;
         case SCREEN_LFO:
             gui_nav_lfo_right();
+            break;
+        case SCREEN_FILTER:
+            gui_nav_filter_right();
+            break;
+        case SCREEN_FX:
+            gui_nav_fx_right();
+            break;
+        case SCREEN_FILE:
+            gui_nav_file_right();
+            break;
+        case SCREEN_DEBUG:
+            gui_nav_debug_right();
+            break;
+        case SCREEN_SETTINGS:
+            gui_nav_settings_right();
+            break;
         default:
             break;
     }
@@ -638,6 +1713,22 @@ void gui_nav_left(void)
             break;
         case SCREEN_LFO:
             gui_nav_lfo_left();
+            break;
+        case SCREEN_FILTER:
+            gui_nav_filter_left();
+            break;
+        case SCREEN_FX:
+            gui_nav_fx_left();
+            break;
+        case SCREEN_FILE:
+            gui_nav_file_left();
+            break;
+        case SCREEN_DEBUG:
+            gui_nav_debug_left();
+            break;
+        case SCREEN_SETTINGS:
+            gui_nav_settings_left();
+            break;
         default:
             break;
     }
@@ -652,6 +1743,19 @@ void gui_nav_up(void)
             break;
         case SCREEN_LFO:
             gui_nav_lfo_up();
+            break;
+        case SCREEN_FILTER:
+            gui_nav_filter_up();
+            break;
+        case SCREEN_FX:
+            gui_nav_fx_up();
+            break;
+        case SCREEN_FILE:
+            gui_nav_file_up();
+            break;
+        case SCREEN_SETTINGS:
+            gui_nav_settings_up();
+            break;
         default:
             break;
     }
@@ -666,6 +1770,19 @@ void gui_nav_down(void)
             break;
         case SCREEN_LFO:
             gui_nav_lfo_down();
+            break;
+        case SCREEN_FILTER:
+            gui_nav_filter_down();
+            break;
+        case SCREEN_FX:
+            gui_nav_fx_down();
+            break;
+        case SCREEN_FILE:
+            gui_nav_file_down();
+            break;
+        case SCREEN_SETTINGS:
+            gui_nav_settings_down();
+            break;
         default:
             break;
     }
@@ -699,7 +1816,7 @@ static void gui_nav_osc_env_right(void)
                 break;
             case SEL_OSC_2:
                 gui_state.sel = SEL_ENV_1;
-                gui_state.subsel.env = ENV_SUBSEL_A;
+                gui_state.subsel.env = ENV_SUBSEL_SEG;
                 break;
             default:
                 break;
@@ -823,14 +1940,7 @@ static void gui_nav_osc_left(void)
     switch (gui_state.subsel.osc)
     {
         case OSC_SUBSEL_SHAPE:
-            if (SINE == osc->shape)
-            {
-                osc->shape = NONE;
-            }
-            else
-            {
-                --osc->shape;
-            }
+            osc->shape = wavetable_prev_shape(osc->shape);
             break;
         case OSC_SUBSEL_AMP_ENV:
             if (0 == osc->amp_env_idx)
@@ -848,10 +1958,84 @@ static void gui_nav_osc_left(void)
                 --osc->gain;
             }
             break;
-        default:
+        case OSC_SUBSEL_POSITION:
+            if (0 < osc->position)
+            {
+                --osc->position;
+            }
             break;
-    }
-}
+        case OSC_SUBSEL_POS_ENV:
+            if (-MIDI_MAX_DATA_BYTE < osc->pos_env_amt)
+            {
+                --osc->pos_env_amt;
+            }
+            break;
+        case OSC_SUBSEL_INTERP:
+            if (WT_INTERP_NONE == osc->interp)
+            {
+                osc->interp = NUM_WT_INTERP - 1;
+            }
+            else
+            {
+                --osc->interp;
+            }
+            break;
+        case OSC_SUBSEL_DIRECT:
+            osc->direct = !osc->direct;
+            break;
+        case OSC_SUBSEL_COARSE:
+            if (-WT_COARSE_MAX < osc->coarse)
+            {
+                --osc->coarse;
+                voice_retune(gui_state.sel - SEL_OSC_1);
+            }
+            break;
+        case OSC_SUBSEL_FINE:
+            if (-WT_FINE_MAX < osc->fine)
+            {
+                --osc->fine;
+                voice_retune(gui_state.sel - SEL_OSC_1);
+            }
+            break;
+        case OSC_SUBSEL_PHASE:
+            if (0 < osc->phase_offset)
+            {
+                --osc->phase_offset;
+            }
+            break;
+        case OSC_SUBSEL_PAN:
+            if (0 < osc->pan)
+            {
+                --osc->pan;
+            }
+            break;
+        case OSC_SUBSEL_UNISON:
+            if (1 < osc->unison)
+            {
+                --osc->unison;
+                wavetable_update_unison(gui_state.sel - SEL_OSC_1);
+                voice_retune(gui_state.sel - SEL_OSC_1);
+            }
+            break;
+        case OSC_SUBSEL_UNISON_DETUNE:
+            if (0 < osc->unison_detune)
+            {
+                --osc->unison_detune;
+                wavetable_update_unison(gui_state.sel - SEL_OSC_1);
+                voice_retune(gui_state.sel - SEL_OSC_1);
+            }
+            break;
+        case OSC_SUBSEL_UNISON_SPREAD:
+            if (0 < osc->unison_spread)
+            {
+                --osc->unison_spread;
+                wavetable_update_unison(gui_state.sel - SEL_OSC_1);
+            }
+            break;
+        default:
+            break;
+    }
+}
 
 static void gui_nav_osc_right(void)
 {
@@ -859,14 +2043,7 @@ static void gui_nav_osc_right(void)
     switch (gui_state.subsel.osc)
     {
         case OSC_SUBSEL_SHAPE:
-            if (NONE == osc->shape)
-            {
-                osc->shape = SINE;
-            }
-            else
-            {
-                ++osc->shape;
-            }
+            osc->shape = wavetable_next_shape(osc->shape);
             break;
         case OSC_SUBSEL_AMP_ENV:
             if ((NUM_ENVELOPES - 1) == osc->amp_env_idx)
@@ -884,6 +2061,80 @@ static void gui_nav_osc_right(void)
                 ++osc->gain;
             }
             break;
+        case OSC_SUBSEL_POSITION:
+            if (MIDI_MAX_DATA_BYTE > osc->position)
+            {
+                ++osc->position;
+            }
+            break;
+        case OSC_SUBSEL_POS_ENV:
+            if (MIDI_MAX_DATA_BYTE > osc->pos_env_amt)
+            {
+                ++osc->pos_env_amt;
+            }
+            break;
+        case OSC_SUBSEL_INTERP:
+            if ((NUM_WT_INTERP - 1) == osc->interp)
+            {
+                osc->interp = WT_INTERP_NONE;
+            }
+            else
+            {
+                ++osc->interp;
+            }
+            break;
+        case OSC_SUBSEL_DIRECT:
+            osc->direct = !osc->direct;
+            break;
+        case OSC_SUBSEL_COARSE:
+            if (WT_COARSE_MAX > osc->coarse)
+            {
+                ++osc->coarse;
+                voice_retune(gui_state.sel - SEL_OSC_1);
+            }
+            break;
+        case OSC_SUBSEL_FINE:
+            if (WT_FINE_MAX > osc->fine)
+            {
+                ++osc->fine;
+                voice_retune(gui_state.sel - SEL_OSC_1);
+            }
+            break;
+        case OSC_SUBSEL_PHASE:
+            if (MIDI_MAX_DATA_BYTE > osc->phase_offset)
+            {
+                ++osc->phase_offset;
+            }
+            break;
+        case OSC_SUBSEL_PAN:
+            if (MIDI_MAX_DATA_BYTE > osc->pan)
+            {
+                ++osc->pan;
+            }
+            break;
+        case OSC_SUBSEL_UNISON:
+            if (WT_MAX_UNISON > osc->unison)
+            {
+                ++osc->unison;
+                wavetable_update_unison(gui_state.sel - SEL_OSC_1);
+                voice_retune(gui_state.sel - SEL_OSC_1);
+            }
+            break;
+        case OSC_SUBSEL_UNISON_DETUNE:
+            if (MIDI_MAX_DATA_BYTE > osc->unison_detune)
+            {
+                ++osc->unison_detune;
+                wavetable_update_unison(gui_state.sel - SEL_OSC_1);
+                voice_retune(gui_state.sel - SEL_OSC_1);
+            }
+            break;
+        case OSC_SUBSEL_UNISON_SPREAD:
+            if (MIDI_MAX_DATA_BYTE > osc->unison_spread)
+            {
+                ++osc->unison_spread;
+                wavetable_update_unison(gui_state.sel - SEL_OSC_1);
+            }
+            break;
         default:
             break;
     }
@@ -901,6 +2152,39 @@ static void gui_nav_osc_up(void)
         case OSC_SUBSEL_GAIN:
             gui_state.subsel.osc = OSC_SUBSEL_AMP_ENV;
             break;
+        case OSC_SUBSEL_POSITION:
+            gui_state.subsel.osc = OSC_SUBSEL_GAIN;
+            break;
+        case OSC_SUBSEL_POS_ENV:
+            gui_state.subsel.osc = OSC_SUBSEL_POSITION;
+            break;
+        case OSC_SUBSEL_INTERP:
+            gui_state.subsel.osc = OSC_SUBSEL_POS_ENV;
+            break;
+        case OSC_SUBSEL_DIRECT:
+            gui_state.subsel.osc = OSC_SUBSEL_INTERP;
+            break;
+        case OSC_SUBSEL_COARSE:
+            gui_state.subsel.osc = OSC_SUBSEL_DIRECT;
+            break;
+        case OSC_SUBSEL_FINE:
+            gui_state.subsel.osc = OSC_SUBSEL_COARSE;
+            break;
+        case OSC_SUBSEL_PHASE:
+            gui_state.subsel.osc = OSC_SUBSEL_FINE;
+            break;
+        case OSC_SUBSEL_PAN:
+            gui_state.subsel.osc = OSC_SUBSEL_PHASE;
+            break;
+        case OSC_SUBSEL_UNISON:
+            gui_state.subsel.osc = OSC_SUBSEL_PAN;
+            break;
+        case OSC_SUBSEL_UNISON_DETUNE:
+            gui_state.subsel.osc = OSC_SUBSEL_UNISON;
+            break;
+        case OSC_SUBSEL_UNISON_SPREAD:
+            gui_state.subsel.osc = OSC_SUBSEL_UNISON_DETUNE;
+            break;
     }
 }
 
@@ -915,104 +2199,123 @@ static void gui_nav_osc_down(void)
             gui_state.subsel.osc = OSC_SUBSEL_GAIN;
             break;
         case OSC_SUBSEL_GAIN:
+            gui_state.subsel.osc = OSC_SUBSEL_POSITION;
+            break;
+        case OSC_SUBSEL_POSITION:
+            gui_state.subsel.osc = OSC_SUBSEL_POS_ENV;
+            break;
+        case OSC_SUBSEL_POS_ENV:
+            gui_state.subsel.osc = OSC_SUBSEL_INTERP;
+            break;
+        case OSC_SUBSEL_INTERP:
+            gui_state.subsel.osc = OSC_SUBSEL_DIRECT;
+            break;
+        case OSC_SUBSEL_DIRECT:
+            gui_state.subsel.osc = OSC_SUBSEL_COARSE;
+            break;
+        case OSC_SUBSEL_COARSE:
+            gui_state.subsel.osc = OSC_SUBSEL_FINE;
+            break;
+        case OSC_SUBSEL_FINE:
+            gui_state.subsel.osc = OSC_SUBSEL_PHASE;
+            break;
+        case OSC_SUBSEL_PHASE:
+            gui_state.subsel.osc = OSC_SUBSEL_PAN;
+            break;
+        case OSC_SUBSEL_PAN:
+            gui_state.subsel.osc = OSC_SUBSEL_UNISON;
+            break;
+        case OSC_SUBSEL_UNISON:
+            gui_state.subsel.osc = OSC_SUBSEL_UNISON_DETUNE;
+            break;
+        case OSC_SUBSEL_UNISON_DETUNE:
+            gui_state.subsel.osc = OSC_SUBSEL_UNISON_SPREAD;
+            break;
+        case OSC_SUBSEL_UNISON_SPREAD:
             break;
     }
 }
 
 #define ENV_RATE_GRANULE (MIDI_MAX_NRPN_VAL / MIDI_MAX_DATA_BYTE)
-#define SUSTAIN_GRANULE (UINT32_MAX/ MIDI_MAX_DATA_BYTE)
+#define ENV_LEVEL_GRANULE (UINT32_MAX/ MIDI_MAX_DATA_BYTE)
 
 static void gui_nav_env_left(void)
 {
-    switch (gui_state.subsel.env)
+    if (ENV_SUBSEL_SEG < gui_state.subsel.env)
     {
-        case ENV_SUBSEL_D:
-            gui_state.subsel.env = ENV_SUBSEL_A;
-            break;
-
-        case ENV_SUBSEL_S:
-            gui_state.subsel.env = ENV_SUBSEL_D;
-            break;
-
-        case ENV_SUBSEL_R:
-            gui_state.subsel.env = ENV_SUBSEL_S;
-            break;
-
-        default:
-            break;
+        --gui_state.subsel.env;
     }
 }
 
 static void gui_nav_env_right(void)
 {
-    switch (gui_state.subsel.env)
+    if ((NUM_ENV_SUBSELS - 1) > gui_state.subsel.env)
     {
-        case ENV_SUBSEL_A:
-            gui_state.subsel.env = ENV_SUBSEL_D;
-            break;
-
-        case ENV_SUBSEL_D:
-            gui_state.subsel.env = ENV_SUBSEL_S;
-            break;
-
-        case ENV_SUBSEL_S:
-            gui_state.subsel.env = ENV_SUBSEL_R;
-            break;
-
-        default:
-            break;
+        ++gui_state.subsel.env;
     }
 }
 
 static void gui_nav_env_down(void)
 {
-    struct envelope_s * env = &envelopes[gui_state.sel - SEL_ENV_1];
+    uint8_t const env_idx = gui_state.sel - SEL_ENV_1;
+    struct envelope_s * env = &envelopes[env_idx];
+    uint8_t const seg = gui_get_env_seg(env);
+    struct envelope_segment_s * segment = &env->segments[seg];
+
     switch (gui_state.subsel.env)
     {
-        case ENV_SUBSEL_A:
-            if (ENV_RATE_GRANULE <= env->attack)
+        case ENV_SUBSEL_SEG:
+            if (0 < env_seg)
             {
-                env->attack -= ENV_RATE_GRANULE;
-            }
-            else
-            {
-                env->attack = 0;
+                --env_seg;
             }
             break;
 
-        case ENV_SUBSEL_D:
-            if (ENV_RATE_GRANULE <= env->decay)
+        case ENV_SUBSEL_TIME:
+            if (ENV_RATE_GRANULE <= segment->time)
             {
-                env->decay -= ENV_RATE_GRANULE;
+                envelope_set_time(env_idx, seg, segment->time - ENV_RATE_GRANULE);
             }
             else
             {
-                env->decay = 0;
+                envelope_set_time(env_idx, seg, 0);
             }
             break;
 
-        case ENV_SUBSEL_S:
-            if (SUSTAIN_GRANULE <= env->sustain_level)
+        case ENV_SUBSEL_LEVEL:
+            if (ENV_LEVEL_GRANULE <= segment->target)
             {
-                env->sustain_level -= SUSTAIN_GRANULE;
+                envelope_set_target(env_idx, seg, segment->target - ENV_LEVEL_GRANULE);
             }
             else
             {
-                env->sustain_level = 0;
+                envelope_set_target(env_idx, seg, 0);
+            }
+            break;
+
+        case ENV_SUBSEL_CURVE:
+            if (ENV_CURVE_LINEAR < segment->curve)
+            {
+                envelope_set_curve(env_idx, seg, segment->curve - 1);
             }
             break;
 
-        case ENV_SUBSEL_R:
-            if (ENV_RATE_GRANULE <= env->release)
+        case ENV_SUBSEL_POINT:
+            // Down toggles the loop back to this segment.
+            if (seg == env->loop)
             {
-                env->release -= ENV_RATE_GRANULE;
+                envelope_set_loop(env_idx, ENV_NO_LOOP);
             }
             else
             {
-                env->release = 0;
+                envelope_set_loop(env_idx, seg);
             }
             break;
 
+        case ENV_SUBSEL_NUM:
+            envelope_set_num_segments(env_idx, env->num_segments - 1);
+            break;
+
         default:
             break;
     }
@@ -1020,50 +2323,58 @@ static void gui_nav_env_down(void)
 
 static void gui_nav_env_up(void)
 {
-    struct envelope_s * env = &envelopes[gui_state.sel - SEL_ENV_1];
+    uint8_t const env_idx = gui_state.sel - SEL_ENV_1;
+    struct envelope_s * env = &envelopes[env_idx];
+    uint8_t const seg = gui_get_env_seg(env);
+    struct envelope_segment_s * segment = &env->segments[seg];
+
     switch (gui_state.subsel.env)
     {
-        case ENV_SUBSEL_A:
-            if ((MIDI_MAX_NRPN_VAL - ENV_RATE_GRANULE) >= env->attack)
-            {
-                env->attack += ENV_RATE_GRANULE;
-            }
-            else
+        case ENV_SUBSEL_SEG:
+            if ((env->num_segments - 1) > env_seg)
             {
-                env->attack = MIDI_MAX_NRPN_VAL;
+                ++env_seg;
             }
             break;
 
-        case ENV_SUBSEL_D:
-            if ((MIDI_MAX_NRPN_VAL - ENV_RATE_GRANULE) >= env->decay)
+        case ENV_SUBSEL_TIME:
+            if ((MIDI_MAX_NRPN_VAL - ENV_RATE_GRANULE) >= segment->time)
             {
-                env->decay += ENV_RATE_GRANULE;
+                envelope_set_time(env_idx, seg, segment->time + ENV_RATE_GRANULE);
             }
             else
             {
-                env->decay = MIDI_MAX_NRPN_VAL;
+                envelope_set_time(env_idx, seg, MIDI_MAX_NRPN_VAL);
             }
             break;
-        case ENV_SUBSEL_S:
-            if ((UINT32_MAX - SUSTAIN_GRANULE) >= env->sustain_level)
+
+        case ENV_SUBSEL_LEVEL:
+            if ((UINT32_MAX - ENV_LEVEL_GRANULE) >= segment->target)
             {
-                env->sustain_level += SUSTAIN_GRANULE;
+                envelope_set_target(env_idx, seg, segment->target + ENV_LEVEL_GRANULE);
             }
             else
             {
-                env->sustain_level = UINT32_MAX;
+                envelope_set_target(env_idx, seg, UINT32_MAX);
             }
             break;
-        case ENV_SUBSEL_R:
-            if ((MIDI_MAX_NRPN_VAL - ENV_RATE_GRANULE) >= env->release)
-            {
-                env->release += ENV_RATE_GRANULE;
-            }
-            else
+
+        case ENV_SUBSEL_CURVE:
+            if ((NUM_ENV_CURVES - 1) > segment->curve)
             {
-                env->release = MIDI_MAX_NRPN_VAL;
+                envelope_set_curve(env_idx, seg, segment->curve + 1);
             }
             break;
+
+        case ENV_SUBSEL_POINT:
+            // Up makes this the last segment before the envelope sustains.
+            envelope_set_sustain_point(env_idx, seg + 1);
+            break;
+
+        case ENV_SUBSEL_NUM:
+            envelope_set_num_segments(env_idx, env->num_segments + 1);
+            break;
+
         default:
             break;
     }
@@ -1073,6 +2384,20 @@ static void gui_nav_env_up(void)
 
 static void gui_nav_lfo_left(void)
 {
+    if (SEL_MOD_MATRIX == gui_state.sel)
+    {
+        if (gui_state.selected)
+        {
+            gui_nav_mod_adjust(false);
+        }
+        else
+        {
+            gui_state.sel = SEL_LFO_2;
+            gui_state.subsel.lfo = LFO_SUBSEL_SHAPE;
+        }
+        return;
+    }
+
     uint8_t lfo_idx = (gui_state.sel - SEL_LFO_1);
     if (gui_state.selected)
     {
@@ -1080,10 +2405,15 @@ static void gui_nav_lfo_left(void)
         switch (gui_state.subsel.lfo)
         {
             case LFO_SUBSEL_SHAPE:
+                // LFOs cycle through the generated shapes only.
                 if (SINE == lfo->shape)
                 {
                     lfo->shape = NONE;
                 }
+                else if (NONE == lfo->shape)
+                {
+                    lfo->shape = NUM_GEN_TYPES - 1;
+                }
                 else
                 {
                     --lfo->shape;
@@ -1113,11 +2443,14 @@ static void gui_nav_lfo_left(void)
                 }
                 break;
 
-            case LFO_SUBSEL_DST_AMP:
-                lfo->dst ^= LFO_DST_AMP;
+            case LFO_SUBSEL_SYNC:
+                if (LFO_SYNC_GLOBAL != lfo->sync)
+                {
+                    --lfo->sync;
+                }
                 break;
-            case LFO_SUBSEL_DST_PITCH:
-                lfo->dst ^= LFO_DST_FREQ;
+            case LFO_SUBSEL_DIRECT:
+                lfo->direct = !lfo->direct;
                 break;
 
             default:
@@ -1135,6 +2468,15 @@ static void gui_nav_lfo_left(void)
 
 static void gui_nav_lfo_right(void)
 {
+    if (SEL_MOD_MATRIX == gui_state.sel)
+    {
+        if (gui_state.selected)
+        {
+            gui_nav_mod_adjust(true);
+        }
+        return;
+    }
+
     uint8_t lfo_idx = (gui_state.sel - SEL_LFO_1);
     if (gui_state.selected)
     {
@@ -1146,6 +2488,10 @@ static void gui_nav_lfo_right(void)
                 {
                     lfo->shape = SINE;
                 }
+                else if ((NUM_GEN_TYPES - 1) == lfo->shape)
+                {
+                    lfo->shape = NONE;
+                }
                 else
                 {
                     ++lfo->shape;
@@ -1168,11 +2514,14 @@ static void gui_nav_lfo_right(void)
                 }
                 break;
 
-            case LFO_SUBSEL_DST_AMP:
-                lfo->dst ^= LFO_DST_AMP;
+            case LFO_SUBSEL_SYNC:
+                if ((NUM_LFO_SYNCS - 1) != lfo->sync)
+                {
+                    ++lfo->sync;
+                }
                 break;
-            case LFO_SUBSEL_DST_PITCH:
-                lfo->dst ^= LFO_DST_FREQ;
+            case LFO_SUBSEL_DIRECT:
+                lfo->direct = !lfo->direct;
                 break;
 
         default:
@@ -1181,16 +2530,24 @@ static void gui_nav_lfo_right(void)
     }
     else
     {
-        if (NUM_LFOS != (1 + lfo_idx))
+        ++gui_state.sel;
+        if (SEL_MOD_MATRIX == gui_state.sel)
         {
-            ++gui_state.sel;
+            gui_state.subsel.mod = 0;
         }
     }
 }
 
 static void gui_nav_lfo_up(void)
 {
-    if (gui_state.selected)
+    if (gui_state.selected && (SEL_MOD_MATRIX == gui_state.sel))
+    {
+        if (0 != gui_state.subsel.mod)
+        {
+            --gui_state.subsel.mod;
+        }
+    }
+    else if (gui_state.selected)
     {
         if (LFO_SUBSEL_SHAPE != gui_state.subsel.lfo)
         {
@@ -1202,9 +2559,16 @@ static void gui_nav_lfo_up(void)
 
 static void gui_nav_lfo_down(void)
 {
-    if (gui_state.selected)
+    if (gui_state.selected && (SEL_MOD_MATRIX == gui_state.sel))
+    {
+        if (((MOD_MATRIX_SLOTS * NUM_MOD_COLS) - 1) != gui_state.subsel.mod)
+        {
+            ++gui_state.subsel.mod;
+        }
+    }
+    else if (gui_state.selected)
     {
-        if (LFO_SUBSEL_DST_PITCH != gui_state.subsel.lfo)
+        if (LFO_SUBSEL_DIRECT != gui_state.subsel.lfo)
         {
             ++gui_state.subsel.lfo;
         }
@@ -1212,41 +2576,977 @@ static void gui_nav_lfo_down(void)
     // else no action
 }
 
-void gui_select(void)
+static char const * get_filter_mode_str(enum filter_mode_e mode)
 {
-    if (!gui_state.selected)
-    {
-        gui_state.selected = true;
-    }
-    else
-    {
-        gui_deselect();
+    switch (mode)
+    {
+        case FILTER_OFF:
+            return "OFF";
+        case FILTER_LP:
+            return "LOW PASS";
+        case FILTER_BP:
+            return "BAND PASS";
+        case FILTER_HP:
+            return "HIGH PASS";
+        default:
+            return "Unknown";
     }
 }
 
-void gui_deselect(void)
+static void gui_draw_filter(void)
 {
-    gui_state.selected = false;
+    int const x_base = 40;
+    int const y_base = 45;
+
+    rdpq_set_mode_fill((SEL_FILTER == gui_state.sel) ? color_blue : color_gray);
+    rdpq_fill_rectangle(x_base - 4, y_base - 10, x_base + 130, y_base + 63);
+
+    if (gui_state.selected && (SEL_FILTER == gui_state.sel))
+    {
+        int const y_row = y_base + 1 + (10 * gui_state.subsel.filter);
+
+        rdpq_set_mode_fill(color_green);
+        rdpq_fill_rectangle(x_base - 2, y_row, x_base + 128, y_row + 11);
+    }
+
+    rdpq_text_print(NULL, 1, x_base, y_base, "FILTER");
+    rdpq_text_printf(NULL, 1, x_base, y_base + 10, "MODE: %s", get_filter_mode_str(filter.mode));
+    rdpq_text_printf(NULL, 1, x_base, y_base + 20, "CUTOFF: %.0f Hz",
+                     filter_get_cutoff_hz(filter.cutoff));
+    rdpq_text_printf(NULL, 1, x_base, y_base + 30, "RESONANCE: %u", (unsigned int)filter.resonance);
+    rdpq_text_printf(NULL, 1, x_base, y_base + 40, "ENV: ENV %d", filter.env_idx + 1);
+    rdpq_text_printf(NULL, 1, x_base, y_base + 50, "ENV AMT: %+d", filter.env_amt);
+    rdpq_text_printf(NULL, 1, x_base, y_base + 60, "KEY TRACK: %u%%",
+                     (unsigned int)((filter.key_track * 100) / MIDI_MAX_DATA_BYTE));
 }
 
-bool gui_recv_continuous_input(joypad_buttons_t buttons_pressed)
+static void gui_nav_filter_left(void)
 {
-    bool ret = false;
-
     if (gui_state.selected)
     {
-        if ((buttons_pressed.d_left || buttons_pressed.d_right)
-            && (((SEL_OSC_1 == gui_state.sel) || (SEL_OSC_2 == gui_state.sel))
-                && (OSC_SUBSEL_GAIN == gui_state.subsel.osc)))
+        switch (gui_state.subsel.filter)
         {
-            ret = true;
+            case FILTER_SUBSEL_MODE:
+                if (FILTER_OFF == filter.mode)
+                {
+                    filter.mode = NUM_FILTER_MODES - 1;
+                }
+                else
+                {
+                    --filter.mode;
+                }
+                break;
+            case FILTER_SUBSEL_CUTOFF:
+                if (0 < filter.cutoff)
+                {
+                    --filter.cutoff;
+                }
+                break;
+            case FILTER_SUBSEL_RESONANCE:
+                if (0 < filter.resonance)
+                {
+                    filter_set_resonance(filter.resonance - 1);
+                }
+                break;
+            case FILTER_SUBSEL_ENV:
+                if (0 == filter.env_idx)
+                {
+                    filter.env_idx = NUM_ENVELOPES - 1;
+                }
+                else
+                {
+                    --filter.env_idx;
+                }
+                break;
+            case FILTER_SUBSEL_ENV_AMT:
+                if (-MIDI_MAX_DATA_BYTE < filter.env_amt)
+                {
+                    --filter.env_amt;
+                }
+                break;
+            case FILTER_SUBSEL_KEY_TRACK:
+                if (0 < filter.key_track)
+                {
+                    --filter.key_track;
+                }
+                break;
+            default:
+                break;
         }
-        else if ((buttons_pressed.d_up || buttons_pressed.d_down)
-                 && ((SEL_ENV_1 == gui_state.sel)
-                     || (SEL_ENV_2 == gui_state.sel)
-                     || (SEL_ENV_3 == gui_state.sel)))
+    }
+    // else no action
+}
+
+static void gui_nav_filter_right(void)
+{
+    if (gui_state.selected)
+    {
+        switch (gui_state.subsel.filter)
         {
-            ret = true;
+            case FILTER_SUBSEL_MODE:
+                if ((NUM_FILTER_MODES - 1) == filter.mode)
+                {
+                    filter.mode = FILTER_OFF;
+                }
+                else
+                {
+                    ++filter.mode;
+                }
+                break;
+            case FILTER_SUBSEL_CUTOFF:
+                if (FILTER_PITCH_MAX > filter.cutoff)
+                {
+                    ++filter.cutoff;
+                }
+                break;
+            case FILTER_SUBSEL_RESONANCE:
+                if (MIDI_MAX_DATA_BYTE > filter.resonance)
+                {
+                    filter_set_resonance(filter.resonance + 1);
+                }
+                break;
+            case FILTER_SUBSEL_ENV:
+                if ((NUM_ENVELOPES - 1) == filter.env_idx)
+                {
+                    filter.env_idx = 0;
+                }
+                else
+                {
+                    ++filter.env_idx;
+                }
+                break;
+            case FILTER_SUBSEL_ENV_AMT:
+                if (MIDI_MAX_DATA_BYTE > filter.env_amt)
+                {
+                    ++filter.env_amt;
+                }
+                break;
+            case FILTER_SUBSEL_KEY_TRACK:
+                if (MIDI_MAX_DATA_BYTE > filter.key_track)
+                {
+                    ++filter.key_track;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    // else no action
+}
+
+static void gui_nav_filter_up(void)
+{
+    if (gui_state.selected)
+    {
+        if (FILTER_SUBSEL_MODE != gui_state.subsel.filter)
+        {
+            --gui_state.subsel.filter;
+        }
+    }
+    // else no action
+}
+
+static void gui_nav_filter_down(void)
+{
+    if (gui_state.selected)
+    {
+        if (FILTER_SUBSEL_KEY_TRACK != gui_state.subsel.filter)
+        {
+            ++gui_state.subsel.filter;
+        }
+    }
+    // else no action
+}
+
+static char const * get_delay_division_str(enum delay_division_e division)
+{
+    switch (division)
+    {
+        case DELAY_DIV_HALF:
+            return "1/2";
+        case DELAY_DIV_QUARTER_DOTTED:
+            return "1/4.";
+        case DELAY_DIV_QUARTER:
+            return "1/4";
+        case DELAY_DIV_EIGHTH_DOTTED:
+            return "1/8.";
+        case DELAY_DIV_QUARTER_TRIPLET:
+            return "1/4T";
+        case DELAY_DIV_EIGHTH:
+            return "1/8";
+        case DELAY_DIV_EIGHTH_TRIPLET:
+            return "1/8T";
+        case DELAY_DIV_SIXTEENTH:
+            return "1/16";
+        default:
+            return "Unknown";
+    }
+}
+
+static void gui_draw_fx(void)
+{
+    gui_draw_chorus(40, 45);
+    gui_draw_delay(180, 45);
+    gui_draw_reverb(320, 45);
+}
+
+static void gui_draw_chorus(int x_base, int y_base)
+{
+    rdpq_set_mode_fill((SEL_FX_CHORUS == gui_state.sel) ? color_blue : color_gray);
+    rdpq_fill_rectangle(x_base - 4, y_base - 10, x_base + 130, y_base + 63);
+
+    if (gui_state.selected && (SEL_FX_CHORUS == gui_state.sel))
+    {
+        int const y_row = y_base + 1 + (10 * gui_state.subsel.chorus);
+
+        rdpq_set_mode_fill(color_green);
+        rdpq_fill_rectangle(x_base - 2, y_row, x_base + 128, y_row + 11);
+    }
+
+    rdpq_text_printf(NULL, 1, x_base, y_base, "CHORUS %8u KB",
+                     (unsigned)(chorus_get_mem_bytes() / 1024));
+    rdpq_text_printf(NULL, 1, x_base, y_base + 10, "ON: %c", chorus.enabled ? 'Y':'N');
+    rdpq_text_printf(NULL, 1, x_base, y_base + 20, "RATE: %u", (unsigned int)chorus.rate);
+    rdpq_text_printf(NULL, 1, x_base, y_base + 30, "DEPTH: %u", (unsigned int)chorus.depth);
+    rdpq_text_printf(NULL, 1, x_base, y_base + 40, "DELAY: %u", (unsigned int)chorus.delay);
+    rdpq_text_printf(NULL, 1, x_base, y_base + 50, "MIX: %u", (unsigned int)chorus.mix);
+    rdpq_text_printf(NULL, 1, x_base, y_base + 60, "SPREAD: %u", (unsigned int)chorus.spread);
+}
+
+static void gui_draw_delay(int x_base, int y_base)
+{
+    rdpq_set_mode_fill((SEL_FX_DELAY == gui_state.sel) ? color_blue : color_gray);
+    rdpq_fill_rectangle(x_base - 4, y_base - 10, x_base + 130, y_base + 83);
+
+    if (gui_state.selected && (SEL_FX_DELAY == gui_state.sel))
+    {
+        int const y_row = y_base + 1 + (10 * gui_state.subsel.delay);
+
+        rdpq_set_mode_fill(color_green);
+        rdpq_fill_rectangle(x_base - 2, y_row, x_base + 128, y_row + 11);
+    }
+
+    bool delay_clamped = false;
+    uint32_t const delay_ms = (delay_get_frames(&delay_clamped) * 1000u) / SAMPLE_RATE;
+
+    rdpq_text_printf(NULL, 1, x_base, y_base, "DELAY %9u KB",
+                     (unsigned)(delay_get_mem_bytes() / 1024));
+    rdpq_text_printf(NULL, 1, x_base, y_base + 10, "ON: %c", delay.enabled ? 'Y':'N');
+    // A division longer than the line at this tempo is held at the line's
+    // length, which is flagged rather than shown as if still in time.
+    if (delay_clamped)
+    {
+        rdpq_text_printf(NULL, 1, x_base, y_base + 20, "TIME: %s MAX",
+                         get_delay_division_str(delay.division));
+    }
+    else
+    {
+        rdpq_text_printf(NULL, 1, x_base, y_base + 20, "TIME: %s %lums",
+                         get_delay_division_str(delay.division), delay_ms);
+    }
+    rdpq_text_printf(NULL, 1, x_base, y_base + 30, "SYNC: %s",
+                     (TEMPO_MIDI == tempo.source) ? "MIDI CLOCK" : "MANUAL");
+    rdpq_text_printf(NULL, 1, x_base, y_base + 40, "BPM: %.1f", tempo_get_bpm());
+    rdpq_text_printf(NULL, 1, x_base, y_base + 50, "FEEDBACK: %u", (unsigned int)delay.feedback);
+    rdpq_text_printf(NULL, 1, x_base, y_base + 60, "DAMPING: %u", (unsigned int)delay.damping);
+    rdpq_text_printf(NULL, 1, x_base, y_base + 70, "MIX: %u", (unsigned int)delay.mix);
+    rdpq_text_printf(NULL, 1, x_base, y_base + 80, "PING PONG: %c", delay.ping_pong ? 'Y':'N');
+}
+
+static char const * get_reverb_quality_str(enum reverb_quality_e quality)
+{
+    switch (quality)
+    {
+        case REVERB_QUALITY_LOW:
+            return "LOW";
+        case REVERB_QUALITY_MEDIUM:
+            return "MEDIUM";
+        case REVERB_QUALITY_HIGH:
+            return "HIGH";
+        default:
+            return "Unknown";
+    }
+}
+
+static void gui_draw_reverb(int x_base, int y_base)
+{
+    rdpq_set_mode_fill((SEL_FX_REVERB == gui_state.sel) ? color_blue : color_gray);
+    rdpq_fill_rectangle(x_base - 4, y_base - 10, x_base + 130, y_base + 63);
+
+    if (gui_state.selected && (SEL_FX_REVERB == gui_state.sel))
+    {
+        int const y_row = y_base + 1 + (10 * gui_state.subsel.reverb);
+
+        rdpq_set_mode_fill(color_green);
+        rdpq_fill_rectangle(x_base - 2, y_row, x_base + 128, y_row + 11);
+    }
+
+    rdpq_text_printf(NULL, 1, x_base, y_base, "REVERB %8u KB",
+                     (unsigned)(reverb_get_mem_bytes() / 1024));
+    rdpq_text_printf(NULL, 1, x_base, y_base + 10, "ON: %c", reverb.enabled ? 'Y':'N');
+    rdpq_text_printf(NULL, 1, x_base, y_base + 20, "QUALITY: %s", get_reverb_quality_str(reverb.quality));
+    rdpq_text_printf(NULL, 1, x_base, y_base + 30, "SIZE: %u", (unsigned int)reverb.size);
+    rdpq_text_printf(NULL, 1, x_base, y_base + 40, "DAMPING: %u", (unsigned int)reverb.damping);
+    rdpq_text_printf(NULL, 1, x_base, y_base + 50, "MIX: %u", (unsigned int)reverb.mix);
+    rdpq_text_printf(NULL, 1, x_base, y_base + 60, "WIDTH: %u", (unsigned int)reverb.width);
+}
+
+static void gui_nav_fx_left(void)
+{
+    if (gui_state.selected)
+    {
+        if (SEL_FX_CHORUS == gui_state.sel)
+        {
+            gui_nav_chorus_adjust(false);
+        }
+        else if (SEL_FX_DELAY == gui_state.sel)
+        {
+            gui_nav_delay_adjust(false);
+        }
+        else if (SEL_FX_REVERB == gui_state.sel)
+        {
+            gui_nav_reverb_adjust(false);
+        }
+    }
+    else if (SEL_FX_CHORUS != gui_state.sel)
+    {
+        --gui_state.sel;
+        gui_state.subsel.delay = DELAY_SUBSEL_ENABLE;
+    }
+}
+
+static void gui_nav_fx_right(void)
+{
+    if (gui_state.selected)
+    {
+        if (SEL_FX_CHORUS == gui_state.sel)
+        {
+            gui_nav_chorus_adjust(true);
+        }
+        else if (SEL_FX_DELAY == gui_state.sel)
+        {
+            gui_nav_delay_adjust(true);
+        }
+        else if (SEL_FX_REVERB == gui_state.sel)
+        {
+            gui_nav_reverb_adjust(true);
+        }
+    }
+    else if (SEL_FX_REVERB != gui_state.sel)
+    {
+        ++gui_state.sel;
+        gui_state.subsel.reverb = REVERB_SUBSEL_ENABLE;
+    }
+}
+
+static void gui_nav_fx_up(void)
+{
+    if (gui_state.selected && (SEL_FX_CHORUS == gui_state.sel))
+    {
+        if (CHORUS_SUBSEL_ENABLE != gui_state.subsel.chorus)
+        {
+            --gui_state.subsel.chorus;
+        }
+    }
+    else if (gui_state.selected && (SEL_FX_DELAY == gui_state.sel))
+    {
+        if (DELAY_SUBSEL_ENABLE != gui_state.subsel.delay)
+        {
+            --gui_state.subsel.delay;
+        }
+    }
+    else if (gui_state.selected && (SEL_FX_REVERB == gui_state.sel))
+    {
+        if (REVERB_SUBSEL_ENABLE != gui_state.subsel.reverb)
+        {
+            --gui_state.subsel.reverb;
+        }
+    }
+    // else no action
+}
+
+static void gui_nav_fx_down(void)
+{
+    if (gui_state.selected && (SEL_FX_CHORUS == gui_state.sel))
+    {
+        if (CHORUS_SUBSEL_SPREAD != gui_state.subsel.chorus)
+        {
+            ++gui_state.subsel.chorus;
+        }
+    }
+    else if (gui_state.selected && (SEL_FX_DELAY == gui_state.sel))
+    {
+        if (DELAY_SUBSEL_PING_PONG != gui_state.subsel.delay)
+        {
+            ++gui_state.subsel.delay;
+        }
+    }
+    else if (gui_state.selected && (SEL_FX_REVERB == gui_state.sel))
+    {
+        if (REVERB_SUBSEL_WIDTH != gui_state.subsel.reverb)
+        {
+            ++gui_state.subsel.reverb;
+        }
+    }
+    // else no action
+}
+
+/// Step the selected reverb setting one way or the other. Switches toggle
+/// either way.
+static void gui_nav_reverb_adjust(bool increase)
+{
+    switch (gui_state.subsel.reverb)
+    {
+        case REVERB_SUBSEL_ENABLE:
+            reverb.enabled = !reverb.enabled;
+            fx_update();
+            break;
+        case REVERB_SUBSEL_QUALITY:
+            if (increase && ((NUM_REVERB_QUALITIES - 1) > reverb.quality))
+            {
+                reverb_set_quality(reverb.quality + 1);
+            }
+            else if (!increase && (REVERB_QUALITY_LOW < reverb.quality))
+            {
+                reverb_set_quality(reverb.quality - 1);
+            }
+            break;
+        case REVERB_SUBSEL_SIZE:
+            if (increase && (MIDI_MAX_DATA_BYTE > reverb.size))
+            {
+                ++reverb.size;
+            }
+            else if (!increase && (0 < reverb.size))
+            {
+                --reverb.size;
+            }
+            break;
+        case REVERB_SUBSEL_DAMPING:
+            if (increase && (MIDI_MAX_DATA_BYTE > reverb.damping))
+            {
+                ++reverb.damping;
+            }
+            else if (!increase && (0 < reverb.damping))
+            {
+                --reverb.damping;
+            }
+            break;
+        case REVERB_SUBSEL_MIX:
+            if (increase && (MIDI_MAX_DATA_BYTE > reverb.mix))
+            {
+                ++reverb.mix;
+            }
+            else if (!increase && (0 < reverb.mix))
+            {
+                --reverb.mix;
+            }
+            break;
+        case REVERB_SUBSEL_WIDTH:
+            if (increase && (MIDI_MAX_DATA_BYTE > reverb.width))
+            {
+                ++reverb.width;
+            }
+            else if (!increase && (0 < reverb.width))
+            {
+                --reverb.width;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/// Step the selected delay setting one way or the other. Switches toggle
+/// either way.
+/// Step the selected chorus setting one way or the other. Switches toggle
+/// either way.
+static void gui_nav_chorus_adjust(bool increase)
+{
+    switch (gui_state.subsel.chorus)
+    {
+        case CHORUS_SUBSEL_ENABLE:
+            chorus.enabled = !chorus.enabled;
+            fx_update();
+            break;
+        case CHORUS_SUBSEL_RATE:
+            if (increase && (MIDI_MAX_DATA_BYTE > chorus.rate))
+            {
+                chorus_set_rate(chorus.rate + 1);
+            }
+            else if (!increase && (0 < chorus.rate))
+            {
+                chorus_set_rate(chorus.rate - 1);
+            }
+            break;
+        case CHORUS_SUBSEL_DEPTH:
+            if (increase && (MIDI_MAX_DATA_BYTE > chorus.depth))
+            {
+                ++chorus.depth;
+            }
+            else if (!increase && (0 < chorus.depth))
+            {
+                --chorus.depth;
+            }
+            break;
+        case CHORUS_SUBSEL_DELAY:
+            if (increase && (MIDI_MAX_DATA_BYTE > chorus.delay))
+            {
+                ++chorus.delay;
+            }
+            else if (!increase && (0 < chorus.delay))
+            {
+                --chorus.delay;
+            }
+            break;
+        case CHORUS_SUBSEL_MIX:
+            if (increase && (MIDI_MAX_DATA_BYTE > chorus.mix))
+            {
+                ++chorus.mix;
+            }
+            else if (!increase && (0 < chorus.mix))
+            {
+                --chorus.mix;
+            }
+            break;
+        case CHORUS_SUBSEL_SPREAD:
+            if (increase && (MIDI_MAX_DATA_BYTE > chorus.spread))
+            {
+                ++chorus.spread;
+            }
+            else if (!increase && (0 < chorus.spread))
+            {
+                --chorus.spread;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void gui_nav_delay_adjust(bool increase)
+{
+    switch (gui_state.subsel.delay)
+    {
+        case DELAY_SUBSEL_ENABLE:
+            delay.enabled = !delay.enabled;
+            fx_update();
+            break;
+        case DELAY_SUBSEL_DIVISION:
+            // Longest division first, so right shortens the delay.
+            if (increase && ((NUM_DELAY_DIVS - 1) > delay.division))
+            {
+                ++delay.division;
+            }
+            else if (!increase && (0 < delay.division))
+            {
+                --delay.division;
+            }
+            break;
+        case DELAY_SUBSEL_SYNC:
+            tempo_set_source((TEMPO_MIDI == tempo.source) ? TEMPO_MANUAL : TEMPO_MIDI);
+            break;
+        case DELAY_SUBSEL_BPM:
+            if (increase && (TEMPO_BPM_MAX > tempo.bpm))
+            {
+                tempo_set_bpm(tempo.bpm + 1);
+            }
+            else if (!increase && (TEMPO_BPM_MIN < tempo.bpm))
+            {
+                tempo_set_bpm(tempo.bpm - 1);
+            }
+            break;
+        case DELAY_SUBSEL_FEEDBACK:
+            if (increase && (MIDI_MAX_DATA_BYTE > delay.feedback))
+            {
+                ++delay.feedback;
+            }
+            else if (!increase && (0 < delay.feedback))
+            {
+                --delay.feedback;
+            }
+            break;
+        case DELAY_SUBSEL_DAMPING:
+            if (increase && (MIDI_MAX_DATA_BYTE > delay.damping))
+            {
+                ++delay.damping;
+            }
+            else if (!increase && (0 < delay.damping))
+            {
+                --delay.damping;
+            }
+            break;
+        case DELAY_SUBSEL_MIX:
+            if (increase && (MIDI_MAX_DATA_BYTE > delay.mix))
+            {
+                ++delay.mix;
+            }
+            else if (!increase && (0 < delay.mix))
+            {
+                --delay.mix;
+            }
+            break;
+        case DELAY_SUBSEL_PING_PONG:
+            delay.ping_pong = !delay.ping_pong;
+            break;
+        default:
+            break;
+    }
+}
+
+#define HARMONICS_GRANULE 8
+#define VOICE_CULL_DB_GRANULE 6
+#define HARMONICS_MAX ((WT_SIZE / 2) - 1)
+
+static void gui_draw_settings(void)
+{
+    int const x_base = 40;
+    int const y_base = 45;
+
+    rdpq_set_mode_fill((SEL_SETTINGS_HARMONICS == gui_state.sel) ? color_blue : color_gray);
+    rdpq_fill_rectangle(x_base - 4, y_base - 10, x_base + 196, y_base + 23);
+
+    if (gui_state.selected && (SEL_SETTINGS_HARMONICS == gui_state.sel))
+    {
+        rdpq_set_mode_fill(color_green);
+        rdpq_fill_rectangle(x_base - 2, y_base + 1, x_base + 194, y_base + 12);
+    }
+
+    rdpq_text_print(NULL, 1, x_base, y_base, "WAVETABLES");
+    rdpq_text_printf(NULL, 1, x_base, y_base + 10, "HARMONICS: %u",
+                     (unsigned int)wavetable_get_num_harmonics());
+    rdpq_text_print(NULL, 1, x_base, y_base + 20,
+                    wavetable_is_building() ? "STATUS: BUILDING" : "STATUS: READY");
+
+    int const y_voices = y_base + 40;
+
+    rdpq_set_mode_fill(((SEL_SETTINGS_VOICE_PAN == gui_state.sel)
+                        || (SEL_SETTINGS_VOICE_CULL == gui_state.sel)) ? color_blue : color_gray);
+    rdpq_fill_rectangle(x_base - 4, y_voices - 10, x_base + 196, y_voices + 23);
+
+    if (gui_state.selected && (SEL_SETTINGS_VOICE_PAN == gui_state.sel))
+    {
+        rdpq_set_mode_fill(color_green);
+        rdpq_fill_rectangle(x_base - 2, y_voices + 1, x_base + 194, y_voices + 12);
+    }
+    else if (gui_state.selected && (SEL_SETTINGS_VOICE_CULL == gui_state.sel))
+    {
+        rdpq_set_mode_fill(color_green);
+        rdpq_fill_rectangle(x_base - 2, y_voices + 11, x_base + 194, y_voices + 22);
+    }
+
+    rdpq_text_print(NULL, 1, x_base, y_voices, "VOICES");
+    rdpq_text_printf(NULL, 1, x_base, y_voices + 10, "KEY PAN SPREAD: %u",
+                     (unsigned int)voice_pan_spread);
+    if (0 == voice_cull_db)
+    {
+        rdpq_text_print(NULL, 1, x_base, y_voices + 20, "CULL BELOW: OFF");
+    }
+    else
+    {
+        rdpq_text_printf(NULL, 1, x_base, y_voices + 20, "CULL BELOW: -%u dB",
+                         (unsigned int)voice_cull_db);
+    }
+
+    int const y_master = y_voices + 40;
+
+    rdpq_set_mode_fill(((SEL_SETTINGS_SOFT_CLIP == gui_state.sel)
+                        || (SEL_SETTINGS_LIMITER == gui_state.sel)) ? color_blue : color_gray);
+    rdpq_fill_rectangle(x_base - 4, y_master - 10, x_base + 196, y_master + 23);
+
+    if (gui_state.selected && (SEL_SETTINGS_SOFT_CLIP == gui_state.sel))
+    {
+        rdpq_set_mode_fill(color_green);
+        rdpq_fill_rectangle(x_base - 2, y_master + 1, x_base + 194, y_master + 12);
+    }
+    else if (gui_state.selected && (SEL_SETTINGS_LIMITER == gui_state.sel))
+    {
+        rdpq_set_mode_fill(color_green);
+        rdpq_fill_rectangle(x_base - 2, y_master + 11, x_base + 194, y_master + 22);
+    }
+
+    rdpq_text_print(NULL, 1, x_base, y_master, "MASTER");
+    rdpq_text_printf(NULL, 1, x_base, y_master + 10, "SOFT CLIP: %c",
+                     dynamics_clip_enabled ? 'Y':'N');
+    rdpq_text_printf(NULL, 1, x_base, y_master + 20, "LIMITER: %c",
+                     dynamics_limit_enabled ? 'Y':'N');
+}
+
+static void gui_nav_settings_left(void)
+{
+    if (gui_state.selected && (SEL_SETTINGS_SOFT_CLIP == gui_state.sel))
+    {
+        dynamics_clip_enabled = !dynamics_clip_enabled;
+    }
+    else if (gui_state.selected && (SEL_SETTINGS_LIMITER == gui_state.sel))
+    {
+        dynamics_limit_enabled = !dynamics_limit_enabled;
+    }
+    else if (gui_state.selected && (SEL_SETTINGS_VOICE_PAN == gui_state.sel))
+    {
+        if (0 < voice_pan_spread)
+        {
+            --voice_pan_spread;
+        }
+    }
+    else if (gui_state.selected && (SEL_SETTINGS_VOICE_CULL == gui_state.sel))
+    {
+        if (VOICE_CULL_DB_GRANULE <= voice_cull_db)
+        {
+            voice_set_cull_db(voice_cull_db - VOICE_CULL_DB_GRANULE);
+        }
+    }
+    else if (gui_state.selected && (SEL_SETTINGS_HARMONICS == gui_state.sel))
+    {
+        size_t const harmonics = wavetable_get_num_harmonics();
+        if (harmonics > HARMONICS_GRANULE)
+        {
+            wavetable_set_num_harmonics(harmonics - HARMONICS_GRANULE);
+        }
+        else if (harmonics > 1)
+        {
+            wavetable_set_num_harmonics(1);
+        }
+    }
+}
+
+static void gui_nav_settings_right(void)
+{
+    if (gui_state.selected && (SEL_SETTINGS_SOFT_CLIP == gui_state.sel))
+    {
+        dynamics_clip_enabled = !dynamics_clip_enabled;
+    }
+    else if (gui_state.selected && (SEL_SETTINGS_LIMITER == gui_state.sel))
+    {
+        dynamics_limit_enabled = !dynamics_limit_enabled;
+    }
+    else if (gui_state.selected && (SEL_SETTINGS_VOICE_PAN == gui_state.sel))
+    {
+        if (MIDI_MAX_DATA_BYTE > voice_pan_spread)
+        {
+            ++voice_pan_spread;
+        }
+    }
+    else if (gui_state.selected && (SEL_SETTINGS_VOICE_CULL == gui_state.sel))
+    {
+        if (VOICE_CULL_DB_MAX > voice_cull_db)
+        {
+            voice_set_cull_db(voice_cull_db + VOICE_CULL_DB_GRANULE);
+        }
+    }
+    else if (gui_state.selected && (SEL_SETTINGS_HARMONICS == gui_state.sel))
+    {
+        size_t const harmonics = wavetable_get_num_harmonics();
+        if ((HARMONICS_MAX - HARMONICS_GRANULE) >= harmonics)
+        {
+            wavetable_set_num_harmonics(harmonics + HARMONICS_GRANULE);
+        }
+        else if (harmonics < HARMONICS_MAX)
+        {
+            wavetable_set_num_harmonics(HARMONICS_MAX);
+        }
+    }
+}
+
+static void gui_nav_settings_up(void)
+{
+    if (!gui_state.selected && (SEL_SETTINGS_HARMONICS != gui_state.sel))
+    {
+        --gui_state.sel;
+    }
+    // else no action
+}
+
+static void gui_nav_settings_down(void)
+{
+    if (!gui_state.selected && (SEL_SETTINGS_LIMITER != gui_state.sel))
+    {
+        ++gui_state.sel;
+    }
+    // else no action
+}
+
+static void gui_nav_debug_left(void)
+{
+    if (0 == debug_page)
+    {
+        debug_page = NUM_DEBUG_PAGES - 1;
+    }
+    else
+    {
+        --debug_page;
+    }
+}
+
+static void gui_nav_debug_right(void)
+{
+    if ((NUM_DEBUG_PAGES - 1) == debug_page)
+    {
+        debug_page = 0;
+    }
+    else
+    {
+        ++debug_page;
+    }
+}
+
+static void gui_draw_file(void)
+{
+    int const x_base = 40;
+    int const y_base = 45;
+
+    rdpq_set_mode_fill(color_blue);
+    rdpq_fill_rectangle(x_base - 4, y_base - 10, x_base + 436, y_base + 160);
+
+    rdpq_text_print(NULL, 1, x_base, y_base, "IMPORT WAVETABLE (" WAV_IMPORT_DIR ")");
+
+    int y_pos = y_base + 14;
+    if (0 == wav_import_num_files)
+    {
+        rdpq_text_print(NULL, 1, x_base, y_pos, "No .wav files found.");
+    }
+
+    for (size_t file_idx = 0; file_idx < wav_import_num_files; ++file_idx)
+    {
+        if (file_idx == file_state.file_idx)
+        {
+            rdpq_set_mode_fill(color_green);
+            rdpq_fill_rectangle(x_base - 2, y_pos - 8, x_base + 434, y_pos + 1);
+        }
+        rdpq_text_print(NULL, 1, x_base + 8, y_pos, wav_import_files[file_idx]);
+        y_pos += 9;
+    }
+
+    rdpq_text_printf(NULL, 1, x_base, y_base + 128, "SLOT: < %s >  %s",
+                     get_osc_shape_str(file_state.slot),
+                     (NULL != wavetable_get(file_state.slot)) ? "(LOADED)" : "(EMPTY)");
+
+    uint16_t num_frames = 0;
+    uint16_t const frame_idx = wav_import_get_progress(&num_frames);
+    char status_str[48];
+    switch (wav_import_get_status())
+    {
+        case WAV_IMPORT_LOADING:
+            snprintf(status_str, sizeof(status_str), "LOADING FRAME %u/%u",
+                     (unsigned int)frame_idx, (unsigned int)num_frames);
+            break;
+        case WAV_IMPORT_DONE:
+            snprintf(status_str, sizeof(status_str), "LOADED %u FRAMES",
+                     (unsigned int)num_frames);
+            break;
+        case WAV_IMPORT_ERR_OPEN:
+            snprintf(status_str, sizeof(status_str), "ERROR: CANNOT OPEN FILE");
+            break;
+        case WAV_IMPORT_ERR_FORMAT:
+            snprintf(status_str, sizeof(status_str), "ERROR: NOT 16 BIT MONO PCM");
+            break;
+        case WAV_IMPORT_ERR_MEMORY:
+            snprintf(status_str, sizeof(status_str), "ERROR: OUT OF MEMORY");
+            break;
+        case WAV_IMPORT_ERR_READ:
+            snprintf(status_str, sizeof(status_str), "ERROR: READ FAILED");
+            break;
+        default:
+            snprintf(status_str, sizeof(status_str), "READY");
+            break;
+    }
+    rdpq_text_printf(NULL, 1, x_base, y_base + 138, "STATUS: %s", status_str);
+    rdpq_text_print(NULL, 1, x_base, y_base + 148, "A: IMPORT  LEFT/RIGHT: SLOT  UP/DOWN: FILE");
+}
+
+static void gui_nav_file_left(void)
+{
+    if (USER_1 == file_state.slot)
+    {
+        file_state.slot = NUM_OSC_TYPES - 1;
+    }
+    else
+    {
+        --file_state.slot;
+    }
+}
+
+static void gui_nav_file_right(void)
+{
+    if ((NUM_OSC_TYPES - 1) == file_state.slot)
+    {
+        file_state.slot = USER_1;
+    }
+    else
+    {
+        ++file_state.slot;
+    }
+}
+
+static void gui_nav_file_up(void)
+{
+    if (0 < file_state.file_idx)
+    {
+        --file_state.file_idx;
+    }
+}
+
+static void gui_nav_file_down(void)
+{
+    if ((file_state.file_idx + 1) < wav_import_num_files)
+    {
+        ++file_state.file_idx;
+    }
+}
+
+void gui_select(void)
+{
+    // Selecting on the FILE screen imports the file under the cursor.
+    if (SCREEN_FILE == gui_state.screen)
+    {
+        if (file_state.file_idx < wav_import_num_files)
+        {
+            wav_import_begin(wav_import_files[file_state.file_idx], file_state.slot);
+        }
+        return;
+    }
+
+    if (!gui_state.selected)
+    {
+        gui_state.selected = true;
+    }
+    else
+    {
+        gui_deselect();
+    }
+}
+
+void gui_deselect(void)
+{
+    gui_state.selected = false;
+}
+
+bool gui_recv_continuous_input(joypad_buttons_t buttons_pressed)
+{
+    bool ret = false;
+
+    if (gui_state.selected)
+    {
+        if ((buttons_pressed.d_left || buttons_pressed.d_right)
+            && (((SEL_OSC_1 == gui_state.sel) || (SEL_OSC_2 == gui_state.sel))
+                && ((OSC_SUBSEL_GAIN == gui_state.subsel.osc)
+                    || (OSC_SUBSEL_POSITION == gui_state.subsel.osc)
+                    || (OSC_SUBSEL_POS_ENV == gui_state.subsel.osc)
+                    || (OSC_SUBSEL_FINE == gui_state.subsel.osc)
+                    || (OSC_SUBSEL_PHASE == gui_state.subsel.osc)
+                    || (OSC_SUBSEL_PAN == gui_state.subsel.osc)
+                    || (OSC_SUBSEL_UNISON_DETUNE == gui_state.subsel.osc)
+                    || (OSC_SUBSEL_UNISON_SPREAD == gui_state.subsel.osc))))
+        {
+            ret = true;
+        }
+        else if ((buttons_pressed.d_up || buttons_pressed.d_down)
+                 && (((SEL_ENV_1 == gui_state.sel)
+                      || (SEL_ENV_2 == gui_state.sel)
+                      || (SEL_ENV_3 == gui_state.sel))
+                     && ((ENV_SUBSEL_TIME == gui_state.subsel.env)
+                         || (ENV_SUBSEL_LEVEL == gui_state.subsel.env))))
+        {
+            ret = true;
         }
         else if ((buttons_pressed.d_left || buttons_pressed.d_right)
                  && (((SEL_LFO_1 == gui_state.sel) || (SEL_LFO_2 == gui_state.sel))
@@ -1255,6 +3555,55 @@ bool gui_recv_continuous_input(joypad_buttons_t buttons_pressed)
         {
             ret = true;
         }
+        else if ((buttons_pressed.d_left || buttons_pressed.d_right)
+                 && ((SEL_MOD_MATRIX == gui_state.sel)
+                     && (MOD_COL_DEPTH == (gui_state.subsel.mod % NUM_MOD_COLS))))
+        {
+            ret = true;
+        }
+        else if ((buttons_pressed.d_left || buttons_pressed.d_right)
+                 && ((SEL_FILTER == gui_state.sel)
+                     && ((FILTER_SUBSEL_CUTOFF == gui_state.subsel.filter)
+                         || (FILTER_SUBSEL_RESONANCE == gui_state.subsel.filter)
+                         || (FILTER_SUBSEL_ENV_AMT == gui_state.subsel.filter)
+                         || (FILTER_SUBSEL_KEY_TRACK == gui_state.subsel.filter))))
+        {
+            ret = true;
+        }
+        else if ((buttons_pressed.d_left || buttons_pressed.d_right)
+                 && ((SEL_FX_CHORUS == gui_state.sel)
+                     && ((CHORUS_SUBSEL_RATE == gui_state.subsel.chorus)
+                         || (CHORUS_SUBSEL_DEPTH == gui_state.subsel.chorus)
+                         || (CHORUS_SUBSEL_DELAY == gui_state.subsel.chorus)
+                         || (CHORUS_SUBSEL_MIX == gui_state.subsel.chorus)
+                         || (CHORUS_SUBSEL_SPREAD == gui_state.subsel.chorus))))
+        {
+            ret = true;
+        }
+        else if ((buttons_pressed.d_left || buttons_pressed.d_right)
+                 && ((SEL_FX_DELAY == gui_state.sel)
+                     && ((DELAY_SUBSEL_BPM == gui_state.subsel.delay)
+                         || (DELAY_SUBSEL_FEEDBACK == gui_state.subsel.delay)
+                         || (DELAY_SUBSEL_DAMPING == gui_state.subsel.delay)
+                         || (DELAY_SUBSEL_MIX == gui_state.subsel.delay))))
+        {
+            ret = true;
+        }
+        else if ((buttons_pressed.d_left || buttons_pressed.d_right)
+                 && ((SEL_FX_REVERB == gui_state.sel)
+                     && ((REVERB_SUBSEL_SIZE == gui_state.subsel.reverb)
+                         || (REVERB_SUBSEL_DAMPING == gui_state.subsel.reverb)
+                         || (REVERB_SUBSEL_MIX == gui_state.subsel.reverb)
+                         || (REVERB_SUBSEL_WIDTH == gui_state.subsel.reverb))))
+        {
+            ret = true;
+        }
+        else if ((buttons_pressed.d_left || buttons_pressed.d_right)
+                 && ((SEL_SETTINGS_HARMONICS == gui_state.sel)
+                     || (SEL_SETTINGS_VOICE_PAN == gui_state.sel)))
+        {
+            ret = true;
+        }
     }
     return ret;
 }
@@ -11,9 +11,15 @@
 
 #define NUM_DISP_BUFFERS 3
 
+/// Interval between redraws of the live widgets, about one frame at 60 Hz.
+/// The scope and the meter's hold and clip decay animate on this cadence
+/// whether or not the level changes.
+#define GUI_LIVE_FRAME_MS 16
+
 void gui_init(void);
 void gui_draw_screen(void);
 void gui_splash(enum init_state_e init_state);
+void gui_draw_live(void);
 void gui_draw_level_meter(display_context_t disp);
 
 bool gui_recv_continuous_input(joypad_buttons_t buttons_pressed);
@@ -0,0 +1,71 @@
+#include "init.h"
+
+#include "gui.h"
+
+#include <n64sys.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Minimum time between splash screen updates. Each update is a full redraw
+/// and present, which costs more than most stages, so fast stages are only
+/// shown if a frame's worth of time has passed.
+#define INIT_SPLASH_INTERVAL_US 16667
+
+uint32_t init_stage_us[NUM_INIT_STATES] = {0};
+uint32_t init_first_note_us = 0;
+uint32_t init_all_ready_us = 0;
+
+static enum init_state_e cur_stage = NUM_INIT_STATES;
+static uint32_t cur_stage_start = 0;
+static uint64_t last_splash_us = 0;
+
+static void init_stage_end(void);
+
+/// Close the running boot stage and start timing the next one. Updates the
+/// splash screen if it has not been drawn for at least one frame. Splash
+/// time is excluded from the stage timings.
+void init_stage_begin(enum init_state_e stage)
+{
+    init_stage_end();
+
+    uint64_t const now_us = get_ticks_us();
+    if ((INIT != stage) && ((now_us - last_splash_us) >= INIT_SPLASH_INTERVAL_US))
+    {
+        gui_splash(stage);
+        last_splash_us = get_ticks_us();
+    }
+
+    cur_stage = stage;
+    cur_stage_start = TICKS_READ();
+}
+
+/// Close the final serial stage. Audio is running from this point, so this
+/// marks the time to first note.
+void init_boot_done(void)
+{
+    init_stage_end();
+    init_first_note_us = (uint32_t)get_ticks_us();
+}
+
+/// Accumulate time spent on a stage that runs in slices from the main loop.
+void init_stage_add_ticks(enum init_state_e stage, uint32_t ticks)
+{
+    init_stage_us[stage] += TICKS_TO_US(ticks);
+}
+
+/// Mark all lazy stages as complete.
+void init_lazy_done(void)
+{
+    init_all_ready_us = (uint32_t)get_ticks_us();
+}
+
+static void init_stage_end(void)
+{
+    if (NUM_INIT_STATES != cur_stage)
+    {
+        init_stage_us[cur_stage] = TICKS_TO_US(TICKS_DISTANCE(cur_stage_start, TICKS_READ()));
+        cur_stage = NUM_INIT_STATES;
+    }
+}
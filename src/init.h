@@ -1,18 +1,45 @@
 #include <stddef.h>
+#include <stdint.h>
 
 #ifndef INIT_H
 #define INIT_H
 
+/// Boot stages, in order. Stages up to and including INIT_AUDIO run serially
+/// before the main loop; the remaining stages run lazily from the main loop
+/// once audio is already playing.
 enum init_state_e
 {
     INIT,
+    INIT_INPUT,
+    INIT_FILESYSTEM,
+    INIT_ENVELOPES,
+    INIT_LFOS,
+    INIT_SPECTRUM,
     GEN_SINE,
-    GEN_SQUARE,
-    GEN_TRIANGLE,
-    GEN_RAMP,
     GEN_FREQ_TBL,
+    INIT_VOICES,
     ALLOC_MIX_BUF,
     INIT_AUDIO,
+    GEN_SQUARE,
+    GEN_TRIANGLE,
+    GEN_RAMP,
+    NUM_INIT_STATES,
+
+    LAST_BOOT_STATE = INIT_AUDIO
 };
 
+/// Time spent in each stage, in microseconds. Lazy stages accumulate only the
+/// main loop time actually spent on them.
+extern uint32_t init_stage_us[NUM_INIT_STATES];
+
+/// Time since power-on at which audio started, and at which every lazy stage
+/// had completed.
+extern uint32_t init_first_note_us;
+extern uint32_t init_all_ready_us;
+
+void init_stage_begin(enum init_state_e stage);
+void init_boot_done(void);
+void init_stage_add_ticks(enum init_state_e stage, uint32_t ticks);
+void init_lazy_done(void);
+
 #endif
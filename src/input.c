@@ -2,6 +2,8 @@
 
 #include "audio_engine.h"
 #include "gui.h"
+#include "mod_matrix.h"
+#include "tempo.h"
 #include "voice.h"
 #include "wavetable.h"
 
@@ -10,6 +12,7 @@
 
 #include <stddef.h>
 
+#define MIDI_CC_MOD_WHEEL 1
 #define MIDI_CC_DATA_ENTRY_MSB 6
 #define MIDI_CC_NRPN_LSB 98
 #define MIDI_CC_NRPN_MSB 99
@@ -19,7 +22,11 @@
 #define MIDI_CC_ENV1_SUSTAIN 13
 #define MIDI_CC_ENV1_RELEASE 12
 #define MIDI_CC_GAIN 117
+#define MIDI_CC_OSC1_POSITION 16
 #define MIDI_NRPN_OSC1_SHAPE 0x0003
+#define MIDI_CHANNEL_AFTERTOUCH 0xD0
+#define MIDI_PITCH_BEND 0xE0
+#define MIDI_TIMING_CLOCK 0xF8
 
 static size_t midi_in_bytes = 0;
 static uint32_t midi_rx_ctr = 0;
@@ -140,7 +147,11 @@ static bool input_handle_midi(size_t midi_in_bytes)
     {
         midi_msg msg = msg_buf[msg_idx];
 
-        if ((MIDI_NOTE_OFF == (msg.status & 0xF0))
+        if (MIDI_TIMING_CLOCK == msg.status)
+        {
+            tempo_midi_clock();
+        }
+        else if ((MIDI_NOTE_OFF == (msg.status & 0xF0))
             || ((MIDI_NOTE_ON == (msg.status & 0xF0)) && (0 == msg.data[1])))
         {
             if (msg.data[0] >= MIDI_MAX_DATA_BYTE)
@@ -155,14 +166,24 @@ static bool input_handle_midi(size_t midi_in_bytes)
         {
             if (msg.data[0] >= MIDI_MAX_DATA_BYTE)
                 continue;
-            // TODO: Handle velocity
             voice_t * voice = voice_find_next();
-            voice_note_on(voice, msg.data[0]);
+            voice_note_on(voice, msg.data[0], msg.data[1]);
+        }
+        else if (MIDI_CHANNEL_AFTERTOUCH == (msg.status & 0xF0))
+        {
+            mod_aftertouch = msg.data[0];
+        }
+        else if (MIDI_PITCH_BEND == (msg.status & 0xF0))
+        {
+            voice_set_pitch_bend(msg.data[0] | ((uint16_t)msg.data[1] << 7));
         }
         else if (MIDI_CONTROL_CHANGE == (msg.status & 0xF0))
         {
             switch (msg.data[0])
             {
+                case MIDI_CC_MOD_WHEEL:
+                    mod_wheel = msg.data[1];
+                    break;
                 case MIDI_CC_ENV1_ATTACK:
                     envelope_set_attack(0, ((uint16_t)msg.data[1] << 7));
                     update_graphics = true;
@@ -183,6 +204,10 @@ static bool input_handle_midi(size_t midi_in_bytes)
                     audio_engine_set_gain(msg.data[1]);
                     update_graphics = true;
                     break;
+                case MIDI_CC_OSC1_POSITION:
+                    oscillators[0].position = msg.data[1];
+                    update_graphics = true;
+                    break;
                 case MIDI_CC_NRPN_MSB:
                     nrpn = ((uint16_t)msg.data[1]) << 7;
                     break;
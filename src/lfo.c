@@ -13,7 +13,8 @@ void lfo_init(void)
         lfo->tune = 0u;
         lfo->cur_amplitude = 0;
         lfo->depth = 0;
-        lfo->dst = 0u;
+        lfo->direct = false;
+        lfo->sync = LFO_SYNC_GLOBAL;
     }
 }
 
@@ -1,14 +1,27 @@
 #ifndef LFO_H
 #define LFO_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "wavetable.h"
 
 #define NUM_LFOS 2
 
-#define LFO_DST_AMP  0x01
-#define LFO_DST_FREQ 0x02
+/// How an LFO runs across voices.
+/// LFO_SYNC_GLOBAL: one free running LFO shared by every voice.
+/// LFO_SYNC_KEY:    each voice runs its own, restarted at note on.
+/// LFO_SYNC_RANDOM: each voice runs its own, started at a random phase.
+enum lfo_sync_e
+{
+    LFO_SYNC_GLOBAL,
+    LFO_SYNC_KEY,
+    LFO_SYNC_RANDOM,
+    NUM_LFO_SYNCS
+};
 
+/// A per-voice LFO keeps only its phase in the voice. Its shape, rate and
+/// depth are shared, and phase_pos and cur_amplitude are those of the global
+/// LFO.
 typedef struct {
     enum oscillator_shape_e shape;
     uint32_t phase_pos;
@@ -16,7 +29,8 @@ typedef struct {
     float rate;
     short cur_amplitude;
     short depth;
-    uint8_t  dst;
+    bool direct;
+    enum lfo_sync_e sync;
 } lfo_t;
 
 extern lfo_t lfos[NUM_LFOS];
@@ -24,76 +38,66 @@ extern lfo_t lfos[NUM_LFOS];
 void lfo_init(void);
 void lfo_set_rate(size_t lfo_idx, float rate);
 
-/// Tick the LFO by the given number of ticks. Increments the phase position
-/// and stores the new amplitude.
-static inline void lfo_tick(lfo_t * lfo, size_t ticks)
+/// Return the amplitude of an LFO's shape at a phase, where step is the
+/// phase advanced since the last tick. A direct LFO smooths its corners over
+/// one step, which softens the zipper of a fast square or ramp.
+static inline short lfo_get_amplitude(lfo_t const * lfo, uint32_t phase, uint32_t step)
 {
-    lfo->phase_pos += (ticks * lfo->tune);
+    if (lfo->direct && wavetable_has_direct(lfo->shape))
+    {
+        return wavetable_direct(phase, step, wavetable_direct_inv_dt(step), lfo->shape);
+    }
 
     switch (lfo->shape)
     {
         case SINE:
-            lfo->cur_amplitude = wavetable_get_amplitude(lfo->phase_pos, wavetable_get(SINE));
-            break;
+            return wavetable_get_amplitude(phase, wavetable_get(SINE));
         case TRIANGLE:
-            lfo->cur_amplitude = wavetable_triangle_component(lfo->phase_pos);
-            break;
+            return wavetable_triangle_component(phase);
         case SQUARE:
-            lfo->cur_amplitude = wavetable_square_component(lfo->phase_pos);
-            break;
+            return wavetable_square_component(phase);
         case RAMP:
-            lfo->cur_amplitude = wavetable_ramp_component(lfo->phase_pos);
-            break;
+            return wavetable_ramp_component(phase);
         default:
-            break;
+            return 0;
     }
 }
 
-static inline void lfo_tick_all(size_t num_ticks)
+/// Tick the LFO by the given number of ticks. Increments the phase position
+/// and stores the new amplitude.
+static inline void lfo_tick(lfo_t * lfo, size_t ticks)
 {
-    for (size_t lfo_idx = 0; lfo_idx < NUM_LFOS; ++lfo_idx)
-    {
-        if (NONE != lfos[lfo_idx].shape)
-        {
-            lfo_tick(&lfos[lfo_idx], 1);
-        }
-    }
+    uint32_t const step = ticks * lfo->tune;
+    lfo->phase_pos += step;
+    lfo->cur_amplitude = lfo_get_amplitude(lfo, lfo->phase_pos, step);
 }
 
-static inline int16_t lfo_mod_gain(uint8_t base_gain)
+/// Tick a voice's own copy of an LFO, advancing its phase, and return its
+/// output scaled by the LFO depth as lfo_get_value() does.
+static inline int32_t lfo_tick_voice(lfo_t const * lfo, uint32_t * phase, size_t ticks)
 {
-    int16_t gain_mod = 0;
-    for (size_t lfo_idx = 0; lfo_idx < NUM_LFOS; ++lfo_idx)
-    {
-        lfo_t * lfo = &lfos[lfo_idx];
-        if (LFO_DST_AMP & lfo->dst)
-        {
-            gain_mod += (int8_t)(((int32_t)lfo->cur_amplitude * (int32_t)lfo->depth) >> 23);
-        }
-    }
-
-    int16_t gain = base_gain + gain_mod;
-    if (gain < 0)
-    {
-        gain = 0;
-    }
-
-    return gain;
+    uint32_t const step = ticks * lfo->tune;
+    *phase += step;
+    return ((int32_t)lfo_get_amplitude(lfo, *phase, step) * lfo->depth) >> 15;
 }
 
-static inline uint32_t lfo_mod_tune(uint32_t base_tune)
+/// Tick the global LFOs. Per-voice LFOs are ticked by their voices.
+static inline void lfo_tick_all(size_t num_ticks)
 {
-    int32_t tune_mod = 0;
     for (size_t lfo_idx = 0; lfo_idx < NUM_LFOS; ++lfo_idx)
     {
-        lfo_t * lfo = &lfos[lfo_idx];
-        if (LFO_DST_FREQ & lfo->dst)
+        if ((NONE != lfos[lfo_idx].shape) && (LFO_SYNC_GLOBAL == lfos[lfo_idx].sync))
         {
-            tune_mod += (lfo->cur_amplitude * lfo->depth * (int64_t)base_tune) >> 31;
+            lfo_tick(&lfos[lfo_idx], num_ticks);
         }
     }
+}
 
-    return base_tune + tune_mod;
+/// Return the output of an LFO scaled by its depth, as a Q15 modulation
+/// source.
+static inline int32_t lfo_get_value(lfo_t const * lfo)
+{
+    return ((int32_t)lfo->cur_amplitude * lfo->depth) >> 15;
 }
 
 #endif
@@ -5,18 +5,33 @@
 #include "input.h"
 #include "gui.h"
 #include "lfo.h"
+#include "meter.h"
+#include "mod_matrix.h"
+#include "spectrum.h"
 #include "wavetable.h"
 #include "voice.h"
+#include "wav_import.h"
 
 int main(void)
 {
+    init_stage_begin(INIT);
     gui_init();
+    init_stage_begin(INIT_INPUT);
     input_init();
+    init_stage_begin(INIT_FILESYSTEM);
+    wav_import_init();
+    init_stage_begin(INIT_ENVELOPES);
     envelope_init();
+    init_stage_begin(INIT_LFOS);
     lfo_init();
+    mod_matrix_init();
+    init_stage_begin(INIT_SPECTRUM);
+    spectrum_init();
     wavetable_init();
+    init_stage_begin(INIT_VOICES);
     voice_init();
     audio_engine_init();
+    init_boot_done();
 
     // debug_init_isviewer();
     // debug_init_usblog();
@@ -24,6 +39,7 @@ int main(void)
     gui_draw_screen();
 
     uint8_t update_graphics_ctr = NUM_DISP_BUFFERS;
+    uint64_t live_frame_ms = 0;
 
 	while(1) {
         if (input_poll_and_handle())
@@ -31,14 +47,32 @@ int main(void)
             update_graphics_ctr = NUM_DISP_BUFFERS;
         }
 
+        if (wavetable_generate_step())
+        {
+            update_graphics_ctr = NUM_DISP_BUFFERS;
+        }
+
+        if (wav_import_step())
+        {
+            update_graphics_ctr = NUM_DISP_BUFFERS;
+        }
+
         if (update_graphics_ctr > 0)
         {
             gui_draw_screen();
             --update_graphics_ctr;
         }
-        else if (peak > 0)
+        else
         {
-            gui_draw_level_meter(NULL);
+            meter_update();
+            spectrum_process();
+
+            uint64_t const now_ms = get_ticks_ms();
+            if ((now_ms - live_frame_ms) >= GUI_LIVE_FRAME_MS)
+            {
+                live_frame_ms = now_ms;
+                gui_draw_live();
+            }
         }
     }
 
@@ -0,0 +1,118 @@
+#include "meter.h"
+
+#include <n64sys.h>
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define METER_REFRESH_MS 10
+#define METER_ATTACK_MS 10
+#define METER_DECAY_MS 300
+#define METER_RMS_MS 300
+#define METER_PEAK_HOLD_MS 1500
+#define METER_CLIP_HOLD_MS 2000
+
+struct meter_block_s meter_blocks[2] = {0};
+volatile uint8_t meter_front = 0;
+volatile bool meter_consumed = true;
+
+struct meter_display_s meter_display = {0};
+
+static int32_t meter_approach(int32_t level, int32_t target,
+                              uint32_t elapsed_ms, uint32_t time_ms);
+
+/// Consume the latest snapshot from the audio callback (if any) and advance
+/// the peak, RMS, peak-hold and clip-hold ballistics.
+/// Returns true if the displayed meter changed and should be redrawn.
+bool meter_update(void)
+{
+    static uint64_t last_ms = 0;
+
+    uint64_t const now_ms = get_ticks_ms();
+    uint32_t const elapsed_ms = (uint32_t)(now_ms - last_ms);
+
+    if (elapsed_ms < METER_REFRESH_MS)
+    {
+        return false;
+    }
+    last_ms = now_ms;
+
+    struct meter_display_s const prev = meter_display;
+
+    int32_t block_peak = 0;
+    int32_t block_rms = 0;
+    bool block_clipped = false;
+
+    if (!meter_consumed)
+    {
+        struct meter_block_s const * block = &meter_blocks[meter_front];
+
+        block_peak = block->peak;
+        if (block->num_samples > 0)
+        {
+            block_rms = (int32_t)sqrtf((float)block->sum_squares / block->num_samples);
+        }
+        block_clipped = (block->num_clipped > 0);
+
+        MEMORY_BARRIER();
+        meter_consumed = true;
+    }
+
+    // Peak: fast attack, slow exponential-style release.
+    if (block_peak > meter_display.peak)
+    {
+        meter_display.peak = meter_approach(meter_display.peak, block_peak,
+                                            elapsed_ms, METER_ATTACK_MS);
+    }
+    else
+    {
+        meter_display.peak = meter_approach(meter_display.peak, block_peak,
+                                            elapsed_ms, METER_DECAY_MS);
+    }
+
+    meter_display.rms = meter_approach(meter_display.rms, block_rms,
+                                       elapsed_ms, METER_RMS_MS);
+
+    if (block_peak >= meter_display.peak_hold)
+    {
+        meter_display.peak_hold = block_peak;
+        meter_display.peak_hold_until_ms = now_ms + METER_PEAK_HOLD_MS;
+    }
+    else if (now_ms >= meter_display.peak_hold_until_ms)
+    {
+        meter_display.peak_hold = meter_display.peak;
+    }
+
+    if (block_clipped)
+    {
+        meter_display.clip_until_ms = now_ms + METER_CLIP_HOLD_MS;
+    }
+    meter_display.clip = (now_ms < meter_display.clip_until_ms);
+
+    return ((prev.peak != meter_display.peak)
+            || (prev.rms != meter_display.rms)
+            || (prev.peak_hold != meter_display.peak_hold)
+            || (prev.clip != meter_display.clip));
+}
+
+/// Move level toward target by the fraction of time_ms that has elapsed.
+/// Snaps to the target once within one step, so a silent meter settles at 0.
+static int32_t meter_approach(int32_t level, int32_t target,
+                              uint32_t elapsed_ms, uint32_t time_ms)
+{
+    if (elapsed_ms >= time_ms)
+    {
+        return target;
+    }
+
+    int32_t const step = (int32_t)(((int64_t)(target - level) * elapsed_ms) / time_ms);
+
+    if (0 == step)
+    {
+        return target;
+    }
+
+    return level + step;
+}
@@ -0,0 +1,89 @@
+#ifndef METER_H
+#define METER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <n64sys.h>
+
+/// Raw level statistics accumulated by the audio callback. num_samples
+/// counts the samples of both channels.
+struct meter_block_s
+{
+    int32_t peak;
+    uint64_t sum_squares;
+    uint32_t num_samples;
+    uint32_t num_clipped;
+};
+
+/// Ballistic meter state, advanced by meter_update() in the main loop.
+/// Levels are linear sample magnitudes in [0, INT16_MAX].
+struct meter_display_s
+{
+    int32_t peak;
+    int32_t rms;
+    int32_t peak_hold;
+    uint64_t peak_hold_until_ms;
+    uint64_t clip_until_ms;
+    bool clip;
+};
+
+/// Double-buffered snapshot. The audio callback accumulates into the back
+/// slot and only flips once the GUI has consumed the front slot, so neither
+/// side ever sees a half-written block.
+extern struct meter_block_s meter_blocks[2];
+extern volatile uint8_t meter_front;
+extern volatile bool meter_consumed;
+
+extern struct meter_display_s meter_display;
+
+bool meter_update(void);
+
+/// Accumulate peak, sum of squares and clip count over a finished stereo
+/// buffer, then publish it if the GUI is ready for another snapshot.
+/// Both channels are read, so the peak and clip are those of the louder one
+/// and the RMS covers the whole mix.
+static inline void meter_tap(short const * buffer, size_t num_samples)
+{
+    struct meter_block_s * block = &meter_blocks[meter_front ^ 1];
+
+    int32_t peak = block->peak;
+    uint64_t sum_squares = 0;
+    uint32_t num_clipped = 0;
+
+    for (size_t idx = 0; idx < (num_samples * 2); ++idx)
+    {
+        int32_t const sample = buffer[idx];
+        int32_t const sign = sample >> 31;
+        int32_t const magnitude = (sample ^ sign) - sign;
+
+        if (magnitude > peak)
+        {
+            peak = magnitude;
+        }
+
+        num_clipped += (magnitude >= INT16_MAX);
+        sum_squares += (uint32_t)(sample * sample);
+    }
+
+    block->peak = peak;
+    block->sum_squares += sum_squares;
+    block->num_samples += num_samples * 2;
+    block->num_clipped += num_clipped;
+
+    if (meter_consumed)
+    {
+        MEMORY_BARRIER();
+        meter_front ^= 1;
+        meter_consumed = false;
+
+        struct meter_block_s * next = &meter_blocks[meter_front ^ 1];
+        next->peak = 0;
+        next->sum_squares = 0;
+        next->num_samples = 0;
+        next->num_clipped = 0;
+    }
+}
+
+#endif
@@ -0,0 +1,95 @@
+#include "mod_matrix.h"
+
+#include <libdragon.h>
+#include <midi64.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+struct mod_slot_s mod_slots[MOD_MATRIX_SLOTS];
+
+/// Routes of the used slots, rebuilt by mod_matrix_compile() on every edit,
+/// with the mod_num_depth_routes routes to LFO depths first. Only read by
+/// the audio callback.
+struct mod_route_s mod_routes[MOD_MATRIX_SLOTS];
+size_t mod_num_routes = 0;
+size_t mod_num_depth_routes = 0;
+
+/// LFOs read by a route, one bit each. Voices only run the per-voice LFOs in
+/// the mask.
+uint8_t mod_lfo_mask = 0;
+
+/// Latest mod wheel and channel aftertouch from MIDI.
+uint8_t mod_wheel = 0;
+uint8_t mod_aftertouch = 0;
+
+void mod_matrix_init(void)
+{
+    for (size_t slot_idx = 0; slot_idx < MOD_MATRIX_SLOTS; ++slot_idx)
+    {
+        mod_slots[slot_idx].src = MOD_SRC_NONE;
+        mod_slots[slot_idx].dst = MOD_DST_PITCH;
+        mod_slots[slot_idx].depth = 0;
+    }
+
+    mod_matrix_compile();
+}
+
+/// Rebuild the route list from the slots, dropping those that do nothing.
+/// A unipolar source routed to gain or an LFO depth attenuates from unity at
+/// its top rather than boosting from unity at zero, so velocity on gain or
+/// the mod wheel on vibrato depth acts the way an amount control is expected
+/// to.
+void mod_matrix_compile(void)
+{
+    struct mod_route_s routes[MOD_MATRIX_SLOTS];
+    size_t num_routes = 0;
+    size_t num_depth_routes = 0;
+    uint8_t lfo_mask = 0;
+
+    // Depth routes on the first pass, the rest on the second.
+    for (size_t pass = 0; pass < 2; ++pass)
+    {
+        for (size_t slot_idx = 0; slot_idx < MOD_MATRIX_SLOTS; ++slot_idx)
+        {
+            struct mod_slot_s const * slot = &mod_slots[slot_idx];
+            bool const depth_dst = (MOD_DST_LFO_1_DEPTH == slot->dst)
+                                   || (MOD_DST_LFO_2_DEPTH == slot->dst);
+            if ((MOD_SRC_NONE == slot->src) || (0 == slot->depth) || (depth_dst != (0 == pass)))
+            {
+                continue;
+            }
+
+            struct mod_route_s * route = &routes[num_routes++];
+            route->src = slot->src;
+            route->dst = slot->dst;
+            route->depth = ((int32_t)slot->depth * MOD_VALUE_ONE) / MIDI_MAX_DATA_BYTE;
+            route->offset = 0;
+
+            bool const bipolar = (MOD_SRC_LFO_1 == slot->src) || (MOD_SRC_LFO_2 == slot->src);
+            if (((MOD_DST_GAIN == slot->dst) || depth_dst) && !bipolar)
+            {
+                route->offset = -route->depth;
+            }
+
+            if (bipolar)
+            {
+                lfo_mask |= 1u << (slot->src - MOD_SRC_LFO_1);
+            }
+        }
+
+        if (0 == pass)
+        {
+            num_depth_routes = num_routes;
+        }
+    }
+
+    disable_interrupts();
+    memcpy(mod_routes, routes, num_routes * sizeof(struct mod_route_s));
+    mod_num_routes = num_routes;
+    mod_num_depth_routes = num_depth_routes;
+    mod_lfo_mask = lfo_mask;
+    enable_interrupts();
+}
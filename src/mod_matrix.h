@@ -0,0 +1,139 @@
+#ifndef MOD_MATRIX_H
+#define MOD_MATRIX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <midi64.h>
+
+#define MOD_MATRIX_SLOTS 8
+
+/// Modulation values are Q15, full scale at +/-(1 << MOD_VALUE_BITS).
+#define MOD_VALUE_BITS 15
+#define MOD_VALUE_ONE (1 << MOD_VALUE_BITS)
+
+/// Cutoff sweep in semitones of a full scale modulation.
+#define MOD_CUTOFF_RANGE 48
+
+/// Pitch sweep in semitones of a full scale modulation.
+#define MOD_PITCH_RANGE 12
+
+/// Modulation sources. LFOs are bipolar, the rest run from zero up to full
+/// scale. LFOs, the mod wheel and aftertouch are shared by every voice;
+/// envelopes and velocity are the voice's own.
+enum mod_src_e
+{
+    MOD_SRC_NONE,
+    MOD_SRC_LFO_1,
+    MOD_SRC_LFO_2,
+    MOD_SRC_ENV_1,
+    MOD_SRC_ENV_2,
+    MOD_SRC_ENV_3,
+    MOD_SRC_VELOCITY,
+    MOD_SRC_MOD_WHEEL,
+    MOD_SRC_AFTERTOUCH,
+    NUM_MOD_SRCS
+};
+
+/// Modulation destinations, each applied to a whole voice once per control
+/// block. The LFO depths scale what each LFO feeds the voice's other routes.
+enum mod_dst_e
+{
+    MOD_DST_PITCH,
+    MOD_DST_GAIN,
+    MOD_DST_PAN,
+    MOD_DST_CUTOFF,
+    MOD_DST_POSITION,
+    MOD_DST_LFO_1_DEPTH,
+    MOD_DST_LFO_2_DEPTH,
+    NUM_MOD_DSTS
+};
+
+/// A slot of the matrix as edited. depth in
+/// [-MIDI_MAX_DATA_BYTE,MIDI_MAX_DATA_BYTE]; a slot with no source or no
+/// depth is unused.
+struct mod_slot_s
+{
+    enum mod_src_e src;
+    enum mod_dst_e dst;
+    int8_t depth;
+};
+
+/// A route compiled from a used slot. depth is Q15, and offset is added to
+/// its product with the source.
+struct mod_route_s
+{
+    uint8_t src;
+    uint8_t dst;
+    int32_t depth;
+    int32_t offset;
+};
+
+extern struct mod_slot_s mod_slots[MOD_MATRIX_SLOTS];
+extern struct mod_route_s mod_routes[MOD_MATRIX_SLOTS];
+extern size_t mod_num_routes;
+extern size_t mod_num_depth_routes;
+extern uint8_t mod_lfo_mask;
+extern uint8_t mod_wheel;
+extern uint8_t mod_aftertouch;
+
+void mod_matrix_init(void);
+void mod_matrix_compile(void);
+
+/// Return a Q15 gain for a gain modulation, between silence and twice unity.
+static inline int32_t mod_matrix_gain(int32_t gain_mod)
+{
+    int32_t gain = MOD_VALUE_ONE + gain_mod;
+    if (gain < 0)
+        return 0;
+    else if (gain > (2 * MOD_VALUE_ONE))
+        return 2 * MOD_VALUE_ONE;
+    return gain;
+}
+
+/// Sum a range of the compiled routes into the destinations.
+static inline void mod_matrix_sum(int32_t const * src_values, int32_t * dst_values,
+                                  size_t first, size_t last)
+{
+    for (size_t route_idx = first; route_idx < last; ++route_idx)
+    {
+        struct mod_route_s const * route = &mod_routes[route_idx];
+        dst_values[route->dst] += ((src_values[route->src] * route->depth) >> MOD_VALUE_BITS)
+                                  + route->offset;
+    }
+}
+
+/// Sum the compiled routes into a value per destination. Only the routes in
+/// use are visited, so an empty matrix costs a clear of the destinations.
+/// Routes to the LFO depths come first and scale the LFOs for the rest; one
+/// that reads an LFO itself sees it unscaled.
+static inline void mod_matrix_eval(int32_t const * src_values, int32_t * dst_values)
+{
+    for (size_t dst = 0; dst < NUM_MOD_DSTS; ++dst)
+    {
+        dst_values[dst] = 0;
+    }
+
+    if (0 == mod_num_depth_routes)
+    {
+        mod_matrix_sum(src_values, dst_values, 0, mod_num_routes);
+        return;
+    }
+
+    int32_t scaled[NUM_MOD_SRCS];
+    for (size_t src = 0; src < NUM_MOD_SRCS; ++src)
+    {
+        scaled[src] = src_values[src];
+    }
+
+    mod_matrix_sum(src_values, dst_values, 0, mod_num_depth_routes);
+    for (size_t lfo_idx = 0; lfo_idx <= (MOD_DST_LFO_2_DEPTH - MOD_DST_LFO_1_DEPTH); ++lfo_idx)
+    {
+        int32_t const gain = mod_matrix_gain(dst_values[MOD_DST_LFO_1_DEPTH + lfo_idx]);
+        scaled[MOD_SRC_LFO_1 + lfo_idx]
+            = (int32_t)(((int64_t)scaled[MOD_SRC_LFO_1 + lfo_idx] * gain) >> MOD_VALUE_BITS);
+    }
+    mod_matrix_sum(scaled, dst_values, mod_num_depth_routes, mod_num_routes);
+}
+
+#endif
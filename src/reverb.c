@@ -0,0 +1,324 @@
+#include "reverb.h"
+
+#include "audio_engine.h"
+#include "fx.h"
+
+#include <midi64.h>
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Freeverb tuning at 44.1 kHz. The right channel's lines are longer by the
+/// stereo spread, which decorrelates the two tails.
+#define REVERB_STEREO_SPREAD 23
+
+/// Input gain with all eight combs, scaled up in proportion for presets
+/// with fewer so the tail keeps its level.
+#define REVERB_FIXED_GAIN 0.015f
+
+/// Comb feedback in Q15 across the size range, 0.7 to 0.98.
+#define REVERB_ROOM_OFFSET 22938
+#define REVERB_ROOM_SCALE 9175
+
+/// Comb damping at full setting, Q15, 0.4.
+#define REVERB_DAMP_SCALE 13107
+
+/// Tail level at full mix, Q15, 3.
+#define REVERB_WET_SCALE 98304
+
+/// One comb or allpass line, a 16-bit ring walked a sample at a time.
+/// store is the comb's damping low pass state.
+struct reverb_line_s
+{
+    int16_t * buf;
+    uint16_t len;
+    uint16_t idx;
+    int32_t store;
+};
+
+struct reverb_s reverb;
+
+static uint16_t const comb_tuning[REVERB_MAX_COMBS] =
+{
+    1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617
+};
+
+static uint16_t const allpass_tuning[REVERB_MAX_ALLPASSES] =
+{
+    556, 441, 341, 225
+};
+
+/// Lines run by each quality preset.
+static uint8_t const quality_num_combs[NUM_REVERB_QUALITIES] = { 4, 6, 8 };
+static uint8_t const quality_num_allpasses[NUM_REVERB_QUALITIES] = { 2, 3, 4 };
+
+/// Lines of the left and right channels, all in one allocation.
+static struct reverb_line_s combs[2][REVERB_MAX_COMBS];
+static struct reverb_line_s allpasses[2][REVERB_MAX_ALLPASSES];
+static int16_t * lines_mem = NULL;
+static size_t lines_mem_bytes = 0;
+static size_t num_combs = 0;
+static size_t num_allpasses = 0;
+static int32_t input_gain = 0;
+
+/// Mono input of the current block, and each channel's tail.
+static int32_t input_buf[CONTROL_BLOCK_SIZE];
+static int32_t tail_buf[2][CONTROL_BLOCK_SIZE];
+
+static bool reverb_alloc(enum reverb_quality_e quality);
+static inline void reverb_comb(struct reverb_line_s * line, int32_t const * in, int32_t * out,
+                               size_t num_samples, int32_t feedback, int32_t damp);
+static inline void reverb_allpass(struct reverb_line_s * line, int32_t * buf, size_t num_samples);
+static inline int16_t reverb_saturate(int32_t sample);
+
+void reverb_init(void)
+{
+    reverb.enabled = false;
+    reverb.size = 80;
+    reverb.damping = 64;
+    reverb.mix = 24;
+    reverb.width = MIDI_MAX_DATA_BYTE;
+
+    reverb.quality = REVERB_QUALITY_MEDIUM;
+    reverb_alloc(reverb.quality);
+}
+
+bool reverb_is_ready(void)
+{
+    return (NULL != lines_mem);
+}
+
+size_t reverb_get_mem_bytes(void)
+{
+    return lines_mem_bytes;
+}
+
+/// Switch to another quality preset. The reverb leaves the effects chain
+/// while its lines are reallocated, and rejoins it cleared.
+void reverb_set_quality(enum reverb_quality_e quality)
+{
+    bool const enabled = reverb.enabled;
+
+    reverb.enabled = false;
+    fx_update();
+
+    reverb_alloc(quality);
+
+    reverb.enabled = enabled;
+    fx_update();
+}
+
+/// Silence every line. Must not run while the reverb is in the effects chain.
+void reverb_reset(void)
+{
+    if (lines_mem)
+    {
+        memset(lines_mem, 0, lines_mem_bytes);
+    }
+
+    for (size_t ch = 0; ch < 2; ++ch)
+    {
+        for (size_t comb_idx = 0; comb_idx < REVERB_MAX_COMBS; ++comb_idx)
+        {
+            combs[ch][comb_idx].idx = 0;
+            combs[ch][comb_idx].store = 0;
+        }
+        for (size_t ap_idx = 0; ap_idx < REVERB_MAX_ALLPASSES; ++ap_idx)
+        {
+            allpasses[ch][ap_idx].idx = 0;
+        }
+    }
+}
+
+/// Add the reverb tail to a block of the bus. Each line processes the whole
+/// block before the next starts, so a line's buffer streams through the cache
+/// in order instead of every line being touched for every sample.
+void reverb_process(int32_t * mix_l, int32_t * mix_r, size_t num_samples)
+{
+    int32_t const feedback = REVERB_ROOM_OFFSET
+                             + ((reverb.size * REVERB_ROOM_SCALE) / MIDI_MAX_DATA_BYTE);
+    int32_t const damp = (reverb.damping * REVERB_DAMP_SCALE) / MIDI_MAX_DATA_BYTE;
+    int32_t const wet = (reverb.mix * REVERB_WET_SCALE) / MIDI_MAX_DATA_BYTE;
+    int32_t const wet_direct = (wet * (MIDI_MAX_DATA_BYTE + reverb.width))
+                               / (2 * MIDI_MAX_DATA_BYTE);
+    int32_t const wet_cross = (wet * (MIDI_MAX_DATA_BYTE - reverb.width))
+                              / (2 * MIDI_MAX_DATA_BYTE);
+
+    for (size_t i = 0; i < num_samples; ++i)
+    {
+        input_buf[i] = ((mix_l[i] + mix_r[i]) * input_gain) >> 15;
+    }
+
+    for (size_t ch = 0; ch < 2; ++ch)
+    {
+        memset(tail_buf[ch], 0, num_samples * sizeof(int32_t));
+
+        for (size_t comb_idx = 0; comb_idx < num_combs; ++comb_idx)
+        {
+            reverb_comb(&combs[ch][comb_idx], input_buf, tail_buf[ch], num_samples, feedback, damp);
+        }
+        for (size_t ap_idx = 0; ap_idx < num_allpasses; ++ap_idx)
+        {
+            reverb_allpass(&allpasses[ch][ap_idx], tail_buf[ch], num_samples);
+        }
+    }
+
+    for (size_t i = 0; i < num_samples; ++i)
+    {
+        int32_t const tail_l = tail_buf[0][i];
+        int32_t const tail_r = tail_buf[1][i];
+
+        mix_l[i] += (int32_t)((((int64_t)tail_l * wet_direct) + ((int64_t)tail_r * wet_cross)) >> 15);
+        mix_r[i] += (int32_t)((((int64_t)tail_r * wet_direct) + ((int64_t)tail_l * wet_cross)) >> 15);
+    }
+}
+
+/// Allocate the lines of a quality preset, shortened to fit the memory
+/// ceiling if needed. Falls back to a lower preset if RDRAM is short.
+static bool reverb_alloc(enum reverb_quality_e quality)
+{
+    free(lines_mem);
+    lines_mem = NULL;
+    lines_mem_bytes = 0;
+
+    for (int q = quality; q >= REVERB_QUALITY_LOW; --q)
+    {
+        size_t const q_combs = quality_num_combs[q];
+        size_t const q_allpasses = quality_num_allpasses[q];
+
+        size_t frames = 0;
+        for (size_t comb_idx = 0; comb_idx < q_combs; ++comb_idx)
+        {
+            frames += (2 * comb_tuning[comb_idx]) + REVERB_STEREO_SPREAD;
+        }
+        for (size_t ap_idx = 0; ap_idx < q_allpasses; ++ap_idx)
+        {
+            frames += (2 * allpass_tuning[ap_idx]) + REVERB_STEREO_SPREAD;
+        }
+
+        // Scale every line down together, in Q16, if over the ceiling.
+        uint32_t scale = 1u << 16;
+        if ((frames * sizeof(int16_t)) > REVERB_MEM_CEILING)
+        {
+            scale = ((uint64_t)REVERB_MEM_CEILING << 16) / (frames * sizeof(int16_t));
+        }
+
+        size_t scaled_frames = 0;
+        for (size_t ch = 0; ch < 2; ++ch)
+        {
+            size_t const spread = ch * REVERB_STEREO_SPREAD;
+
+            for (size_t comb_idx = 0; comb_idx < q_combs; ++comb_idx)
+            {
+                combs[ch][comb_idx].len = ((comb_tuning[comb_idx] + spread) * scale) >> 16;
+                scaled_frames += combs[ch][comb_idx].len;
+            }
+            for (size_t ap_idx = 0; ap_idx < q_allpasses; ++ap_idx)
+            {
+                allpasses[ch][ap_idx].len = ((allpass_tuning[ap_idx] + spread) * scale) >> 16;
+                scaled_frames += allpasses[ch][ap_idx].len;
+            }
+        }
+
+        int16_t * mem = malloc(scaled_frames * sizeof(int16_t));
+        if (NULL == mem)
+        {
+            continue;
+        }
+
+        int16_t * next = mem;
+        for (size_t ch = 0; ch < 2; ++ch)
+        {
+            for (size_t comb_idx = 0; comb_idx < q_combs; ++comb_idx)
+            {
+                combs[ch][comb_idx].buf = next;
+                next += combs[ch][comb_idx].len;
+            }
+            for (size_t ap_idx = 0; ap_idx < q_allpasses; ++ap_idx)
+            {
+                allpasses[ch][ap_idx].buf = next;
+                next += allpasses[ch][ap_idx].len;
+            }
+        }
+
+        lines_mem = mem;
+        lines_mem_bytes = scaled_frames * sizeof(int16_t);
+        num_combs = q_combs;
+        num_allpasses = q_allpasses;
+        input_gain = (int32_t)lroundf(((REVERB_FIXED_GAIN * REVERB_MAX_COMBS) / q_combs)
+                                      * (1 << 15));
+        reverb.quality = q;
+
+        reverb_reset();
+        return true;
+    }
+
+    return false;
+}
+
+/// Run a block through a damped comb, adding its output to out.
+__attribute__((always_inline))
+static inline void reverb_comb(struct reverb_line_s * line, int32_t const * in, int32_t * out,
+                               size_t num_samples, int32_t feedback, int32_t damp)
+{
+    int16_t * const buf = line->buf;
+    uint16_t const len = line->len;
+    uint16_t idx = line->idx;
+    int32_t store = line->store;
+
+    for (size_t i = 0; i < num_samples; ++i)
+    {
+        int32_t const delayed = buf[idx];
+
+        store = ((delayed * (32768 - damp)) + (store * damp)) >> 15;
+        buf[idx] = reverb_saturate(in[i] + ((store * feedback) >> 15));
+        out[i] += delayed;
+
+        if (++idx == len)
+        {
+            idx = 0;
+        }
+    }
+
+    line->idx = idx;
+    line->store = store;
+}
+
+/// Run a block through a Schroeder allpass in place, with a feedback of one
+/// half.
+__attribute__((always_inline))
+static inline void reverb_allpass(struct reverb_line_s * line, int32_t * buf, size_t num_samples)
+{
+    int16_t * const line_buf = line->buf;
+    uint16_t const len = line->len;
+    uint16_t idx = line->idx;
+
+    for (size_t i = 0; i < num_samples; ++i)
+    {
+        int32_t const delayed = line_buf[idx];
+        int32_t const in = buf[i];
+
+        buf[i] = delayed - in;
+        line_buf[idx] = reverb_saturate(in + (delayed >> 1));
+
+        if (++idx == len)
+        {
+            idx = 0;
+        }
+    }
+
+    line->idx = idx;
+}
+
+static inline int16_t reverb_saturate(int32_t sample)
+{
+    if (sample > INT16_MAX)
+        return INT16_MAX;
+    else if (sample < INT16_MIN)
+        return INT16_MIN;
+    return (int16_t)sample;
+}
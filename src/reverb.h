@@ -0,0 +1,50 @@
+#ifndef REVERB_H
+#define REVERB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Ceiling on the RDRAM taken by the reverb lines. A preset needing more has
+/// every line shortened in proportion.
+#define REVERB_MEM_CEILING (64 * 1024)
+
+#define REVERB_MAX_COMBS 8
+#define REVERB_MAX_ALLPASSES 4
+
+/// Quality presets, trading RDRAM and cycles for density of the tail.
+enum reverb_quality_e
+{
+    REVERB_QUALITY_LOW,
+    REVERB_QUALITY_MEDIUM,
+    REVERB_QUALITY_HIGH,
+    NUM_REVERB_QUALITIES
+};
+
+/// Reverb settings.
+/// size, damping, mix and width in [0,MIDI_MAX_DATA_BYTE]. size sets the
+/// comb feedback and so the decay time, damping the high frequency loss in
+/// each comb, mix the level of the tail added to the bus and width the
+/// stereo spread of the tail.
+/// quality is changed through reverb_set_quality(), which reallocates the
+/// lines.
+struct reverb_s
+{
+    bool enabled;
+    enum reverb_quality_e quality;
+    uint8_t size;
+    uint8_t damping;
+    uint8_t mix;
+    uint8_t width;
+};
+
+extern struct reverb_s reverb;
+
+void reverb_init(void);
+bool reverb_is_ready(void);
+size_t reverb_get_mem_bytes(void);
+void reverb_set_quality(enum reverb_quality_e quality);
+void reverb_reset(void);
+void reverb_process(int32_t * mix_l, int32_t * mix_r, size_t num_samples);
+
+#endif
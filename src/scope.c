@@ -0,0 +1,37 @@
+#include "scope.h"
+
+#include <n64sys.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+int16_t scope_ring[SCOPE_SIZE] = {0};
+volatile uint32_t scope_write_idx = 0;
+size_t scope_skip = 0;
+
+/// Copy the most recent num_samples published samples into dst, oldest first.
+/// Never blocks the audio callback. If the callback laps the copy, the
+/// snapshot is torn and false is returned so the caller can skip the frame.
+bool scope_read(int16_t * dst, size_t num_samples)
+{
+    if (num_samples > SCOPE_SIZE)
+    {
+        return false;
+    }
+
+    uint32_t const end_idx = scope_write_idx;
+    MEMORY_BARRIER();
+
+    uint32_t const start_idx = end_idx - num_samples;
+    for (size_t idx = 0; idx < num_samples; ++idx)
+    {
+        dst[idx] = scope_ring[(start_idx + idx) & (SCOPE_SIZE - 1)];
+    }
+
+    MEMORY_BARRIER();
+
+    // The oldest entry copied is only overwritten once the writer has moved
+    // a full ring past it.
+    return ((scope_write_idx - start_idx) <= SCOPE_SIZE);
+}
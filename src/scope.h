@@ -0,0 +1,50 @@
+#ifndef SCOPE_H
+#define SCOPE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <n64sys.h>
+
+#define SCOPE_BIT_DEPTH 10 // 1024 ring entries
+#define SCOPE_SIZE (1 << SCOPE_BIT_DEPTH)
+#define SCOPE_DECIMATION 4
+
+/// Ring of decimated output samples. Written only by the audio callback via
+/// scope_tap(), read by the GUI via scope_read().
+extern int16_t scope_ring[SCOPE_SIZE];
+
+/// Free-running count of samples published to the ring. The audio callback
+/// is the single writer and only advances it after the samples are stored.
+extern volatile uint32_t scope_write_idx;
+
+/// Number of output samples to skip before the next tap, carried across
+/// buffers so the decimation stride is continuous.
+extern size_t scope_skip;
+
+bool scope_read(int16_t * dst, size_t num_samples);
+
+/// Publish every SCOPE_DECIMATION-th frame of a finished stereo buffer to
+/// the scope ring, as the mid of its left and right samples. Runs once per buffer after synthesis, so the per-sample
+/// render loop is untouched.
+static inline void scope_tap(short const * buffer, size_t num_samples)
+{
+    uint32_t write_idx = scope_write_idx;
+    size_t sample_idx = scope_skip;
+
+    for (; sample_idx < num_samples; sample_idx += SCOPE_DECIMATION)
+    {
+        scope_ring[write_idx & (SCOPE_SIZE - 1)]
+            = (int16_t)((buffer[sample_idx * 2] + buffer[(sample_idx * 2) + 1]) >> 1);
+        ++write_idx;
+    }
+
+    scope_skip = sample_idx - num_samples;
+
+    // Samples must land before the index that publishes them.
+    MEMORY_BARRIER();
+    scope_write_idx = write_idx;
+}
+
+#endif
@@ -0,0 +1,242 @@
+#include "spectrum.h"
+
+#include "audio_engine.h"
+
+#include <n64sys.h>
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SPECTRUM_BAR_FALL_DB 3
+
+/// Lowest bin counted towards THD+N, above the window's DC leakage, and the
+/// half width of the window's main lobe counted as the tone itself.
+#define SPECTRUM_THDN_MIN_BIN 5
+#define SPECTRUM_THDN_LOBE_BINS 5
+
+/// Bin power of a full scale sine after the window, as log2 in Q4.
+/// Amplitude INT16_MAX * 0.359 (window gain) * N / 2 is ~2^21.5, power ~2^43.
+#define SPECTRUM_FULL_SCALE_LOG2_Q4 (((2 * (SPECTRUM_FFT_BITS + 13)) << 4) - 15)
+
+int16_t spectrum_ring[SPECTRUM_FFT_SIZE] = {0};
+volatile uint32_t spectrum_write_idx = 0;
+volatile bool spectrum_armed = false;
+
+uint8_t spectrum_bars[SPECTRUM_NUM_BARS] = {0};
+uint16_t spectrum_bar_bins[SPECTRUM_NUM_BARS + 1] = {0};
+uint32_t spectrum_fft_us = 0;
+int16_t spectrum_thdn_db = 0;
+
+static bool spectrum_enabled = false;
+static uint32_t spectrum_arm_idx = 0;
+
+/// Q15 window and twiddle factors, generated once at init.
+/// The 4-term Blackman-Harris window keeps leakage below -92 dB, so a pure
+/// tone stays a narrow peak on the bars and THD+N can be measured well below
+/// the noise of the table kernels.
+static int16_t window_tbl[SPECTRUM_FFT_SIZE];
+static int16_t twiddle_cos[SPECTRUM_FFT_SIZE / 2];
+static int16_t twiddle_sin[SPECTRUM_FFT_SIZE / 2];
+
+/// FFT working buffers. 32 bits of headroom lets the transform run without
+/// per-stage scaling: 16 bit input grows by at most SPECTRUM_FFT_BITS bits.
+static int32_t fft_re[SPECTRUM_FFT_SIZE];
+static int32_t fft_im[SPECTRUM_FFT_SIZE];
+
+/// log2(1 + i/16) in Q4, for the mantissa step of spectrum_log2_q4().
+static uint8_t const log2_mantissa_q4[16] =
+{
+    0, 1, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 15
+};
+
+static void spectrum_arm(void);
+static int32_t spectrum_log2_q4(uint64_t value);
+static uint64_t spectrum_bin_power(size_t bin);
+
+/// Generate the window, twiddles and log-spaced bar edges.
+void spectrum_init(void)
+{
+    float const two_pi = 2.0f * M_PI;
+
+    for (size_t idx = 0; idx < SPECTRUM_FFT_SIZE; ++idx)
+    {
+        float const x = (two_pi * idx) / SPECTRUM_FFT_SIZE;
+        float const window = 0.35875f
+                             - (0.48829f * cosf(x))
+                             + (0.14128f * cosf(2.0f * x))
+                             - (0.01168f * cosf(3.0f * x));
+        window_tbl[idx] = (int16_t)(window * INT16_MAX);
+    }
+
+    spectrum_fft_twiddles(twiddle_cos, twiddle_sin);
+
+    // Bars span bin 1 up to Nyquist on a log scale. Low bars are at least
+    // one bin wide, so the bottom of the range is effectively linear.
+    float const num_bins = SPECTRUM_FFT_SIZE / 2;
+    uint16_t prev_bin = 0;
+    for (size_t bar = 0; bar <= SPECTRUM_NUM_BARS; ++bar)
+    {
+        uint16_t bin = (uint16_t)powf(num_bins, (float)bar / SPECTRUM_NUM_BARS);
+        if (bin <= prev_bin)
+        {
+            bin = prev_bin + 1;
+        }
+        spectrum_bar_bins[bar] = bin;
+        prev_bin = bin;
+    }
+    spectrum_bar_bins[SPECTRUM_NUM_BARS] = SPECTRUM_FFT_SIZE / 2;
+}
+
+/// Start or stop capturing. Only the DEBUG screen needs the analyzer, so the
+/// audio callback pays nothing for it elsewhere.
+void spectrum_enable(bool enable)
+{
+    spectrum_enabled = enable;
+
+    if (enable)
+    {
+        spectrum_arm();
+    }
+    else
+    {
+        spectrum_armed = false;
+    }
+}
+
+static void spectrum_arm(void)
+{
+    spectrum_arm_idx = spectrum_write_idx;
+    MEMORY_BARRIER();
+    spectrum_armed = true;
+}
+
+/// Main loop idle work. Once a full capture is available, window it, run the
+/// FFT, reduce the bins to log-frequency bars, and re-arm the capture.
+/// Returns true if the bars changed.
+bool spectrum_process(void)
+{
+    if (!spectrum_enabled
+        || ((spectrum_write_idx - spectrum_arm_idx) < SPECTRUM_FFT_SIZE))
+    {
+        return false;
+    }
+
+    spectrum_armed = false;
+    MEMORY_BARRIER();
+
+    uint32_t const start_ticks = TICKS_READ();
+
+    uint32_t const start_idx = spectrum_write_idx - SPECTRUM_FFT_SIZE;
+    for (size_t idx = 0; idx < SPECTRUM_FFT_SIZE; ++idx)
+    {
+        int32_t const sample = spectrum_ring[(start_idx + idx) & (SPECTRUM_FFT_SIZE - 1)];
+        fft_re[idx] = (sample * window_tbl[idx]) >> SPECTRUM_Q;
+        fft_im[idx] = 0;
+    }
+
+    spectrum_arm();
+
+    spectrum_fft(fft_re, fft_im, twiddle_cos, twiddle_sin);
+
+    uint64_t total_power = 0;
+    uint64_t peak_power = 0;
+    size_t peak_bin = SPECTRUM_THDN_MIN_BIN;
+
+    bool changed = false;
+    for (size_t bar = 0; bar < SPECTRUM_NUM_BARS; ++bar)
+    {
+        uint64_t max_power = 0;
+        for (size_t bin = spectrum_bar_bins[bar]; bin < spectrum_bar_bins[bar + 1]; ++bin)
+        {
+            uint64_t const power = spectrum_bin_power(bin);
+            if (power > max_power)
+            {
+                max_power = power;
+            }
+
+            if (bin >= SPECTRUM_THDN_MIN_BIN)
+            {
+                total_power += power;
+                if (power > peak_power)
+                {
+                    peak_power = power;
+                    peak_bin = bin;
+                }
+            }
+        }
+
+        // 10 * log10(p) = 3.01 * log2(p), in Q4 log2 units: dB ~= (x * 3) >> 4
+        int32_t db = SPECTRUM_FLOOR_DB
+                     + (((spectrum_log2_q4(max_power) - SPECTRUM_FULL_SCALE_LOG2_Q4) * 3) >> 4);
+        if (db < 0)
+        {
+            db = 0;
+        }
+        else if (db > SPECTRUM_FLOOR_DB)
+        {
+            db = SPECTRUM_FLOOR_DB;
+        }
+
+        // Fast attack, limited fall rate so short dips stay readable.
+        if ((db + SPECTRUM_BAR_FALL_DB) < spectrum_bars[bar])
+        {
+            db = spectrum_bars[bar] - SPECTRUM_BAR_FALL_DB;
+        }
+
+        if (spectrum_bars[bar] != db)
+        {
+            spectrum_bars[bar] = (uint8_t)db;
+            changed = true;
+        }
+    }
+
+    uint64_t tone_power = 0;
+    for (size_t bin = peak_bin - SPECTRUM_THDN_LOBE_BINS;
+         bin <= (peak_bin + SPECTRUM_THDN_LOBE_BINS);
+         ++bin)
+    {
+        if ((bin >= SPECTRUM_THDN_MIN_BIN) && (bin < (SPECTRUM_FFT_SIZE / 2)))
+        {
+            tone_power += spectrum_bin_power(bin);
+        }
+    }
+
+    uint64_t const noise_power = total_power - tone_power;
+    if ((tone_power > 0) && (noise_power > 0))
+    {
+        spectrum_thdn_db = (int16_t)(((spectrum_log2_q4(noise_power)
+                                       - spectrum_log2_q4(tone_power)) * 3) >> 4);
+    }
+    else
+    {
+        spectrum_thdn_db = 0;
+    }
+
+    spectrum_fft_us = TICKS_TO_US(TICKS_DISTANCE(start_ticks, TICKS_READ()));
+
+    return changed;
+}
+
+static uint64_t spectrum_bin_power(size_t bin)
+{
+    return ((int64_t)fft_re[bin] * fft_re[bin])
+           + ((int64_t)fft_im[bin] * fft_im[bin]);
+}
+
+/// Integer log2 in Q4. Returns 0 for inputs below 1.
+static int32_t spectrum_log2_q4(uint64_t value)
+{
+    if (0 == value)
+    {
+        return 0;
+    }
+
+    int32_t const exponent = 63 - __builtin_clzll(value);
+    uint32_t const mantissa = (exponent >= 4)
+                              ? (uint32_t)(value >> (exponent - 4)) & 0xF
+                              : (uint32_t)(value << (4 - exponent)) & 0xF;
+
+    return (exponent << 4) + log2_mantissa_q4[mantissa];
+}
@@ -0,0 +1,60 @@
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <n64sys.h>
+
+#include "spectrum_fft.h"
+
+#define SPECTRUM_NUM_BARS 48
+#define SPECTRUM_FLOOR_DB 72
+
+/// Capture ring for full-rate output samples. The audio callback writes to it
+/// only while armed; the main loop disarms it before reading, so a capture is
+/// never read while it is being written.
+extern int16_t spectrum_ring[SPECTRUM_FFT_SIZE];
+extern volatile uint32_t spectrum_write_idx;
+extern volatile bool spectrum_armed;
+
+/// Bar heights in dB above the analysis floor, [0, SPECTRUM_FLOOR_DB].
+extern uint8_t spectrum_bars[SPECTRUM_NUM_BARS];
+
+/// Lower FFT bin of each bar, plus the upper bound of the last bar.
+extern uint16_t spectrum_bar_bins[SPECTRUM_NUM_BARS + 1];
+
+/// Duration of the most recent FFT and bar reduction in microseconds.
+extern uint32_t spectrum_fft_us;
+
+/// THD+N of the most recent capture in dB: the power of every bin outside
+/// the strongest peak relative to the peak. Only meaningful while a single
+/// steady tone is playing.
+extern int16_t spectrum_thdn_db;
+
+void spectrum_init(void);
+void spectrum_enable(bool enable);
+bool spectrum_process(void);
+
+/// Copy the mid of a finished stereo buffer into the capture ring while a
+/// capture is armed. Costs one flag test per buffer otherwise.
+static inline void spectrum_tap(short const * buffer, size_t num_samples)
+{
+    if (spectrum_armed)
+    {
+        uint32_t write_idx = spectrum_write_idx;
+
+        for (size_t idx = 0; idx < num_samples; ++idx)
+        {
+            spectrum_ring[write_idx & (SPECTRUM_FFT_SIZE - 1)]
+                = (int16_t)((buffer[idx * 2] + buffer[(idx * 2) + 1]) >> 1);
+            ++write_idx;
+        }
+
+        MEMORY_BARRIER();
+        spectrum_write_idx = write_idx;
+    }
+}
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef SPECTRUM_FFT_H
+#define SPECTRUM_FFT_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// The FFT kernel of the spectrum analyzer, kept free of libdragon so the
+/// host benchmark in tools/spectrum_bench.c runs the same code.
+
+#define SPECTRUM_FFT_BITS 9 // 512 point FFT, ~86 Hz per bin
+#define SPECTRUM_FFT_SIZE (1 << SPECTRUM_FFT_BITS)
+#define SPECTRUM_Q 15
+
+/// VR4300 cost model of the kernel. A butterfly is four DMULTs at 8 cycles
+/// each plus about 18 cycles of loads, adds and stores, and the bit reversal
+/// about 12 cycles a point.
+#define SPECTRUM_FFT_CPU_HZ 93750000
+#define SPECTRUM_FFT_BUTTERFLY_CYCLES 50
+#define SPECTRUM_FFT_REORDER_CYCLES 12
+
+/// Main loop time the FFT may take out of a 16.7 ms frame: a quarter, as the
+/// audio callback, drawing and input share the rest.
+/// At 512 points the model gives ~1.3 ms, and 1024 points would still fit
+/// at ~2.8 ms, but its 23 ms capture would span more than a frame, so 512
+/// keeps a fresh capture every frame. make spectrum-bench checks the size
+/// against the budget and the kernel's accuracy on host, and
+/// spectrum_fft_us reads the real figure on hardware.
+#define SPECTRUM_FFT_BUDGET_US 4166
+
+/// Return the modelled VR4300 time of a transform of 2^bits points.
+static inline uint32_t spectrum_fft_model_us(size_t bits)
+{
+    uint64_t const size = 1u << bits;
+    uint64_t const cycles = ((size / 2) * bits * SPECTRUM_FFT_BUTTERFLY_CYCLES)
+                            + (size * SPECTRUM_FFT_REORDER_CYCLES);
+
+    return (uint32_t)((cycles * 1000000) / SPECTRUM_FFT_CPU_HZ);
+}
+
+/// Generate the Q15 twiddle factors, half a turn of cosine and sine.
+static inline void spectrum_fft_twiddles(int16_t * twiddle_cos, int16_t * twiddle_sin)
+{
+    float const two_pi = 2.0f * M_PI;
+
+    for (size_t idx = 0; idx < (SPECTRUM_FFT_SIZE / 2); ++idx)
+    {
+        twiddle_cos[idx] = (int16_t)(cosf((two_pi * idx) / SPECTRUM_FFT_SIZE) * INT16_MAX);
+        twiddle_sin[idx] = (int16_t)(sinf((two_pi * idx) / SPECTRUM_FFT_SIZE) * INT16_MAX);
+    }
+}
+
+/// In-place radix-2 decimation-in-time FFT on Q0 data with Q15 twiddles.
+/// Each butterfly is 4 multiplies and 6 adds; a 512 point transform is 2304
+/// butterflies.
+static inline void spectrum_fft(int32_t * re, int32_t * im,
+                                int16_t const * twiddle_cos, int16_t const * twiddle_sin)
+{
+    // Bit-reversal permutation
+    for (uint32_t idx = 1, rev = 0; idx < SPECTRUM_FFT_SIZE; ++idx)
+    {
+        uint32_t bit = SPECTRUM_FFT_SIZE >> 1;
+        for (; rev & bit; bit >>= 1)
+        {
+            rev ^= bit;
+        }
+        rev ^= bit;
+
+        if (idx < rev)
+        {
+            int32_t const tmp_re = re[idx];
+            re[idx] = re[rev];
+            re[rev] = tmp_re;
+
+            int32_t const tmp_im = im[idx];
+            im[idx] = im[rev];
+            im[rev] = tmp_im;
+        }
+    }
+
+    for (size_t half = 1, tw_shift = SPECTRUM_FFT_BITS - 1;
+         half < SPECTRUM_FFT_SIZE;
+         half <<= 1, --tw_shift)
+    {
+        for (size_t k = 0; k < half; ++k)
+        {
+            int32_t const w_re = twiddle_cos[k << tw_shift];
+            int32_t const w_im = -twiddle_sin[k << tw_shift];
+
+            for (size_t top = k; top < SPECTRUM_FFT_SIZE; top += (half << 1))
+            {
+                size_t const bot = top + half;
+
+                int32_t const t_re = (int32_t)((((int64_t)re[bot] * w_re) - ((int64_t)im[bot] * w_im)) >> SPECTRUM_Q);
+                int32_t const t_im = (int32_t)((((int64_t)re[bot] * w_im) + ((int64_t)im[bot] * w_re)) >> SPECTRUM_Q);
+
+                re[bot] = re[top] - t_re;
+                im[bot] = im[top] - t_im;
+                re[top] += t_re;
+                im[top] += t_im;
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,81 @@
+#include "tempo.h"
+
+#include "audio_engine.h"
+
+#include <libdragon.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// A gap between clock pulses longer than a pulse at 20 BPM means the clock
+/// stopped, and the next pulse starts a new measurement.
+#define TEMPO_CLOCK_TIMEOUT_TICKS (TICKS_PER_SECOND / 8)
+
+#define TEMPO_SAMPLES_PER_BEAT(bpm) ((SAMPLE_RATE * 60u) / (bpm))
+
+struct tempo_s tempo =
+{
+    .source = TEMPO_MANUAL,
+    .bpm = TEMPO_BPM_DEFAULT,
+    .midi_samples_per_beat = TEMPO_SAMPLES_PER_BEAT(TEMPO_BPM_DEFAULT),
+    .samples_per_beat = TEMPO_SAMPLES_PER_BEAT(TEMPO_BPM_DEFAULT),
+};
+
+/// Pulse intervals counted toward the beat being measured, when it started,
+/// and when the last pulse arrived.
+static bool clock_running = false;
+static uint8_t clock_count = 0;
+static uint32_t clock_beat_start_ticks = 0;
+static uint32_t clock_last_ticks = 0;
+
+void tempo_set_source(enum tempo_source_e source)
+{
+    tempo.source = source;
+    tempo.samples_per_beat = (TEMPO_MIDI == source)
+                             ? tempo.midi_samples_per_beat
+                             : TEMPO_SAMPLES_PER_BEAT(tempo.bpm);
+}
+
+void tempo_set_bpm(uint16_t bpm)
+{
+    tempo.bpm = bpm;
+    if (TEMPO_MANUAL == tempo.source)
+    {
+        tempo.samples_per_beat = TEMPO_SAMPLES_PER_BEAT(bpm);
+    }
+}
+
+/// Count a MIDI timing clock pulse. The clock is polled from the main loop,
+/// so single pulses jitter by the poll period; the tempo is measured over a
+/// whole beat of pulses, which averages that out, and updated once per beat.
+void tempo_midi_clock(void)
+{
+    uint32_t const now = TICKS_READ();
+
+    if (!clock_running || (TICKS_DISTANCE(clock_last_ticks, now) > TEMPO_CLOCK_TIMEOUT_TICKS))
+    {
+        clock_running = true;
+        clock_beat_start_ticks = now;
+        clock_count = 0;
+    }
+    else if (TEMPO_CLOCKS_PER_BEAT == ++clock_count)
+    {
+        uint32_t const beat_ticks = TICKS_DISTANCE(clock_beat_start_ticks, now);
+        tempo.midi_samples_per_beat = ((uint64_t)beat_ticks * SAMPLE_RATE) / TICKS_PER_SECOND;
+        if (TEMPO_MIDI == tempo.source)
+        {
+            tempo.samples_per_beat = tempo.midi_samples_per_beat;
+        }
+
+        // This pulse also starts the next beat.
+        clock_beat_start_ticks = now;
+        clock_count = 0;
+    }
+    clock_last_ticks = now;
+}
+
+/// Return the tempo in use in beats per minute.
+float tempo_get_bpm(void)
+{
+    return ((float)SAMPLE_RATE * 60) / tempo.samples_per_beat;
+}
@@ -0,0 +1,41 @@
+#ifndef TEMPO_H
+#define TEMPO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// Manual tempo range in beats per minute.
+#define TEMPO_BPM_MIN 40
+#define TEMPO_BPM_MAX 240
+#define TEMPO_BPM_DEFAULT 120
+
+/// MIDI clock runs at 24 pulses per quarter note.
+#define TEMPO_CLOCKS_PER_BEAT 24
+
+enum tempo_source_e
+{
+    TEMPO_MANUAL,
+    TEMPO_MIDI,
+    NUM_TEMPO_SOURCES
+};
+
+/// Tempo shared by the tempo-synced effects.
+/// samples_per_beat is the length of a quarter note at the sample rate, from
+/// the manual bpm or from the measured MIDI clock, and is the only field the
+/// audio callback reads.
+struct tempo_s
+{
+    enum tempo_source_e source;
+    uint16_t bpm;
+    uint32_t midi_samples_per_beat;
+    volatile uint32_t samples_per_beat;
+};
+
+extern struct tempo_s tempo;
+
+void tempo_set_source(enum tempo_source_e source);
+void tempo_set_bpm(uint16_t bpm);
+void tempo_midi_clock(void);
+float tempo_get_bpm(void);
+
+#endif
@@ -2,31 +2,85 @@
 
 #include "audio_engine.h"
 #include "envelope.h"
+#include "filter.h"
 #include "wavetable.h"
 
-#include <n64sys.h>
+#include <libdragon.h>
 #include <midi64.h>
 
+#include <math.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 voice_t voices[POLYPHONY_COUNT];
 
+/// Copies of stolen voices, rendered alongside the voices while they fade
+/// out. Never handed a note.
+voice_t voice_shadows[VOICE_NUM_SHADOWS];
+
+/// Key tracked stereo spread of the voices in [0,MIDI_MAX_DATA_BYTE]. At full
+/// spread the keyboard sweeps from hard left to hard right, centred on middle
+/// C; at zero every voice is centred.
+uint8_t voice_pan_spread = 0;
+
+/// Output level, in dB below full scale, under which a releasing voice is
+/// cut off and its slot freed; zero never culls. voice_cull_level is the
+/// same threshold on the envelope scale, for the audio callback.
+uint8_t voice_cull_db = 0;
+uint32_t voice_cull_level = 0;
+
+/// Pitch bend shared by every voice, in WT_PITCH_FRAC_BITS fixed point
+/// semitones.
+int32_t voice_pitch_bend = 0;
+
+static void voice_set_pitch(voice_t * voice, size_t wav_idx);
+static void voice_steal(voice_t * voice);
+
 void voice_init(void)
 {
+    filter_init();
+    voice_set_cull_db(VOICE_CULL_DB_DEFAULT);
+
     for (size_t voice_idx = 0; voice_idx < POLYPHONY_COUNT; ++voice_idx)
     {
         voice_t * voice = &voices[voice_idx];
         voice->note = 0u;
-        voice->phase = 0u;
-        voice->tune = 0u;
+        voice->velocity = 0u;
+        voice->pan = WT_PAN_CENTER;
         voice->timestamp = 0u;
 
         for (size_t wav_idx = 0; wav_idx < NUM_OSCILLATORS; ++wav_idx)
         {
-            voice->amp_env_state[wav_idx].stage = IDLE;
-            voice->amp_env_state[wav_idx].level = 0u;
-            voice->amp_env_state[wav_idx].rate = 0u;
+            voice->phase[wav_idx] = 0u;
+            voice->pitch[wav_idx] = 0;
+
+            // Scatter the free running sub-oscillator phases by the golden
+            // ratio, so no two start together.
+            for (size_t sub_idx = 0; sub_idx < WT_MAX_UNISON; ++sub_idx)
+            {
+                voice->unison_phase[wav_idx][sub_idx]
+                    = (uint32_t)(((voice_idx * WT_MAX_UNISON) + sub_idx) * 0x9E3779B9u);
+            }
+            voice->morph_pos[wav_idx] = VOICE_MORPH_POS_NONE;
+        }
+
+        memset(voice->filter_state, 0, sizeof(voice->filter_state));
+
+        for (size_t env_idx = 0; env_idx < NUM_ENVELOPES; ++env_idx)
+        {
+            envelope_reset(&voice->env_state[env_idx]);
+        }
+        memset(voice->mod, 0, sizeof(voice->mod));
+        memset(voice->lfo_phase, 0, sizeof(voice->lfo_phase));
+    }
+
+    for (size_t shadow_idx = 0; shadow_idx < VOICE_NUM_SHADOWS; ++shadow_idx)
+    {
+        for (size_t env_idx = 0; env_idx < NUM_ENVELOPES; ++env_idx)
+        {
+            envelope_reset(&voice_shadows[shadow_idx].env_state[env_idx]);
         }
     }
 }
@@ -47,18 +101,9 @@ voice_t * voice_find_next(void)
         }
 
         // If any waveform is active & non-IDLE, do not select it.
-        for (size_t wav_idx = 0; wav_idx < NUM_OSCILLATORS; ++wav_idx)
+        if (voice_is_idle(&voices[voice_idx]))
         {
-            if ((NONE != oscillators[wav_idx].shape)
-                && (IDLE != voices[voice_idx].amp_env_state[wav_idx].stage))
-            {
-                break;
-            }
-
-            if ((NUM_OSCILLATORS - 1) == wav_idx)
-            {
-                voice = &voices[voice_idx];
-            }
+            voice = &voices[voice_idx];
         }
     }
 
@@ -66,6 +111,7 @@ voice_t * voice_find_next(void)
     if (!voice)
     {
         voice = &voices[oldest_voice_idx];
+        voice_steal(voice);
     }
 
     return voice;
@@ -86,9 +132,11 @@ voice_t * voice_find_for_note_off(uint8_t note)
             // the note is active - select it.
             for (size_t wav_idx = 0; wav_idx < NUM_OSCILLATORS; ++wav_idx)
             {
+                struct envelope_state_s const * env
+                    = &voices[voice_idx].env_state[oscillators[wav_idx].amp_env_idx];
                 if ((NONE != oscillators[wav_idx].shape)
-                    && (IDLE != voices[voice_idx].amp_env_state[wav_idx].stage)
-                    && (RELEASE != voices[voice_idx].amp_env_state[wav_idx].stage))
+                    && (IDLE != env->stage)
+                    && (RELEASE != env->stage))
                 {
                     voice = &voices[voice_idx];
                     break;
@@ -101,34 +149,147 @@ voice_t * voice_find_for_note_off(uint8_t note)
 }
 
 
-void voice_note_on(voice_t * voice, uint8_t note)
+void voice_note_on(voice_t * voice, uint8_t note, uint8_t velocity)
 {
     voice->note = note;
-    voice->tune = wavetable_get_midi_tune(note);
-    for (size_t wav_idx = 0; wav_idx < NUM_OSCILLATORS; ++wav_idx)
+    voice->velocity = velocity;
+
+    int16_t pan = WT_PAN_CENTER + ((((int16_t)note - 60) * voice_pan_spread) / MIDI_MAX_DATA_BYTE);
+    if (pan < 0)
     {
-        if (NONE != oscillators[wav_idx].shape)
+        pan = 0;
+    }
+    else if (pan > MIDI_MAX_DATA_BYTE)
+    {
+        pan = MIDI_MAX_DATA_BYTE;
+    }
+    voice->pan = (uint8_t)pan;
+
+    // A voice coming out of silence starts its filter from rest, rather
+    // than ringing out what was left in it when its last note died.
+    if (voice_is_idle(voice))
+    {
+        memset(voice->filter_state, 0, sizeof(voice->filter_state));
+    }
+
+    for (size_t lfo_idx = 0; lfo_idx < NUM_LFOS; ++lfo_idx)
+    {
+        if (LFO_SYNC_KEY == lfos[lfo_idx].sync)
         {
-            voice->amp_env_state[wav_idx].stage = ATTACK;
-            voice->amp_env_state[wav_idx].rate
-                = (UINT32_MAX - voice->amp_env_state[wav_idx].level)
-                    / envelope_get_trans_samples(oscillators[wav_idx].amp_env_idx, ATTACK);
+            voice->lfo_phase[lfo_idx] = 0u;
         }
+        else if (LFO_SYNC_RANDOM == lfos[lfo_idx].sync)
+        {
+            // The count at note on is as good as random, and the golden
+            // ratio spreads neighbouring counts around the cycle.
+            voice->lfo_phase[lfo_idx] = (uint32_t)(get_ticks() * 0x9E3779B9u) + (lfo_idx << 30);
+        }
+    }
+
+    for (size_t env_idx = 0; env_idx < NUM_ENVELOPES; ++env_idx)
+    {
+        envelope_trigger(&voice->env_state[env_idx], env_idx);
+    }
+
+    for (size_t wav_idx = 0; wav_idx < NUM_OSCILLATORS; ++wav_idx)
+    {
+        voice_set_pitch(voice, wav_idx);
+
+        // Start every oscillator in step with the first, so phase offsets
+        // between them hold from the first sample.
+        voice->phase[wav_idx] = voice->phase[0];
+
+        voice->morph_pos[wav_idx] = VOICE_MORPH_POS_NONE;
     }
     voice->timestamp = get_ticks();
 }
 
 void voice_note_off(voice_t * voice)
+{
+    for (size_t env_idx = 0; env_idx < NUM_ENVELOPES; ++env_idx)
+    {
+        envelope_release(&voice->env_state[env_idx], env_idx);
+    }
+}
+
+void voice_set_cull_db(uint8_t db)
+{
+    if (VOICE_CULL_DB_MAX < db)
+    {
+        db = VOICE_CULL_DB_MAX;
+    }
+
+    voice_cull_db = db;
+    voice_cull_level = (0 == db) ? 0u
+                                 : (uint32_t)(UINT32_MAX * powf(10.0f, -(float)db / 20.0f));
+}
+
+/// Set the pitch bend from a 14 bit wheel value, centered at 8192.
+void voice_set_pitch_bend(uint16_t bend)
+{
+    voice_pitch_bend = (((int32_t)bend - 8192) * (VOICE_BEND_RANGE << WT_PITCH_FRAC_BITS)) / 8192;
+}
+
+/// Recompute the pitch of an oscillator in every voice after its tuning or
+/// unison detune changed, so held notes follow the edit.
+void voice_retune(size_t wav_idx)
+{
+    for (size_t voice_idx = 0; voice_idx < POLYPHONY_COUNT; ++voice_idx)
+    {
+        voice_set_pitch(&voices[voice_idx], wav_idx);
+    }
+}
+
+/// Return true if no oscillator of the voice is sounding.
+bool voice_is_idle(voice_t const * voice)
 {
     for (size_t wav_idx = 0; wav_idx < NUM_OSCILLATORS; ++wav_idx)
     {
-        if (NONE != oscillators[wav_idx].shape)
+        if ((NONE != oscillators[wav_idx].shape)
+            && (IDLE != voice->env_state[oscillators[wav_idx].amp_env_idx].stage))
         {
-            if (IDLE != voice->amp_env_state[wav_idx].stage)
-            {
-                voice->amp_env_state[wav_idx].stage = RELEASE;
-                voice->amp_env_state[wav_idx].rate = (voice->amp_env_state[wav_idx].level - 0) / envelope_get_trans_samples(oscillators[wav_idx].amp_env_idx, RELEASE);
-            }
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Hand a stolen voice's sound to a shadow voice that fades it out, and
+/// silence the voice so its next note starts from rest instead of jumping
+/// pitch mid-sound. A fading shadow is reused only when none is idle, taking
+/// the one that started fading first.
+static void voice_steal(voice_t * voice)
+{
+    uint32_t const fade_samples = (SAMPLE_RATE * VOICE_STEAL_FADE_MS) / 1000;
+    voice_t * shadow = &voice_shadows[0];
+
+    for (size_t shadow_idx = 0; shadow_idx < VOICE_NUM_SHADOWS; ++shadow_idx)
+    {
+        if (voice_is_idle(&voice_shadows[shadow_idx]))
+        {
+            shadow = &voice_shadows[shadow_idx];
+            break;
         }
+        if (voice_shadows[shadow_idx].timestamp < shadow->timestamp)
+        {
+            shadow = &voice_shadows[shadow_idx];
+        }
+    }
+
+    disable_interrupts();
+    *shadow = *voice;
+    shadow->timestamp = get_ticks();
+    for (size_t env_idx = 0; env_idx < NUM_ENVELOPES; ++env_idx)
+    {
+        envelope_fade(&shadow->env_state[env_idx], env_idx, fade_samples);
+        envelope_reset(&voice->env_state[env_idx]);
     }
+    enable_interrupts();
+}
+
+/// Derive the pitch of an oscillator from the voice's note. Unison
+/// sub-oscillators add their detune to it when rendering.
+static void voice_set_pitch(voice_t * voice, size_t wav_idx)
+{
+    voice->pitch[wav_idx] = wavetable_get_osc_pitch(voice->note, &oscillators[wav_idx]);
 }
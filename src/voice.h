@@ -1,34 +1,91 @@
 #ifndef VOICE_H
 #define VOICE_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 #include "envelope.h"
+#include "filter.h"
+#include "lfo.h"
+#include "mod_matrix.h"
 #include "wavetable.h"
 
 #include <midi64.h>
 
 #define POLYPHONY_COUNT 8
 
+/// Cull threshold at start up, and the most that can be set, in dB below
+/// full scale.
+#define VOICE_CULL_DB_DEFAULT 96
+#define VOICE_CULL_DB_MAX 120
+
+/// Shadow voices fading out stolen notes, and how long the fade takes.
+#define VOICE_NUM_SHADOWS 2
+#define VOICE_STEAL_FADE_MS 3
+
+/// Pitch bend range in semitones either side of center.
+#define VOICE_BEND_RANGE 2
+
+/// morph_pos value meaning the oscillator has not rendered a block since
+/// note on, so its position starts at the target rather than gliding to it.
+#define VOICE_MORPH_POS_NONE UINT32_MAX
+
+/// Per-oscillator phase and pitch are kept in arrays indexed by oscillator, so
+/// the render loop streams through them in order.
+/// pitch is derived from the note and the oscillator's coarse and fine tuning
+/// at note on, and again by voice_retune() when the tuning changes. It is a
+/// WT_PITCH_FRAC_BITS fixed point note number, turned into a phase increment
+/// each block once bend and modulation are added.
+/// unison_phase is the packed state of the unison sub-oscillators, each row
+/// contiguous so the bank renders in tight loops. Their phases run free and
+/// are never reset, so the unison does not start every note with the same
+/// transient.
+/// pan is the voice's place in the stereo field, set from its note at note
+/// on, around which each oscillator's own pan is applied.
+/// env_state runs each envelope once per control block, shared by every
+/// destination reading it: the oscillators' amplitude and position, the
+/// filter cutoff and the mod matrix.
+/// filter_state holds the integrators of the left and right channels of the
+/// voice's filter.
+/// velocity is the note on velocity, and mod holds the voice's modulation of
+/// each destination for the block.
+/// lfo_phase is the phase of each LFO running per voice, set at note on
+/// by its sync mode.
 typedef struct
 {
     uint8_t note;
-    uint32_t phase;
-    uint32_t tune;
-    struct envelope_state_s amp_env_state[NUM_OSCILLATORS];
+    uint8_t velocity;
+    uint8_t pan;
+    uint32_t phase[NUM_OSCILLATORS];
+    int32_t pitch[NUM_OSCILLATORS];
+    uint32_t unison_phase[NUM_OSCILLATORS][WT_MAX_UNISON];
+    uint32_t morph_pos[NUM_OSCILLATORS];
+    struct envelope_state_s env_state[NUM_ENVELOPES];
+    struct filter_state_s filter_state[2];
+    int32_t mod[NUM_MOD_DSTS];
+    uint32_t lfo_phase[NUM_LFOS];
     uint64_t timestamp;
 } voice_t;
 
 extern voice_t voices[POLYPHONY_COUNT];
+extern voice_t voice_shadows[VOICE_NUM_SHADOWS];
+extern uint8_t voice_pan_spread;
+extern uint8_t voice_cull_db;
+extern uint32_t voice_cull_level;
+extern int32_t voice_pitch_bend;
 
 void voice_init(void);
+void voice_set_cull_db(uint8_t db);
+void voice_set_pitch_bend(uint16_t bend);
 
 voice_t * voice_find_next(void);
 voice_t * voice_find_for_note_off(uint8_t note);
 
-void voice_note_on(voice_t * voice, uint8_t note);
+void voice_note_on(voice_t * voice, uint8_t note, uint8_t velocity);
 void voice_note_off(voice_t * voice);
+void voice_retune(size_t wav_idx);
+bool voice_is_idle(voice_t const * voice);
 
 static inline voice_t * voice_get(size_t voice_idx)
 {
@@ -0,0 +1,339 @@
+#include "wav_import.h"
+
+#include "wavetable.h"
+
+#include <libdragon.h>
+#include <n64sys.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/// Main loop time budget per call to wav_import_step(). At least one frame is
+/// read per call regardless.
+#define WAV_IMPORT_BUDGET_TICKS (TICKS_PER_SECOND / 1000 * 2)
+
+#define WAV_FORMAT_PCM 0x0001
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE
+
+/// Size of a WAVE_FORMAT_EXTENSIBLE fmt chunk, whose SubFormat GUID names the
+/// real sample format.
+#define WAV_FMT_EXTENSIBLE_SIZE 40
+#define WAV_FMT_SUBFORMAT_OFFSET 24
+
+/// KSDATAFORMAT_SUBTYPE_PCM, as stored in the file.
+static uint8_t const wav_subtype_pcm[16] =
+{
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+    0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+};
+
+char wav_import_files[WAV_IMPORT_MAX_FILES][WAV_IMPORT_PATH_LEN];
+size_t wav_import_num_files = 0;
+
+static bool filesystem_ready = false;
+
+/// State of the import in progress. Frames are read straight into the table
+/// memory that will be published, one frame per read.
+static struct
+{
+    enum wav_import_status_e status;
+    FILE * file;
+    enum oscillator_shape_e slot;
+    short * frames;
+    uint16_t num_frames;
+    uint16_t frame_idx;
+    bool normalized;
+    uint64_t sum_squares;
+    char name[WT_NAME_LEN];
+} import_state =
+{
+    .status = WAV_IMPORT_IDLE,
+};
+
+static bool wav_find_data(FILE * file, uint32_t * data_size);
+static enum wav_import_status_e wav_import_fail(enum wav_import_status_e status);
+
+static inline uint16_t wav_le16(uint8_t const * bytes)
+{
+    return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+static inline uint32_t wav_le32(uint8_t const * bytes)
+{
+    return (uint32_t)bytes[0]
+           | ((uint32_t)bytes[1] << 8)
+           | ((uint32_t)bytes[2] << 16)
+           | ((uint32_t)bytes[3] << 24);
+}
+
+/// Mount the cartridge filesystem. Without one, the import screen simply
+/// lists no files.
+void wav_import_init(void)
+{
+    filesystem_ready = (DFS_ESUCCESS == dfs_init(DFS_DEFAULT_LOCATION));
+}
+
+/// Refresh the list of .wav files in WAV_IMPORT_DIR.
+/// Returns the number of files found.
+size_t wav_import_scan(void)
+{
+    wav_import_num_files = 0;
+
+    if (!filesystem_ready)
+    {
+        return 0;
+    }
+
+    dir_t dir;
+    int err = dir_findfirst(WAV_IMPORT_DIR, &dir);
+    while ((0 == err) && (wav_import_num_files < WAV_IMPORT_MAX_FILES))
+    {
+        size_t const len = strlen(dir.d_name);
+        if ((DT_REG == dir.d_type)
+            && (len > 4) && (len < WAV_IMPORT_PATH_LEN)
+            && (0 == strcasecmp(&dir.d_name[len - 4], ".wav")))
+        {
+            strcpy(wav_import_files[wav_import_num_files], dir.d_name);
+            ++wav_import_num_files;
+        }
+        err = dir_findnext(WAV_IMPORT_DIR, &dir);
+    }
+
+    return wav_import_num_files;
+}
+
+/// Start importing a wavetable into a user slot.
+/// The file must be 16 bit mono PCM made of whole WT_SIZE sample frames, as
+/// used by common wavetable packs. The header is parsed and table memory is
+/// allocated here; the sample data is streamed in by wav_import_step().
+enum wav_import_status_e wav_import_begin(char const * file_name,
+                                          enum oscillator_shape_e slot)
+{
+    if ((WAV_IMPORT_LOADING == import_state.status)
+        || (slot < NUM_GEN_TYPES) || (slot >= NUM_OSC_TYPES))
+    {
+        return import_state.status;
+    }
+
+    char path[sizeof(WAV_IMPORT_DIR) + WAV_IMPORT_PATH_LEN + 1];
+    snprintf(path, sizeof(path), "%s/%s", WAV_IMPORT_DIR, file_name);
+
+    import_state.file = fopen(path, "rb");
+    if (NULL == import_state.file)
+    {
+        return wav_import_fail(WAV_IMPORT_ERR_OPEN);
+    }
+
+    // Unbuffered, so each frame is read straight from the cartridge into the
+    // table without passing through a stdio buffer.
+    setvbuf(import_state.file, NULL, _IONBF, 0);
+
+    uint32_t data_size = 0;
+    if (!wav_find_data(import_state.file, &data_size))
+    {
+        return wav_import_fail(WAV_IMPORT_ERR_FORMAT);
+    }
+
+    uint32_t num_frames = data_size / (WT_SIZE * sizeof(int16_t));
+    if (0 == num_frames)
+    {
+        return wav_import_fail(WAV_IMPORT_ERR_FORMAT);
+    }
+    if (num_frames > WT_MAX_FRAMES)
+    {
+        num_frames = WT_MAX_FRAMES;
+    }
+
+    import_state.frames = malloc((size_t)num_frames * WT_FRAME_STRIDE * sizeof(short));
+    if (NULL == import_state.frames)
+    {
+        return wav_import_fail(WAV_IMPORT_ERR_MEMORY);
+    }
+
+    import_state.slot = slot;
+    import_state.num_frames = (uint16_t)num_frames;
+    import_state.frame_idx = 0;
+    import_state.normalized = false;
+    import_state.sum_squares = 0;
+
+    size_t name_len = strlen(file_name) - 4; // Drop the extension
+    if (name_len > (WT_NAME_LEN - 1))
+    {
+        name_len = WT_NAME_LEN - 1;
+    }
+    memcpy(import_state.name, file_name, name_len);
+    import_state.name[name_len] = '\0';
+
+    import_state.status = WAV_IMPORT_LOADING;
+    return import_state.status;
+}
+
+/// Import step, called once per main loop iteration.
+/// Reads frames into table memory for up to WAV_IMPORT_BUDGET_TICKS,
+/// converting from little endian in place and accumulating the sum of
+/// squares. Once every frame is in, the table is RMS normalized and published
+/// to its slot through the table manager.
+/// Returns true if the import progressed or finished.
+bool wav_import_step(void)
+{
+    if (WAV_IMPORT_LOADING != import_state.status)
+    {
+        return false;
+    }
+
+    uint32_t const start_ticks = TICKS_READ();
+
+    while (import_state.frame_idx < import_state.num_frames)
+    {
+        short * frame = &import_state.frames[import_state.frame_idx * WT_FRAME_STRIDE];
+
+        if (WT_SIZE != fread(frame, sizeof(short), WT_SIZE, import_state.file))
+        {
+            wav_import_fail(WAV_IMPORT_ERR_READ);
+            return true;
+        }
+
+        uint8_t const * bytes = (uint8_t const *)frame;
+        uint64_t sum_squares = 0;
+        for (size_t i = 0; i < WT_SIZE; ++i)
+        {
+            int16_t const sample = (int16_t)wav_le16(&bytes[i * 2]);
+            frame[i] = sample;
+            sum_squares += (uint32_t)((int32_t)sample * sample);
+        }
+        import_state.sum_squares += sum_squares;
+
+        ++import_state.frame_idx;
+
+        if (TICKS_DISTANCE(start_ticks, TICKS_READ()) >= WAV_IMPORT_BUDGET_TICKS)
+        {
+            return true;
+        }
+    }
+
+    if (NULL != import_state.file)
+    {
+        fclose(import_state.file);
+        import_state.file = NULL;
+    }
+
+    if (!import_state.normalized)
+    {
+        wavetable_normalize_frames(import_state.frames,
+                                   import_state.num_frames,
+                                   import_state.sum_squares);
+        import_state.normalized = true;
+    }
+
+    // If the slot's previous table is still being swapped out, try again on
+    // the next step.
+    if (wavetable_publish(import_state.slot, import_state.frames, import_state.num_frames))
+    {
+        wavetable_set_name(import_state.slot, import_state.name);
+        import_state.frames = NULL;
+        import_state.status = WAV_IMPORT_DONE;
+    }
+
+    return true;
+}
+
+enum wav_import_status_e wav_import_get_status(void)
+{
+    return import_state.status;
+}
+
+/// Return the number of frames read so far, and the total via num_frames.
+uint16_t wav_import_get_progress(uint16_t * num_frames)
+{
+    *num_frames = import_state.num_frames;
+    return import_state.frame_idx;
+}
+
+/// Walk the RIFF chunks, validating the format chunk, and leave the file
+/// positioned at the start of the sample data.
+/// Returns false if the file is not 16 bit mono PCM.
+static bool wav_find_data(FILE * file, uint32_t * data_size)
+{
+    uint8_t header[WAV_FMT_EXTENSIBLE_SIZE];
+
+    if ((1 != fread(header, 12, 1, file))
+        || (0 != memcmp(&header[0], "RIFF", 4))
+        || (0 != memcmp(&header[8], "WAVE", 4)))
+    {
+        return false;
+    }
+
+    bool format_ok = false;
+
+    while (1 == fread(header, 8, 1, file))
+    {
+        uint32_t const chunk_size = wav_le32(&header[4]);
+        uint32_t skip = chunk_size + (chunk_size & 1);
+
+        if (0 == memcmp(&header[0], "fmt ", 4))
+        {
+            if ((chunk_size < 16) || (1 != fread(header, 16, 1, file)))
+            {
+                return false;
+            }
+            skip -= 16;
+
+            uint16_t const format = wav_le16(&header[0]);
+            uint16_t const channels = wav_le16(&header[2]);
+            uint16_t const bits = wav_le16(&header[14]);
+
+            // An extensible header is only PCM if its SubFormat says so;
+            // float or compressed data must not be read as samples.
+            bool pcm = (WAV_FORMAT_PCM == format);
+            if (WAV_FORMAT_EXTENSIBLE == format)
+            {
+                uint32_t const ext_size = WAV_FMT_EXTENSIBLE_SIZE - 16;
+                if ((chunk_size < WAV_FMT_EXTENSIBLE_SIZE)
+                    || (1 != fread(&header[16], ext_size, 1, file)))
+                {
+                    return false;
+                }
+                skip -= ext_size;
+
+                pcm = (0 == memcmp(&header[WAV_FMT_SUBFORMAT_OFFSET], wav_subtype_pcm,
+                                   sizeof(wav_subtype_pcm)));
+            }
+
+            format_ok = pcm
+                        && (1 == channels)
+                        && (16 == bits);
+        }
+        else if (0 == memcmp(&header[0], "data", 4))
+        {
+            *data_size = chunk_size;
+            return format_ok;
+        }
+
+        if ((skip > 0) && (0 != fseek(file, skip, SEEK_CUR)))
+        {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+static enum wav_import_status_e wav_import_fail(enum wav_import_status_e status)
+{
+    if (NULL != import_state.file)
+    {
+        fclose(import_state.file);
+        import_state.file = NULL;
+    }
+
+    free(import_state.frames);
+    import_state.frames = NULL;
+
+    import_state.status = status;
+    return status;
+}
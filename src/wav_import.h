@@ -0,0 +1,40 @@
+#ifndef WAV_IMPORT_H
+#define WAV_IMPORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "wavetable.h"
+
+/// Directory scanned for importable wavetables, on the cartridge filesystem.
+/// Files are listed through libdragon's dir_* calls, so importing from a
+/// directory on disk in a host build is not supported.
+#define WAV_IMPORT_DIR "rom:/wavetables"
+
+#define WAV_IMPORT_MAX_FILES 12
+#define WAV_IMPORT_PATH_LEN 64
+
+enum wav_import_status_e
+{
+    WAV_IMPORT_IDLE,
+    WAV_IMPORT_LOADING,
+    WAV_IMPORT_DONE,
+    WAV_IMPORT_ERR_OPEN,
+    WAV_IMPORT_ERR_FORMAT,
+    WAV_IMPORT_ERR_MEMORY,
+    WAV_IMPORT_ERR_READ,
+};
+
+extern char wav_import_files[WAV_IMPORT_MAX_FILES][WAV_IMPORT_PATH_LEN];
+extern size_t wav_import_num_files;
+
+void wav_import_init(void);
+size_t wav_import_scan(void);
+enum wav_import_status_e wav_import_begin(char const * file_name,
+                                          enum oscillator_shape_e slot);
+bool wav_import_step(void);
+enum wav_import_status_e wav_import_get_status(void);
+uint16_t wav_import_get_progress(uint16_t * num_frames);
+
+#endif
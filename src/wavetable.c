@@ -2,7 +2,6 @@
 
 #include "audio_engine.h"
 #include "envelope.h"
-#include "gui.h"
 #include "init.h"
 
 #include <libdragon.h>
@@ -11,92 +10,406 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
-static void wavetable_generate_all(void);
 static void wavetable_generate_sine(float * sum_squares);
-static void wavetable_generate_square(float target_rms, size_t num_harmonics);
-static void wavetable_generate_triangle(float target_rms, size_t num_harmonics);
-static void wavetable_generate_ramp(float target_rms, size_t num_harmonics);
+static float wavetable_square_sample(size_t idx, size_t num_harmonics);
+static float wavetable_triangle_sample(size_t idx, size_t num_harmonics);
+static float wavetable_ramp_sample(size_t idx, size_t num_harmonics);
 
 static void wavetable_normalize(short * lut,
                                 float target_rms,
                                 float sum_squares);
 
-static inline short wavetable_interpolate(int16_t const y0,
-                                          int16_t const y1,
-                                          uint32_t const frac);
+static void wavetable_generate_pan_lut(void);
 
-static void wavetable_generate_midi_freq_tbl(void);
-
-// TODO: Support direct (not wavetable) synthesis
-// static short triangle_component(uint32_t const phase);
-// static short square_component(uint32_t const phase);
-// static short ramp_component(uint32_t const phase);
-
-static float midi_freq_lut[MIDI_MAX_DATA_BYTE + 1];
-
-/// Arrays for oscillator lookup tables. One additional sample is added to the
-/// end to simplify interpolation step, as we won't need to check for wrapping.
-static short sine_tbl[WT_SIZE + 1];
-static short square_tbl[WT_SIZE + 1];
-static short triangle_tbl[WT_SIZE + 1];
-static short ramp_tbl[WT_SIZE + 1];
+/// Double buffers for each oscillator lookup table. The audio callback reads
+/// the front buffer through osc_wave_tables while the table manager builds
+/// into the other. One additional sample is added to the end to simplify
+/// interpolation step, as we won't need to check for wrapping.
+static short table_bufs[NUM_GEN_TYPES][2][WT_SIZE + 1];
 
 /// Temporary array used in generating lookup tables. Type is floating-point
 /// for greater accuracy pre-RMS normalization. Additional sample not needed.
 static float temp_tbl[WT_SIZE];
 
-/// Array of pointers to osillaor lookup tables.
+/// Unscaled sine cycle. Harmonic h of sample i is sine_f_tbl[(i * h) % WT_SIZE],
+/// so the additive tables are built without calling sinf per partial.
+static float sine_f_tbl[WT_SIZE];
+
+/// Array of pointers to osillaor lookup tables (the front buffers).
+/// Every shape points at the sine table until its own table is generated, so
+/// audio can start before the additive tables exist. User tables are NULL
+/// until imported. Only the audio callback writes these, in
+/// wavetable_swap_commit().
 short * osc_wave_tables[NUM_OSC_TYPES] =
 {
-    sine_tbl,
-    square_tbl,
-    triangle_tbl,
-    ramp_tbl
+    table_bufs[SINE][0],
+    table_bufs[SINE][0],
+    table_bufs[SINE][0],
+    table_bufs[SINE][0],
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+/// Number of frames in each front table.
+uint16_t osc_wave_frames[NUM_OSC_TYPES] = {1, 1, 1, 1, 0, 0, 0, 0};
+
+/// Display names of imported user tables.
+static char user_names[WT_NUM_USER_TABLES][WT_NAME_LEN] = {{0}};
+
+struct wavetable_swap_s wavetable_swaps[NUM_OSC_TYPES] = {0};
+volatile bool wavetable_swap_pending = false;
+
+/// Main loop time budget per call to wavetable_generate_step().
+#define WT_GEN_BUDGET_TICKS (TICKS_PER_SECOND / 1000 * 2)
+#define WT_DEFAULT_HARMONICS 120
+
+#define WT_ADDITIVE_MASK ((1 << SQUARE) | (1 << TRIANGLE) | (1 << RAMP))
+
+/// Boot stage each table's first build is accounted to.
+static enum init_state_e const gen_stages[NUM_GEN_TYPES] =
+{
+    GEN_SINE,
+    GEN_SQUARE,
+    GEN_TRIANGLE,
+    GEN_RAMP
+};
+
+/// State of the table manager's builder.
+static struct
+{
+    uint8_t queued;     // Bitmask of shapes waiting to be (re)built
+    uint8_t boot;       // Bitmask of shapes not yet built since boot
+    enum oscillator_shape_e shape; // Shape being built, or NONE
+    size_t sample_idx;
+    float sum_squares;
+} gen_state =
+{
+    .queued = WT_ADDITIVE_MASK,
+    .boot = WT_ADDITIVE_MASK,
+    .shape = NONE,
 };
 
+static size_t num_harmonics = WT_DEFAULT_HARMONICS;
+
+/// RMS of the sine table, which all other tables are normalized to.
+static float target_rms = 0.0f;
+
+/// Output gain of each direct oscillator in Q15, matching its RMS to the
+/// tables. Square has an RMS of full scale, triangle and ramp 1/sqrt(3).
+int16_t wavetable_direct_gain[NUM_GEN_TYPES] = {0};
+
+/// Unison sub-oscillator layout of each oscillator.
+struct wavetable_unison_s wavetable_unison[NUM_OSCILLATORS];
+
+/// Right channel gain of each pan position in Q15, sqrt(2) * sin(theta) for
+/// theta across [0,pi/2]. The left gain reads the table backwards.
+uint16_t wavetable_pan_lut[WT_PAN_LUT_SIZE];
+
+/// exp2 tables of the pitch converter in Q31: 2^(s/12) for each semitone s
+/// of an octave, and 2^(f/12) at each step f of a semitone. pitch_base is
+/// the phase increment of MIDI note 0 with WT_PITCH_BASE_FRAC_BITS of
+/// fraction.
+uint32_t wavetable_semitone_lut[12];
+uint32_t wavetable_pitch_frac_lut[WT_PITCH_LUT_SIZE];
+uint32_t wavetable_pitch_base;
+
 /// Storage location for oscillators/voice components.
 wavetable_t oscillators[NUM_OSCILLATORS];
 
 
 /// Initialize wavetable components.
-/// Generates all wavetables and the midi to frequency lookup table.
+/// Generates the sine table and the midi to frequency lookup table, which is
+/// all audio needs to start. The remaining tables are queued for the table
+/// manager, which builds them from the main loop.
 /// Initializes a single sine wave voice.
 void wavetable_init(void)
 {
-    wavetable_generate_all();
-    wavetable_generate_midi_freq_tbl();
+    float sum_squares = 0;
+
+    init_stage_begin(GEN_SINE);
+    wavetable_generate_sine(&sum_squares);
+    target_rms = 0.5f * sqrtf(sum_squares/WT_SIZE);
+
+    wavetable_direct_gain[SQUARE] = (int16_t)(target_rms * INT16_MAX);
+    wavetable_direct_gain[TRIANGLE] = (int16_t)(target_rms * sqrtf(3.0f) * INT16_MAX);
+    wavetable_direct_gain[RAMP] = (int16_t)(target_rms * sqrtf(3.0f) * INT16_MAX);
+
+    init_stage_begin(GEN_FREQ_TBL);
+    wavetable_generate_pitch_luts(SAMPLE_RATE);
+    wavetable_generate_pan_lut();
 
     oscillators[0].shape = SINE;
     oscillators[0].gain = 127;
     oscillators[0].amp_env_idx = 0;
+    oscillators[0].position = 0;
+    oscillators[0].pos_env_amt = 0;
+    oscillators[0].interp = WT_INTERP_LINEAR;
+    oscillators[0].direct = false;
+    oscillators[0].coarse = 0;
+    oscillators[0].fine = 0;
+    oscillators[0].phase_offset = 0;
 
     oscillators[1].shape = NONE;
     oscillators[1].gain = 0;
     oscillators[1].amp_env_idx = 0;
+    oscillators[1].position = 0;
+    oscillators[1].pos_env_amt = 0;
+    oscillators[1].interp = WT_INTERP_LINEAR;
+    oscillators[1].direct = false;
+    oscillators[1].coarse = 0;
+    oscillators[1].fine = 0;
+    oscillators[1].phase_offset = 0;
+
+    for (size_t osc_idx = 0; osc_idx < NUM_OSCILLATORS; ++osc_idx)
+    {
+        oscillators[osc_idx].unison = 1;
+        oscillators[osc_idx].unison_detune = 32;
+        oscillators[osc_idx].unison_spread = 64;
+        oscillators[osc_idx].pan = WT_PAN_CENTER;
+        wavetable_update_unison(osc_idx);
+    }
 }
 
-/// Genarates all oscillator lookup tables and RMS normalizes them to the same
-/// level of perceived loudness.
-static void wavetable_generate_all(void)
+/// Set the number of harmonics in the band-limited additive tables and queue
+/// them for a rebuild. A build already in progress restarts, since its back
+/// buffer is not yet visible to the audio callback.
+void wavetable_set_num_harmonics(size_t harmonics)
 {
-    float sum_squares = 0;
+    num_harmonics = harmonics;
+    gen_state.queued |= WT_ADDITIVE_MASK;
 
-    gui_splash(GEN_SINE);
-    wavetable_generate_sine(&sum_squares);
-    float target_rms = 0.5f * sqrtf(sum_squares/WT_SIZE);
+    if ((NONE != gen_state.shape) && ((1 << gen_state.shape) & WT_ADDITIVE_MASK))
+    {
+        gen_state.sample_idx = 0;
+        gen_state.sum_squares = 0;
+    }
+}
+
+size_t wavetable_get_num_harmonics(void)
+{
+    return num_harmonics;
+}
+
+/// Return true while any table is queued, being built, or waiting for the
+/// audio callback to pick it up.
+bool wavetable_is_building(void)
+{
+    return (0 != gen_state.queued) || (NONE != gen_state.shape) || wavetable_swap_pending;
+}
+
+/// Table manager step, called once per main loop iteration.
+///
+/// Reclaims back buffers the audio callback has acknowledged swapping out,
+/// then spends at most WT_GEN_BUDGET_TICKS building the next queued table
+/// into its back buffer. A finished table is RMS normalized and handed to the
+/// audio callback, which swaps it in at the start of its next block. A shape
+/// is only rebuilt once its previous swap has been acknowledged and reclaimed,
+/// so the buffer being written is never one the callback can read.
+/// Returns true if the audio callback swapped in a table since the last call.
+bool wavetable_generate_step(void)
+{
+    bool swapped = false;
+
+    for (size_t shape = 0; shape < NUM_OSC_TYPES; ++shape)
+    {
+        short * retired = wavetable_swaps[shape].retired;
+        if (NULL != retired)
+        {
+            // Generated shapes retire into their static back buffer. User
+            // tables were allocated by the importer and are freed here.
+            if (shape >= NUM_GEN_TYPES)
+            {
+                free(retired);
+            }
+            wavetable_swaps[shape].retired = NULL;
+            swapped = true;
+        }
+    }
+
+    if (NONE == gen_state.shape)
+    {
+        for (size_t shape = 0; shape < NUM_GEN_TYPES; ++shape)
+        {
+            if (((1 << shape) & gen_state.queued)
+                && (NULL == wavetable_swaps[shape].pending)
+                && (NULL == wavetable_swaps[shape].retired))
+            {
+                gen_state.queued &= ~(1 << shape);
+                gen_state.shape = shape;
+                gen_state.sample_idx = 0;
+                gen_state.sum_squares = 0;
+                break;
+            }
+        }
+
+        if (NONE == gen_state.shape)
+        {
+            return swapped;
+        }
+    }
+
+    uint32_t const start_ticks = TICKS_READ();
+    enum oscillator_shape_e const shape = gen_state.shape;
+
+    do
+    {
+        size_t const idx = gen_state.sample_idx;
+        switch (shape)
+        {
+            case SQUARE:
+                temp_tbl[idx] = wavetable_square_sample(idx, num_harmonics);
+                break;
+            case TRIANGLE:
+                temp_tbl[idx] = wavetable_triangle_sample(idx, num_harmonics);
+                break;
+            case RAMP:
+                temp_tbl[idx] = wavetable_ramp_sample(idx, num_harmonics);
+                break;
+            case SINE:
+            default:
+                temp_tbl[idx] = sine_f_tbl[idx];
+                break;
+        }
+        gen_state.sum_squares += temp_tbl[idx] * temp_tbl[idx];
+        ++gen_state.sample_idx;
+    } while ((gen_state.sample_idx < WT_SIZE)
+             && (TICKS_DISTANCE(start_ticks, TICKS_READ()) < WT_GEN_BUDGET_TICKS));
+
+    if (WT_SIZE == gen_state.sample_idx)
+    {
+        short * back = (osc_wave_tables[shape] == table_bufs[shape][0])
+                       ? table_bufs[shape][1]
+                       : table_bufs[shape][0];
+
+        wavetable_normalize(back, target_rms, gen_state.sum_squares);
+        wavetable_publish(shape, back, 1);
+
+        gen_state.shape = NONE;
+    }
+
+    if ((1 << shape) & gen_state.boot)
+    {
+        init_stage_add_ticks(gen_stages[shape],
+                             TICKS_DISTANCE(start_ticks, TICKS_READ()));
+
+        if (NONE == gen_state.shape)
+        {
+            gen_state.boot &= ~(1 << shape);
+            if (0 == gen_state.boot)
+            {
+                init_lazy_done();
+            }
+        }
+    }
+
+    return swapped;
+}
+
+/// Return true if a new table for the given shape can be published, i.e. the
+/// previous swap has been acknowledged and its buffer reclaimed.
+bool wavetable_can_publish(enum oscillator_shape_e shape)
+{
+    return (NULL == wavetable_swaps[shape].pending)
+           && (NULL == wavetable_swaps[shape].retired);
+}
+
+/// Hand a finished table to the audio callback, which swaps it in at the start
+/// of its next block. The frames must not be written after this call; for
+/// user shapes they are freed once swapped out again.
+/// Returns false if the previous swap for this shape is still outstanding.
+bool wavetable_publish(enum oscillator_shape_e shape, short * frames, uint16_t num_frames)
+{
+    if (!wavetable_can_publish(shape))
+    {
+        return false;
+    }
+
+    wavetable_swaps[shape].pending_frames = num_frames;
+
+    // Table contents must be complete before the swap is requested.
+    MEMORY_BARRIER();
+    wavetable_swaps[shape].pending = frames;
+    MEMORY_BARRIER();
+    wavetable_swap_pending = true;
 
-    size_t const num_harmonics = 120;
+    return true;
+}
+
+/// RMS normalize 16 bit frames in place to the same target as the generated
+/// tables, using one scale for the whole table so the level changes between
+/// frames are preserved. Also writes each frame's guard sample.
+void wavetable_normalize_frames(short * frames, uint16_t num_frames, uint64_t sum_squares)
+{
+    float const rms = sqrtf((float)sum_squares / ((size_t)num_frames * WT_SIZE)) / INT16_MAX;
+    float const scale = (rms > 0.0f) ? (target_rms / rms) : 1.0f;
+
+    for (size_t frame_idx = 0; frame_idx < num_frames; ++frame_idx)
+    {
+        short * frame = &frames[frame_idx * WT_FRAME_STRIDE];
 
-    gui_splash(GEN_SQUARE);
-    wavetable_generate_square(target_rms, num_harmonics);
+        for (size_t i = 0; i < WT_SIZE; ++i)
+        {
+            float const sample = frame[i] * scale;
+
+            if (sample > INT16_MAX)
+                frame[i] = INT16_MAX;
+            else if (sample < INT16_MIN)
+                frame[i] = INT16_MIN;
+            else
+                frame[i] = (short)sample;
+        }
 
-    gui_splash(GEN_TRIANGLE);
-    wavetable_generate_triangle(target_rms, num_harmonics);
+        frame[WT_SIZE] = frame[0];
+    }
+}
 
-    gui_splash(GEN_RAMP);
-    wavetable_generate_ramp(target_rms, num_harmonics);
+void wavetable_set_name(enum oscillator_shape_e shape, char const * name)
+{
+    if (shape >= NUM_GEN_TYPES && shape < NUM_OSC_TYPES)
+    {
+        strncpy(user_names[shape - NUM_GEN_TYPES], name, WT_NAME_LEN - 1);
+        user_names[shape - NUM_GEN_TYPES][WT_NAME_LEN - 1] = '\0';
+    }
+}
+
+/// Return the display name of an imported user table, or an empty string.
+char const * wavetable_get_name(enum oscillator_shape_e shape)
+{
+    if (shape >= NUM_GEN_TYPES && shape < NUM_OSC_TYPES)
+    {
+        return user_names[shape - NUM_GEN_TYPES];
+    }
+    return "";
+}
+
+/// Return the next selectable oscillator shape after the given one, skipping
+/// empty user slots and wrapping through NONE.
+enum oscillator_shape_e wavetable_next_shape(enum oscillator_shape_e shape)
+{
+    do
+    {
+        shape = (NONE == shape) ? SINE : (shape + 1);
+    } while ((NONE != shape) && (NULL == osc_wave_tables[shape]));
+
+    return shape;
+}
+
+/// Return the previous selectable oscillator shape before the given one,
+/// skipping empty user slots and wrapping through NONE.
+enum oscillator_shape_e wavetable_prev_shape(enum oscillator_shape_e shape)
+{
+    do
+    {
+        shape = (SINE == shape) ? NONE : (shape - 1);
+    } while ((NONE != shape) && (NULL == osc_wave_tables[shape]));
+
+    return shape;
 }
 
 /// Generate a sine wave lookup table.
@@ -112,76 +425,51 @@ static void wavetable_generate_sine(float * sum_squares)
         float temp = sinf((float)i * phase_step);
         (*sum_squares) += temp * temp;
 
-        sine_tbl[i] = (short)(INT16_MAX/2 * temp);
+        sine_f_tbl[i] = temp;
+
+        table_bufs[SINE][0][i] = (short)(INT16_MAX/2 * temp);
     }
 
-    sine_tbl[WT_SIZE] = sine_tbl[0];
+    table_bufs[SINE][0][WT_SIZE] = table_bufs[SINE][0][0];
 }
 
-/// Generates a band-limited square wave lookup table.
+/// Generates one sample of a band-limited square wave.
 /// Formula: Sum of odd harmonics (h) with amplitudes scaled by 1/h.
-static void wavetable_generate_square(float target_rms, size_t num_harmonics)
+static float wavetable_square_sample(size_t idx, size_t num_harmonics)
 {
-    float const phase_step = (2.0f * M_PI) / WT_SIZE;
-
-    float sum_squares = 0;
-
-    for (size_t i = 0; i < WT_SIZE; ++i)
+    float sample = 0;
+    for (size_t h = 1; h <= num_harmonics; h+=2)
     {
-        temp_tbl[i] = 0;
-        for (size_t h = 1; h <= num_harmonics; h+=2)
-        {
-            temp_tbl[i] += sinf((float)i * phase_step * h) / h;
-        }
-        sum_squares += temp_tbl[i] * temp_tbl[i];
+        sample += sine_f_tbl[(idx * h) & (WT_SIZE - 1)] / h;
     }
-
-    wavetable_normalize(square_tbl, target_rms, sum_squares);
+    return sample;
 }
 
-/// Generates a band-limited triangle wave lookup table.
+/// Generates one sample of a band-limited triangle wave.
 /// Formula: Sum of odd harmonics (h) with amplitudes scaled by 1/h^2 
 /// and alternating phase (sign flip).
-static void wavetable_generate_triangle(float target_rms, size_t num_harmonics)
+static float wavetable_triangle_sample(size_t idx, size_t num_harmonics)
 {
-    float const phase_step = (2.0f * M_PI) / WT_SIZE;
-
-    float sum_squares = 0;
-
-    for (size_t i = 0; i < WT_SIZE; ++i)
+    float sample = 0;
+    float sign = 1.0f;
+    for (size_t h = 1; h <= num_harmonics; h+=2)
     {
-        temp_tbl[i] = 0;
-        float sign = 1.0f;
-        for (size_t h = 1; h <= num_harmonics; h+=2)
-        {
-            temp_tbl[i] += (sign * sinf((float)i * phase_step * h) / (float)(h * h));
-            sign *= -1.0f;
-        }
-        sum_squares += temp_tbl[i] * temp_tbl[i];
+        sample += (sign * sine_f_tbl[(idx * h) & (WT_SIZE - 1)] / (float)(h * h));
+        sign *= -1.0f;
     }
-
-    wavetable_normalize(triangle_tbl, target_rms, sum_squares);
+    return sample;
 }
 
-/// Generates a band-limited ramp (sawtooth) wave lookup table.
+/// Generates one sample of a band-limited ramp (sawtooth) wave.
 /// Formula: Sum of all harmonics (h) with amplitudes scaled by 1/h.
-static void wavetable_generate_ramp(float target_rms, size_t num_harmonics)
+static float wavetable_ramp_sample(size_t idx, size_t num_harmonics)
 {
-    float const phase_step = (2.0f * M_PI) / WT_SIZE;
-
-    float sum_squares = 0;
-
-    for (size_t i = 0; i < WT_SIZE; ++i)
+    float sample = 0;
+    for (size_t h = 1; h <= num_harmonics; ++h)
     {
-        temp_tbl[i] = 0;
-        for (size_t h = 1; h <= num_harmonics; ++h)
-        {
-            temp_tbl[i] += sinf((float)i * phase_step * h) / (float)h;
-        }
-        sum_squares += temp_tbl[i] * temp_tbl[i];
+        sample += sine_f_tbl[(idx * h) & (WT_SIZE - 1)] / (float)h;
     }
-
-    wavetable_normalize(ramp_tbl, target_rms, sum_squares);
+    return sample;
 }
 
 /// Adjusts a given lookup table to match a target RMS, given the sum of
@@ -191,8 +479,6 @@ static void wavetable_normalize(short * lut, float target_rms, float sum_squares
     float const rms = sqrtf(sum_squares / WT_SIZE);
     float const scale = target_rms / rms;
 
-    printf("Target: %f, RMS: %f, scale: %f\n", target_rms, rms, scale);
-
     for (size_t i = 0; i < WT_SIZE; ++i)
     {
         lut[i] = (short)(INT16_MAX * temp_tbl[i] * scale);
@@ -203,62 +489,82 @@ static void wavetable_normalize(short * lut, float target_rms, float sum_squares
 
 
 /// Get the tune or stride value for the given note.
-/// This looks up the note frequency from midi_freq_lut and calculates the
-/// step rate through the accumulator. The phase accumulator should increment
-/// by this value between each sample.
-/// One pass through every 32 bit value represents one complete cycle. The step
-/// rate is calculated by multiplying the frequency by the total number of
-/// accumulator values (UINT32_MAX + 1), and dividing by the sample rate.
+/// The phase accumulator should increment by this value between each sample.
+/// One pass through every 32 bit value represents one complete cycle, so the
+/// step rate is the note frequency times the total number of accumulator
+/// values (UINT32_MAX + 1), divided by the sample rate.
 uint32_t wavetable_get_midi_tune(uint8_t const note)
 {
-    return wavetable_get_freq_tune(midi_freq_lut[note]);
+    return wavetable_get_pitch_tune((int32_t)note << WT_PITCH_FRAC_BITS);
 }
 
-uint32_t wavetable_get_freq_tune(float freq_hz)
+/// Return the pitch of an oscillator playing the given note, offset by its
+/// coarse and fine tuning.
+int32_t wavetable_get_osc_pitch(uint8_t const note, wavetable_t const * osc)
 {
-    return (uint32_t)((freq_hz * ((uint64_t)1 << ACCUMULATOR_BITS)) / SAMPLE_RATE);
+    return (((int32_t)note + osc->coarse) << WT_PITCH_FRAC_BITS)
+           + (((int32_t)osc->fine * WT_PITCH_SEMITONE) / 100);
 }
 
-
-short wavetable_triangle_component(uint32_t const phase)
+/// Lay out the unison sub-oscillators of an oscillator after its unison
+/// settings change. Sub-oscillators are spaced evenly from the lowest to the
+/// highest detune, and from one side of the stereo field to the other, so
+/// the outer pair is both the most detuned and the widest.
+void wavetable_update_unison(size_t osc_idx)
 {
-    uint32_t phase_temp = phase + 0x40000000;
-    phase_temp >>= 15;
-    if (phase_temp & 0x10000)
-    {
-        phase_temp = 0x1FFFF - phase_temp;
-    }
-    return (short)(phase_temp - 0x8000);
-}
+    wavetable_t const * osc = &oscillators[osc_idx];
+    struct wavetable_unison_s layout;
+    struct wavetable_unison_s * unison = &layout;
 
-short wavetable_square_component(uint32_t const phase)
-{
-    if (phase & 0x80000000)
-    {
-        return INT16_MIN;
-    }
-    else
+    unison->count = osc->unison;
+
+    float const norm = 1.0f / sqrtf((float)osc->unison);
+    float const detune_cents = ((float)osc->unison_detune * WT_UNISON_DETUNE_MAX_CENTS)
+                               / MIDI_MAX_DATA_BYTE;
+    float const spread = (float)osc->unison_spread / MIDI_MAX_DATA_BYTE;
+
+    for (size_t sub_idx = 0; sub_idx < WT_MAX_UNISON; ++sub_idx)
     {
-        return INT16_MAX;
+        // Offset in [-1,1] from the centre of the unison.
+        float offset = 0.0f;
+        if (osc->unison > 1)
+        {
+            offset = ((2.0f * sub_idx) / (osc->unison - 1)) - 1.0f;
+        }
+
+        unison->detune_pitch[sub_idx] = (int32_t)lroundf((offset * detune_cents * WT_PITCH_SEMITONE)
+                                                         / 100.0f);
+
+        int32_t gain_l;
+        int32_t gain_r;
+        uint8_t const pan = (uint8_t)lroundf(WT_PAN_CENTER * (1.0f + (offset * spread)));
+        wavetable_pan_gains(pan, &gain_l, &gain_r);
+
+        unison->gain_l[sub_idx] = (uint16_t)(gain_l * norm);
+        unison->gain_r[sub_idx] = (uint16_t)(gain_r * norm);
     }
+
+    // Publish the whole layout at once, so a block never renders a mix of
+    // old and new sub-oscillators.
+    disable_interrupts();
+    wavetable_unison[osc_idx] = layout;
+    enable_interrupts();
 }
 
-short wavetable_ramp_component(uint32_t const phase)
+/// Return the phase increment of a frequency. Uses float, so is for rates
+/// set from the main loop, such as the LFOs'; pitches go through
+/// wavetable_get_pitch_tune().
+uint32_t wavetable_get_freq_tune(float freq_hz)
 {
-    return (short)((phase) >> 16);
+    return (uint32_t)((freq_hz * ((uint64_t)1 << ACCUMULATOR_BITS)) / SAMPLE_RATE);
 }
 
-/// Generate MIDI note to frequency lookup table.
-/// Produces an array midi_freq_lut of type float, where the index is the MIDI
-/// note number [0,127] and the value is the frequency in Hz.
-///
-/// The table is based off Middle A (440 Hz) being note 69. Each octave up or
-/// down doubles or halves the frequency. Thus, the equation for each note's
-/// frequency is given by 440 * 2^((note_idx - 69)/12)
-static void wavetable_generate_midi_freq_tbl(void)
+/// Generate the constant-power pan LUT.
+static void wavetable_generate_pan_lut(void)
 {
-    for (int note_idx = 0; note_idx <= MIDI_MAX_DATA_BYTE; ++note_idx)
+    for (size_t idx = 0; idx < WT_PAN_LUT_SIZE; ++idx)
     {
-        midi_freq_lut[note_idx] = 440.0f * powf(2.0f, ((float)note_idx - 69) / 12.0f);
+        float const theta = ((float)idx * (float)M_PI_2) / (WT_PAN_LUT_SIZE - 1);
+        wavetable_pan_lut[idx] = (uint16_t)lroundf(sinf(theta) * (float)M_SQRT2 * 32768.0f);
     }
 }
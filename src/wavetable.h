@@ -6,73 +6,166 @@
 #include <stdint.h>
 
 #include "envelope.h"
+#include "wavetable_kernels.h"
+#include "wavetable_pitch.h"
 
 #define NUM_OSCILLATORS 2
-#define WT_BIT_DEPTH 11 // 2048 table entries
-#define WT_SIZE (1 << WT_BIT_DEPTH)
-#define ACCUMULATOR_BITS 32
-#define FRAC_BITS (ACCUMULATOR_BITS - WT_BIT_DEPTH)
-
-/// Enum representing the oscillator waveforms.
-enum oscillator_shape_e {
-    SINE,
-    SQUARE,
-    TRIANGLE,
-    RAMP,
-    NUM_OSC_TYPES,
-
-    NONE = NUM_OSC_TYPES
-};
+#define WT_MAX_FRAMES 256
+#define WT_NAME_LEN 9
+
+/// Wavetable position is a Q16 fraction of the table's frame range.
+#define WT_POSITION_BITS 16
+#define WT_POSITION_ONE (1 << WT_POSITION_BITS)
+
+/// Oscillator tuning ranges. coarse is in semitones and fine in cents.
+#define WT_COARSE_MAX 24
+#define WT_FINE_MAX 50
+
+/// Shift from an oscillator phase offset in [0,MIDI_MAX_DATA_BYTE] to the
+/// phase accumulator, so the full range covers one cycle.
+#define WT_PHASE_OFFSET_SHIFT 25
+
+/// Most sub-oscillators an oscillator can spawn in unison, and the detune in
+/// cents of the outermost pair at full unison_detune.
+#define WT_MAX_UNISON 8
+#define WT_UNISON_DETUNE_MAX_CENTS 50
+
+/// Pan positions run over [0,MIDI_MAX_DATA_BYTE] with WT_PAN_CENTER in the
+/// middle. The pan LUT has one more entry than there are positions, so the
+/// centre falls exactly on an entry and the top position is hard right.
+#define WT_PAN_CENTER 64
+#define WT_PAN_LUT_SIZE (2 * WT_PAN_CENTER + 1)
 
 /// Struct representing a waveform or voice component.
 /// Includes an oscillator type, amp envelope, and mix amount.
+/// Position scans through the frames of a multi-frame table between
+/// [0,MIDI_MAX_DATA_BYTE], and is offset by the amp envelope scaled by
+/// pos_env_amt in [-MIDI_MAX_DATA_BYTE,MIDI_MAX_DATA_BYTE].
+/// interp selects the lookup kernel. direct renders square, triangle and
+/// ramp with band-limited direct oscillators instead of their tables.
+/// coarse and fine offset the pitch from the note in semitones and cents,
+/// and phase_offset shifts the waveform by a fraction of a cycle.
+/// unison in [1,WT_MAX_UNISON] is the number of sub-oscillators, spread in
+/// pitch by unison_detune and across the stereo field by unison_spread, both
+/// in [0,MIDI_MAX_DATA_BYTE]. pan places the oscillator in the stereo field.
 typedef struct {
     enum oscillator_shape_e shape;
     uint8_t amp_env_idx;
     uint8_t gain;
+    uint8_t position;
+    int8_t pos_env_amt;
+    enum wavetable_interp_e interp;
+    bool direct;
+    int8_t coarse;
+    int8_t fine;
+    uint8_t phase_offset;
+    uint8_t unison;
+    uint8_t unison_detune;
+    uint8_t unison_spread;
+    uint8_t pan;
 } wavetable_t;
 
+/// Unison sub-oscillator layout of an oscillator, derived from its unison
+/// settings by wavetable_update_unison().
+/// count is the number of sub-oscillators the layout was built for; the audio
+/// callback reads it rather than the oscillator's unison setting, so the two
+/// never disagree. detune_pitch offsets the pitch of each sub-oscillator, and
+/// gain_l and gain_r are Q15 constant-power pan gains, normalized so the
+/// unison sums to the level of a single oscillator.
+struct wavetable_unison_s
+{
+    uint8_t count;
+    int32_t detune_pitch[WT_MAX_UNISON];
+    uint16_t gain_l[WT_MAX_UNISON];
+    uint16_t gain_r[WT_MAX_UNISON];
+};
+
+/// Swap handshake between the table manager and the audio callback.
+/// pending: set by the main loop to a finished back buffer, taken by the
+///          audio callback at the start of its next block.
+/// retired: set by the audio callback to the buffer it stopped reading, which
+///          acknowledges the swap. Cleared by the main loop once reclaimed.
+/// pending_frames is the frame count of the pending table, written before
+///          pending and applied together with it.
+struct wavetable_swap_s
+{
+    short * volatile pending;
+    short * volatile retired;
+    uint16_t pending_frames;
+};
+
 extern wavetable_t oscillators[NUM_OSCILLATORS];
 extern short * osc_wave_tables[NUM_OSC_TYPES];
+extern uint16_t osc_wave_frames[NUM_OSC_TYPES];
+extern struct wavetable_swap_s wavetable_swaps[NUM_OSC_TYPES];
+extern volatile bool wavetable_swap_pending;
+extern int16_t wavetable_direct_gain[NUM_GEN_TYPES];
+extern struct wavetable_unison_s wavetable_unison[NUM_OSCILLATORS];
+extern uint16_t wavetable_pan_lut[WT_PAN_LUT_SIZE];
 
 void wavetable_init(void);
+bool wavetable_generate_step(void);
+void wavetable_set_num_harmonics(size_t harmonics);
+size_t wavetable_get_num_harmonics(void);
+bool wavetable_is_building(void);
+
+bool wavetable_can_publish(enum oscillator_shape_e shape);
+bool wavetable_publish(enum oscillator_shape_e shape, short * frames, uint16_t num_frames);
+void wavetable_normalize_frames(short * frames, uint16_t num_frames, uint64_t sum_squares);
+
+void wavetable_set_name(enum oscillator_shape_e shape, char const * name);
+char const * wavetable_get_name(enum oscillator_shape_e shape);
+enum oscillator_shape_e wavetable_next_shape(enum oscillator_shape_e shape);
+enum oscillator_shape_e wavetable_prev_shape(enum oscillator_shape_e shape);
 
 uint32_t wavetable_get_midi_tune(uint8_t const note);
+int32_t wavetable_get_osc_pitch(uint8_t const note, wavetable_t const * osc);
+void wavetable_update_unison(size_t osc_idx);
 uint32_t wavetable_get_freq_tune(float freq_hz);
 
-short wavetable_triangle_component(uint32_t const phase);
-short wavetable_square_component(uint32_t const phase);
-short wavetable_ramp_component(uint32_t const phase);
-
-/// Return a pointer to the given wavetable type.
-static inline short * wavetable_get(enum oscillator_shape_e osc)
+/// Return the left and right gains of a pan position, in Q15.
+/// The pan law is constant power, scaled so that both gains are unity at the
+/// centre and a centred source keeps the level of the mono mix.
+static inline void wavetable_pan_gains(uint8_t pan, int32_t * gain_l, int32_t * gain_r)
 {
-    return osc_wave_tables[osc];
+    size_t const idx = (MIDI_MAX_DATA_BYTE == pan) ? (WT_PAN_LUT_SIZE - 1) : pan;
+    *gain_l = wavetable_pan_lut[WT_PAN_LUT_SIZE - 1 - idx];
+    *gain_r = wavetable_pan_lut[idx];
 }
 
-/// Perform linear interpolation based on two samples and the fractional
-/// element of the phase accumulator.
-static inline short wavetable_interpolate(int16_t const y0,
-                                          int16_t const y1,
-                                          uint32_t const frac)
+/// Swap in any tables the table manager has finished building. Called by the
+/// audio callback at the start of each block, so a table never changes
+/// part way through a block.
+static inline void wavetable_swap_commit(void)
 {
-
-    return (short) (((int64_t)((int32_t)(y1 - y0) * (int32_t)frac)) >> FRAC_BITS);
+    if (wavetable_swap_pending)
+    {
+        for (size_t shape = 0; shape < NUM_OSC_TYPES; ++shape)
+        {
+            short * pending = wavetable_swaps[shape].pending;
+            if (NULL != pending)
+            {
+                wavetable_swaps[shape].retired = osc_wave_tables[shape];
+                osc_wave_tables[shape] = pending;
+                osc_wave_frames[shape] = wavetable_swaps[shape].pending_frames;
+                wavetable_swaps[shape].pending = NULL;
+            }
+        }
+        wavetable_swap_pending = false;
+    }
 }
 
-/// Return the amplitude of a wave at a given phase.
-/// Extracts the integer and fractional elements of the phase accumulator. The
-/// integer is used to lookup the exact sample and the following sample from
-/// the table, and the fraction is used to interpolate beween them.
-static inline short wavetable_get_amplitude(uint32_t const component_phase, short * wave_table)
+/// Return a pointer to the first frame of the given wavetable type, or NULL
+/// if a user table has not been loaded.
+static inline short * wavetable_get(enum oscillator_shape_e osc)
 {
-    uint16_t const phase_int = (uint16_t const)((component_phase) >> FRAC_BITS);
-    uint32_t const phase_frac = (uint32_t const)(component_phase & ((1 << FRAC_BITS) - 1));
-
-    short const y0 = wave_table[phase_int];
-    short const y1 = wave_table[phase_int + 1];
+    return osc_wave_tables[osc];
+}
 
-    return y0 + wavetable_interpolate(y0, y1, phase_frac);
+/// Return the number of frames in the given wavetable type.
+static inline uint16_t wavetable_get_num_frames(enum oscillator_shape_e osc)
+{
+    return osc_wave_frames[osc];
 }
 
 #endif
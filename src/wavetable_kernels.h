@@ -0,0 +1,323 @@
+#ifndef WAVETABLE_KERNELS_H
+#define WAVETABLE_KERNELS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// The table lookup kernels and direct oscillators, kept free of libdragon
+/// so the host benchmark in tools/kernel_bench.c runs the same code.
+
+#define WT_BIT_DEPTH 11 // 2048 table entries
+#define WT_SIZE (1 << WT_BIT_DEPTH)
+#define ACCUMULATOR_BITS 32
+#define FRAC_BITS (ACCUMULATOR_BITS - WT_BIT_DEPTH)
+
+/// Multi-frame tables store each WT_SIZE frame followed by a guard sample for
+/// interpolation, padded so every frame starts 8-byte aligned for PI DMA.
+#define WT_FRAME_STRIDE (WT_SIZE + 4)
+
+/// Fraction bits used when interpolating between two frames.
+#define WT_MORPH_FRAC_BITS 14
+
+/// Enum representing the oscillator waveforms.
+/// Generated shapes are built by the table manager. User shapes are empty
+/// until a wavetable is imported into them.
+enum oscillator_shape_e {
+    SINE,
+    SQUARE,
+    TRIANGLE,
+    RAMP,
+    NUM_GEN_TYPES,
+
+    USER_1 = NUM_GEN_TYPES,
+    USER_2,
+    USER_3,
+    USER_4,
+    NUM_OSC_TYPES,
+
+    NONE = NUM_OSC_TYPES
+};
+
+#define WT_NUM_USER_TABLES (NUM_OSC_TYPES - NUM_GEN_TYPES)
+
+/// Enum representing how table lookups interpolate between samples.
+enum wavetable_interp_e {
+    WT_INTERP_NONE,
+    WT_INTERP_LINEAR,
+    WT_INTERP_CUBIC,
+    NUM_WT_INTERP
+};
+
+/// Fraction bits of the phase used by the interpolating kernels. Keeps the
+/// products of sample differences and fractions within 32 bits.
+#define WT_INTERP_FRAC_BITS 15
+
+/// Return a pointer to a frame of a multi-frame table.
+static inline short * wavetable_get_frame(short * wave_table, uint16_t frame_idx)
+{
+    return &wave_table[(size_t)frame_idx * WT_FRAME_STRIDE];
+}
+
+/// Perform linear interpolation based on two samples and the fractional
+/// element of the phase accumulator.
+/// The fraction is reduced to WT_INTERP_FRAC_BITS first, so a full scale step
+/// between samples cannot overflow the 32 bit product.
+static inline short wavetable_interpolate(int16_t const y0,
+                                          int16_t const y1,
+                                          uint32_t const frac)
+{
+    int32_t const frac_q = (int32_t)(frac >> (FRAC_BITS - WT_INTERP_FRAC_BITS));
+
+    return (short)(((int32_t)(y1 - y0) * frac_q) >> WT_INTERP_FRAC_BITS);
+}
+
+/// Return the amplitude of a wave at a given phase without interpolation.
+/// The cheapest kernel: the fraction of the phase accumulator is dropped.
+static inline short wavetable_get_amplitude_trunc(uint32_t const component_phase, short * wave_table)
+{
+    return wave_table[component_phase >> FRAC_BITS];
+}
+
+/// Return the amplitude of a wave at a given phase.
+/// Extracts the integer and fractional elements of the phase accumulator. The
+/// integer is used to lookup the exact sample and the following sample from
+/// the table, and the fraction is used to interpolate beween them.
+static inline short wavetable_get_amplitude(uint32_t const component_phase, short * wave_table)
+{
+    uint16_t const phase_int = (uint16_t const)((component_phase) >> FRAC_BITS);
+    uint32_t const phase_frac = (uint32_t const)(component_phase & ((1 << FRAC_BITS) - 1));
+
+    short const y0 = wave_table[phase_int];
+    short const y1 = wave_table[phase_int + 1];
+
+    return y0 + wavetable_interpolate(y0, y1, phase_frac);
+}
+
+/// Return the amplitude of a wave at a given phase using 4-point cubic Hermite
+/// (Catmull-Rom) interpolation.
+/// The outer neighbours wrap within the table, so frames need no guard
+/// samples beyond the one used by linear interpolation. The coefficients are
+/// kept at twice their value to stay in integers, and the result is clamped
+/// as the curve can overshoot the samples.
+static inline short wavetable_get_amplitude_cubic(uint32_t const component_phase, short * wave_table)
+{
+    uint32_t const phase_int = component_phase >> FRAC_BITS;
+    int32_t const t = (int32_t)((component_phase >> (FRAC_BITS - WT_INTERP_FRAC_BITS))
+                                & ((1 << WT_INTERP_FRAC_BITS) - 1));
+
+    int32_t const ym1 = wave_table[(phase_int - 1) & (WT_SIZE - 1)];
+    int32_t const y0 = wave_table[phase_int];
+    int32_t const y1 = wave_table[phase_int + 1];
+    int32_t const y2 = wave_table[(phase_int + 2) & (WT_SIZE - 1)];
+
+    int32_t const c1 = y1 - ym1;
+    int32_t const c2 = (2 * ym1) - (5 * y0) + (4 * y1) - y2;
+    int32_t const c3 = (3 * (y0 - y1)) + y2 - ym1;
+
+    int32_t acc = (int32_t)(((int64_t)c3 * t) >> WT_INTERP_FRAC_BITS) + c2;
+    acc = (int32_t)(((int64_t)acc * t) >> WT_INTERP_FRAC_BITS) + c1;
+    int32_t const y = y0 + (int32_t)(((int64_t)acc * t) >> (WT_INTERP_FRAC_BITS + 1));
+
+    if (y > INT16_MAX)
+        return INT16_MAX;
+    else if (y < INT16_MIN)
+        return INT16_MIN;
+    return (short)y;
+}
+
+/// Return the amplitude of a wave at a given phase with the given kernel.
+/// Forced inline so that callers passing a constant interp get the kernel
+/// itself, with no dispatch in their sample loop.
+__attribute__((always_inline))
+static inline short wavetable_lookup(uint32_t const component_phase, short * wave_table,
+                                     enum wavetable_interp_e const interp)
+{
+    switch (interp)
+    {
+        case WT_INTERP_NONE:
+            return wavetable_get_amplitude_trunc(component_phase, wave_table);
+        case WT_INTERP_CUBIC:
+            return wavetable_get_amplitude_cubic(component_phase, wave_table);
+        case WT_INTERP_LINEAR:
+        default:
+            return wavetable_get_amplitude(component_phase, wave_table);
+    }
+}
+
+/// Return the amplitude of a multi-frame wave at a given phase and position.
+/// Each frame is looked up in phase with the given kernel, then the two
+/// results are interpolated by frame_frac, in WT_MORPH_FRAC_BITS, between
+/// [0,1].
+__attribute__((always_inline))
+static inline short wavetable_get_morph_amplitude(uint32_t const component_phase,
+                                                  short * frame_0,
+                                                  short * frame_1,
+                                                  int32_t const frame_frac,
+                                                  enum wavetable_interp_e const interp)
+{
+    short const y0 = wavetable_lookup(component_phase, frame_0, interp);
+    short const y1 = wavetable_lookup(component_phase, frame_1, interp);
+
+    return y0 + (short)(((int32_t)(y1 - y0) * frame_frac) >> WT_MORPH_FRAC_BITS);
+}
+
+/// Naive triangle at full scale: zero at phase zero, peaking a quarter of the
+/// way through the cycle. Aliases at audio rates.
+static inline short wavetable_triangle_component(uint32_t const phase)
+{
+    uint32_t phase_temp = phase + 0x40000000;
+    phase_temp >>= 15;
+    if (phase_temp & 0x10000)
+    {
+        phase_temp = 0x1FFFF - phase_temp;
+    }
+    return (short)(phase_temp - 0x8000);
+}
+
+/// Naive square at full scale, high for the first half cycle.
+static inline short wavetable_square_component(uint32_t const phase)
+{
+    if (phase & 0x80000000)
+    {
+        return INT16_MIN;
+    }
+    else
+    {
+        return INT16_MAX;
+    }
+}
+
+/// Naive ramp at full scale, resetting half way through the cycle.
+static inline short wavetable_ramp_component(uint32_t const phase)
+{
+    return (short)((phase) >> 16);
+}
+
+/// Return true if the shape has a direct oscillator.
+static inline bool wavetable_has_direct(enum oscillator_shape_e shape)
+{
+    return (SQUARE == shape) || (TRIANGLE == shape) || (RAMP == shape);
+}
+
+/// Return the reciprocal of a phase increment for the direct oscillators,
+/// scaled so that ((uint64_t)t * inv_dt) >> 32 is t / dt in Q15.
+/// Computed once per block, so the sample loop never divides.
+static inline uint32_t wavetable_direct_inv_dt(uint32_t const dt)
+{
+    if (dt <= (1u << 15))
+    {
+        return UINT32_MAX;
+    }
+    return (uint32_t)(((uint64_t)1 << 47) / dt);
+}
+
+/// Return 1 - (distance / dt) in Q15 for a phase within one sample of a
+/// discontinuity, or 0 outside of that window.
+/// The sign is negative after the discontinuity (t < dt) and positive before
+/// it (t > 1 - dt), which is the side the residuals are applied on.
+static inline int32_t wavetable_direct_window(uint32_t const t,
+                                              uint32_t const dt,
+                                              uint32_t const inv_dt)
+{
+    if (t < dt)
+    {
+        return -((1 << 15) - (int32_t)(((uint64_t)t * inv_dt) >> 32));
+    }
+    else if (t > (0u - dt))
+    {
+        return (1 << 15) - (int32_t)(((uint64_t)(0u - t) * inv_dt) >> 32);
+    }
+    return 0;
+}
+
+/// PolyBLEP residual, in Q15, of a unit step at phase zero.
+static inline int32_t wavetable_poly_blep(uint32_t const t, uint32_t const dt, uint32_t const inv_dt)
+{
+    int32_t const w = wavetable_direct_window(t, dt, inv_dt);
+    int32_t const w_sq = (w * w) >> 15;
+    return (w < 0) ? -w_sq : w_sq;
+}
+
+/// PolyBLAMP residual, in Q15, of a unit change in slope per sample at phase
+/// zero. Always positive; the caller applies the sign of the corner.
+static inline int32_t wavetable_poly_blamp(uint32_t const t, uint32_t const dt, uint32_t const inv_dt)
+{
+    int32_t w = wavetable_direct_window(t, dt, inv_dt);
+    if (w < 0)
+    {
+        w = -w;
+    }
+    // w^3 / 3, dividing by multiplying with 1/3 in Q15
+    return (((((w * w) >> 15) * w) >> 15) * 10923) >> 15;
+}
+
+/// Band-limited square wave at full scale, in phase with
+/// wavetable_square_component(): high for the first half cycle.
+static inline short wavetable_direct_square(uint32_t const phase, uint32_t const dt, uint32_t const inv_dt)
+{
+    int32_t y = (phase & 0x80000000) ? INT16_MIN : INT16_MAX;
+    y += wavetable_poly_blep(phase, dt, inv_dt);
+    y -= wavetable_poly_blep(phase + 0x80000000, dt, inv_dt);
+
+    if (y > INT16_MAX)
+        return INT16_MAX;
+    else if (y < INT16_MIN)
+        return INT16_MIN;
+    return (short)y;
+}
+
+/// Band-limited ramp at full scale, in phase with wavetable_ramp_component():
+/// the reset falls half way through the cycle.
+static inline short wavetable_direct_ramp(uint32_t const phase, uint32_t const dt, uint32_t const inv_dt)
+{
+    int32_t y = (short)(phase >> 16);
+    y -= wavetable_poly_blep(phase + 0x80000000, dt, inv_dt);
+
+    if (y > INT16_MAX)
+        return INT16_MAX;
+    else if (y < INT16_MIN)
+        return INT16_MIN;
+    return (short)y;
+}
+
+/// Band-limited triangle at full scale, in phase with
+/// wavetable_triangle_component(): peaks a quarter of the way through the
+/// cycle and bottoms out at three quarters. The slope is four full scales per
+/// cycle, (dt >> 15) per sample, and reverses at each corner; the residual
+/// for a change of twice the slope is blamp times the slope.
+static inline short wavetable_direct_triangle(uint32_t const phase, uint32_t const dt, uint32_t const inv_dt)
+{
+    int32_t const slope = (int32_t)(dt >> 15);
+
+    int32_t y = wavetable_triangle_component(phase);
+    y -= (slope * wavetable_poly_blamp(phase - 0x40000000, dt, inv_dt)) >> 15;
+    y += (slope * wavetable_poly_blamp(phase - 0xC0000000, dt, inv_dt)) >> 15;
+
+    if (y > INT16_MAX)
+        return INT16_MAX;
+    else if (y < INT16_MIN)
+        return INT16_MIN;
+    return (short)y;
+}
+
+/// Return the amplitude of a direct oscillator at full scale.
+/// Forced inline so that callers passing a constant shape get the oscillator
+/// itself, with no dispatch in their sample loop.
+__attribute__((always_inline))
+static inline short wavetable_direct(uint32_t const phase, uint32_t const dt, uint32_t const inv_dt,
+                                     enum oscillator_shape_e const shape)
+{
+    switch (shape)
+    {
+        case SQUARE:
+            return wavetable_direct_square(phase, dt, inv_dt);
+        case TRIANGLE:
+            return wavetable_direct_triangle(phase, dt, inv_dt);
+        case RAMP:
+        default:
+            return wavetable_direct_ramp(phase, dt, inv_dt);
+    }
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef WAVETABLE_PITCH_H
+#define WAVETABLE_PITCH_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// The pitch to phase increment converter, kept free of libdragon so the host
+/// check in tools/pitch_check.c runs the same code.
+
+/// Pitches are semitones above MIDI note 0 with WT_PITCH_FRAC_BITS of
+/// fraction, so a note, cents, bend and modulation simply add. Pitches are
+/// clamped to WT_PITCH_MAX, just short of Nyquist.
+#define WT_PITCH_FRAC_BITS 16
+#define WT_PITCH_SEMITONE (1 << WT_PITCH_FRAC_BITS)
+#define WT_PITCH_MAX (135 * WT_PITCH_SEMITONE)
+
+/// Steps per semitone of the fractional exp2 table, and the fractional bits
+/// of the phase increment of note 0 the converter scales.
+#define WT_PITCH_LUT_BITS 4
+#define WT_PITCH_LUT_SIZE ((1 << WT_PITCH_LUT_BITS) + 1)
+#define WT_PITCH_BASE_FRAC_BITS 12
+
+extern uint32_t wavetable_semitone_lut[12];
+extern uint32_t wavetable_pitch_frac_lut[WT_PITCH_LUT_SIZE];
+extern uint32_t wavetable_pitch_base;
+
+/// Generate the exp2 tables of the pitch converter.
+///
+/// The tuning is based off Middle A (440 Hz) being note 69. Each octave up or
+/// down doubles or halves the frequency, so each note's frequency is given by
+/// 440 * 2^((note_idx - 69)/12), and note 0 is the base every pitch scales.
+/// Built in double precision, as the tables carry 31 bits.
+static inline void wavetable_generate_pitch_luts(uint32_t sample_rate)
+{
+    for (size_t semitone = 0; semitone < 12; ++semitone)
+    {
+        wavetable_semitone_lut[semitone] = (uint32_t)llround(exp2((double)semitone / 12.0)
+                                                             * 2147483648.0);
+    }
+
+    for (size_t step = 0; step < WT_PITCH_LUT_SIZE; ++step)
+    {
+        double const semitones = (double)step / (1 << WT_PITCH_LUT_BITS);
+        wavetable_pitch_frac_lut[step] = (uint32_t)llround(exp2(semitones / 12.0)
+                                                           * 2147483648.0);
+    }
+
+    double const note_0_hz = 440.0 * exp2(-69.0 / 12.0);
+    wavetable_pitch_base = (uint32_t)llround((note_0_hz * 4294967296.0 / sample_rate)
+                                             * (1 << WT_PITCH_BASE_FRAC_BITS));
+}
+
+/// Return the phase increment of a pitch, in integer arithmetic so the audio
+/// callback can apply modulation and bend every control block.
+/// The pitch splits into an octave, a semitone within it and a fraction of
+/// a semitone. The semitone and the interpolated fraction are exp2 tables
+/// in Q31 whose product is the mantissa, which scales the increment of
+/// note 0 and is shifted up by the octave. Within 0.005 cent over the whole
+/// range, against a 0.1 cent limit checked by make pitch-check.
+static inline uint32_t wavetable_get_pitch_tune(int32_t pitch)
+{
+    if (pitch < 0)
+        pitch = 0;
+    else if (pitch > WT_PITCH_MAX)
+        pitch = WT_PITCH_MAX;
+
+    uint32_t const semitone = (uint32_t)pitch >> WT_PITCH_FRAC_BITS;
+    uint32_t const octave = semitone / 12;
+    uint32_t const frac = (uint32_t)pitch & (WT_PITCH_SEMITONE - 1);
+    uint32_t const step = frac >> (WT_PITCH_FRAC_BITS - WT_PITCH_LUT_BITS);
+    uint32_t const step_frac = frac & ((1 << (WT_PITCH_FRAC_BITS - WT_PITCH_LUT_BITS)) - 1);
+
+    uint32_t const fine_0 = wavetable_pitch_frac_lut[step];
+    uint32_t const fine_1 = wavetable_pitch_frac_lut[step + 1];
+    uint32_t const fine = fine_0 + (uint32_t)(((uint64_t)(fine_1 - fine_0) * step_frac)
+                                              >> (WT_PITCH_FRAC_BITS - WT_PITCH_LUT_BITS));
+
+    uint64_t const mantissa = ((uint64_t)wavetable_semitone_lut[semitone - (octave * 12)] * fine)
+                              >> 31;
+
+    return (uint32_t)((mantissa * wavetable_pitch_base)
+                      >> (31 + WT_PITCH_BASE_FRAC_BITS - octave));
+}
+
+#endif
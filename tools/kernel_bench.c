@@ -0,0 +1,365 @@
+// Host benchmark of the oscillator kernels. Build and run with
+// make kernel-bench.
+//
+// Renders the table lookup kernels, the two-frame morph and the PolyBLEP
+// direct oscillators over a range of pitches, and reports the cost of each
+// in host cycles per sample and its THD+N against the ideal band-limited
+// waveform.
+
+#include "wavetable_kernels.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/// Samples per measurement. The fundamentals sit on DFT bins, so the
+/// spectrum needs no window. The length is prime, so the phase visits every
+/// fraction between table samples and no alias of a harmonic lands on
+/// another harmonic.
+#define BENCH_SIZE 4093
+#define BENCH_ITERATIONS 400
+
+/// Mirrors of SAMPLE_RATE in audio_engine.h and WT_DEFAULT_HARMONICS in
+/// wavetable.c, which do not build on the host.
+#define BENCH_SAMPLE_RATE 44100
+#define BENCH_HARMONICS 120
+
+/// Dependent adds timed to convert host time to cycles, at one a cycle.
+#define BENCH_CALIBRATE_ADDS 200000000
+
+/// Fundamentals as DFT bins: about 54 Hz, 441 Hz, 1.8 kHz and 7 kHz.
+static uint32_t const bench_bins[] = { 5, 41, 163, 653 };
+#define BENCH_NUM_PITCHES (sizeof(bench_bins) / sizeof(bench_bins[0]))
+
+enum bench_kernel_e {
+    BENCH_TABLE,
+    BENCH_MORPH,
+    BENCH_DIRECT
+};
+
+struct bench_row_s
+{
+    char const * name;
+    enum bench_kernel_e kernel;
+    enum oscillator_shape_e shape;
+    enum wavetable_interp_e interp;
+};
+
+static struct bench_row_s const bench_rows[] = {
+    { "sine    trunc",     BENCH_TABLE,  SINE,     WT_INTERP_NONE },
+    { "sine    linear",    BENCH_TABLE,  SINE,     WT_INTERP_LINEAR },
+    { "sine    cubic",     BENCH_TABLE,  SINE,     WT_INTERP_CUBIC },
+    { "sine    morph lin", BENCH_MORPH,  SINE,     WT_INTERP_LINEAR },
+    { "sine    morph cub", BENCH_MORPH,  SINE,     WT_INTERP_CUBIC },
+    { "square  trunc",     BENCH_TABLE,  SQUARE,   WT_INTERP_NONE },
+    { "square  linear",    BENCH_TABLE,  SQUARE,   WT_INTERP_LINEAR },
+    { "square  cubic",     BENCH_TABLE,  SQUARE,   WT_INTERP_CUBIC },
+    { "square  polyblep",  BENCH_DIRECT, SQUARE,   WT_INTERP_NONE },
+    { "tri     trunc",     BENCH_TABLE,  TRIANGLE, WT_INTERP_NONE },
+    { "tri     linear",    BENCH_TABLE,  TRIANGLE, WT_INTERP_LINEAR },
+    { "tri     cubic",     BENCH_TABLE,  TRIANGLE, WT_INTERP_CUBIC },
+    { "tri     polyblamp", BENCH_DIRECT, TRIANGLE, WT_INTERP_NONE },
+    { "ramp    trunc",     BENCH_TABLE,  RAMP,     WT_INTERP_NONE },
+    { "ramp    linear",    BENCH_TABLE,  RAMP,     WT_INTERP_LINEAR },
+    { "ramp    cubic",     BENCH_TABLE,  RAMP,     WT_INTERP_CUBIC },
+    { "ramp    polyblep",  BENCH_DIRECT, RAMP,     WT_INTERP_NONE },
+};
+#define BENCH_NUM_ROWS (sizeof(bench_rows) / sizeof(bench_rows[0]))
+
+/// Return the index of a shape's linear table row.
+static size_t bench_linear_row(enum oscillator_shape_e shape)
+{
+    for (size_t row_idx = 0; row_idx < BENCH_NUM_ROWS; ++row_idx)
+    {
+        if ((BENCH_TABLE == bench_rows[row_idx].kernel) && (shape == bench_rows[row_idx].shape)
+            && (WT_INTERP_LINEAR == bench_rows[row_idx].interp))
+        {
+            return row_idx;
+        }
+    }
+    return 0;
+}
+
+static short tables[NUM_GEN_TYPES][WT_FRAME_STRIDE];
+static short morph_frames[NUM_GEN_TYPES][WT_FRAME_STRIDE];
+static short output[BENCH_SIZE];
+
+static double bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1e9) + ts.tv_nsec;
+}
+
+/// Return host cycles per nanosecond, from a chain of dependent adds.
+static double bench_cycles_per_ns(void)
+{
+    uint32_t acc = 0;
+    double const start_ns = bench_now_ns();
+    for (uint32_t idx = 0; idx < BENCH_CALIBRATE_ADDS; ++idx)
+    {
+        __asm__ volatile ("" : "+r" (acc));
+        acc += idx;
+    }
+    double const elapsed_ns = bench_now_ns() - start_ns;
+    __asm__ volatile ("" : : "r" (acc));
+
+    return BENCH_CALIBRATE_ADDS / elapsed_ns;
+}
+
+/// Build the tables as the table manager does: the sine at half scale, and
+/// the additive shapes normalized to its RMS.
+static void bench_generate_tables(void)
+{
+    double const target_rms = 0.5 * M_SQRT1_2;
+
+    for (size_t shape = 0; shape < NUM_GEN_TYPES; ++shape)
+    {
+        static double temp[WT_SIZE];
+        double sum_squares = 0.0;
+
+        for (size_t idx = 0; idx < WT_SIZE; ++idx)
+        {
+            double const x = (2.0 * M_PI * idx) / WT_SIZE;
+            double sample = 0.0;
+
+            switch (shape)
+            {
+                case SINE:
+                    sample = sin(x);
+                    break;
+                case SQUARE:
+                    for (size_t h = 1; h <= BENCH_HARMONICS; h += 2)
+                        sample += sin(x * h) / h;
+                    break;
+                case TRIANGLE:
+                    for (size_t h = 1; h <= BENCH_HARMONICS; h += 2)
+                        sample += ((h & 2) ? -1.0 : 1.0) * sin(x * h) / (double)(h * h);
+                    break;
+                case RAMP:
+                default:
+                    for (size_t h = 1; h <= BENCH_HARMONICS; ++h)
+                        sample += sin(x * h) / h;
+                    break;
+            }
+
+            temp[idx] = sample;
+            sum_squares += sample * sample;
+        }
+
+        double const scale = target_rms / sqrt(sum_squares / WT_SIZE);
+        for (size_t idx = 0; idx < WT_SIZE; ++idx)
+        {
+            tables[shape][idx] = (short)(INT16_MAX * temp[idx] * scale);
+        }
+        tables[shape][WT_SIZE] = tables[shape][0];
+        memcpy(morph_frames[shape], tables[shape], sizeof(tables[shape]));
+    }
+}
+
+/// Render a block the way the audio engine does, with the kernel resolved
+/// outside of the sample loop.
+__attribute__((noinline))
+static void bench_render_table(short * table, uint32_t phase_inc, enum wavetable_interp_e interp)
+{
+    uint32_t phase = 0;
+
+    switch (interp)
+    {
+        case WT_INTERP_NONE:
+            for (size_t idx = 0; idx < BENCH_SIZE; ++idx, phase += phase_inc)
+                output[idx] = wavetable_lookup(phase, table, WT_INTERP_NONE);
+            break;
+        case WT_INTERP_CUBIC:
+            for (size_t idx = 0; idx < BENCH_SIZE; ++idx, phase += phase_inc)
+                output[idx] = wavetable_lookup(phase, table, WT_INTERP_CUBIC);
+            break;
+        case WT_INTERP_LINEAR:
+        default:
+            for (size_t idx = 0; idx < BENCH_SIZE; ++idx, phase += phase_inc)
+                output[idx] = wavetable_lookup(phase, table, WT_INTERP_LINEAR);
+            break;
+    }
+}
+
+/// Render a block of a two-frame morph. Both frames hold copies of the same
+/// table, so the output is the table's and the THD+N compares with the plain
+/// kernel, while the two lookups still read separate memory.
+__attribute__((noinline))
+static void bench_render_morph(short * frame_0, short * frame_1, uint32_t phase_inc,
+                               enum wavetable_interp_e interp)
+{
+    int32_t const frame_frac = 1 << (WT_MORPH_FRAC_BITS - 1);
+    uint32_t phase = 0;
+
+    switch (interp)
+    {
+        case WT_INTERP_NONE:
+            for (size_t idx = 0; idx < BENCH_SIZE; ++idx, phase += phase_inc)
+                output[idx] = wavetable_get_morph_amplitude(phase, frame_0, frame_1, frame_frac,
+                                                            WT_INTERP_NONE);
+            break;
+        case WT_INTERP_CUBIC:
+            for (size_t idx = 0; idx < BENCH_SIZE; ++idx, phase += phase_inc)
+                output[idx] = wavetable_get_morph_amplitude(phase, frame_0, frame_1, frame_frac,
+                                                            WT_INTERP_CUBIC);
+            break;
+        case WT_INTERP_LINEAR:
+        default:
+            for (size_t idx = 0; idx < BENCH_SIZE; ++idx, phase += phase_inc)
+                output[idx] = wavetable_get_morph_amplitude(phase, frame_0, frame_1, frame_frac,
+                                                            WT_INTERP_LINEAR);
+            break;
+    }
+}
+
+__attribute__((noinline))
+static void bench_render_direct(enum oscillator_shape_e shape, uint32_t phase_inc)
+{
+    uint32_t const inv_dt = wavetable_direct_inv_dt(phase_inc);
+    uint32_t phase = 0;
+
+    switch (shape)
+    {
+        case SQUARE:
+            for (size_t idx = 0; idx < BENCH_SIZE; ++idx, phase += phase_inc)
+                output[idx] = wavetable_direct(phase, phase_inc, inv_dt, SQUARE);
+            break;
+        case TRIANGLE:
+            for (size_t idx = 0; idx < BENCH_SIZE; ++idx, phase += phase_inc)
+                output[idx] = wavetable_direct(phase, phase_inc, inv_dt, TRIANGLE);
+            break;
+        case RAMP:
+        default:
+            for (size_t idx = 0; idx < BENCH_SIZE; ++idx, phase += phase_inc)
+                output[idx] = wavetable_direct(phase, phase_inc, inv_dt, RAMP);
+            break;
+    }
+}
+
+static void bench_render(struct bench_row_s const * row, uint32_t phase_inc)
+{
+    switch (row->kernel)
+    {
+        case BENCH_MORPH:
+            bench_render_morph(tables[row->shape], morph_frames[row->shape], phase_inc,
+                               row->interp);
+            break;
+        case BENCH_DIRECT:
+            bench_render_direct(row->shape, phase_inc);
+            break;
+        case BENCH_TABLE:
+        default:
+            bench_render_table(tables[row->shape], phase_inc, row->interp);
+            break;
+    }
+}
+
+/// Return the power of one DFT bin of the output, by Goertzel.
+static double bench_bin_power(uint32_t bin)
+{
+    double const coeff = 2.0 * cos((2.0 * M_PI * bin) / BENCH_SIZE);
+    double s1 = 0.0;
+    double s2 = 0.0;
+
+    for (size_t idx = 0; idx < BENCH_SIZE; ++idx)
+    {
+        double const s0 = output[idx] + (coeff * s1) - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    return (s1 * s1) + (s2 * s2) - (coeff * s1 * s2);
+}
+
+/// Return the THD+N of the output in dB. The signal is the fundamental of a
+/// sine, and every harmonic below Nyquist of the other shapes, so for those
+/// the figure is their aliasing and interpolation noise. DC is left out.
+static double bench_thdn_db(uint32_t bin, bool harmonics)
+{
+    double total = 0.0;
+    for (size_t idx = 0; idx < BENCH_SIZE; ++idx)
+    {
+        total += (double)output[idx] * output[idx];
+    }
+    // Parseval: the bins sum to BENCH_SIZE times the sample power, and each
+    // bin below Nyquist has a mirror above it.
+    total = (total * BENCH_SIZE) - bench_bin_power(0);
+
+    double signal = 0.0;
+    for (uint32_t harmonic = bin; harmonic < (BENCH_SIZE / 2); harmonic += bin)
+    {
+        signal += 2.0 * bench_bin_power(harmonic);
+        if (!harmonics)
+        {
+            break;
+        }
+    }
+
+    double const noise = total - signal;
+    return 10.0 * log10(((noise > 0.0) ? noise : 1e-30) / signal);
+}
+
+int main(void)
+{
+    bench_generate_tables();
+    double const cycles_per_ns = bench_cycles_per_ns();
+
+    printf("host clock ~%.2f GHz, %u samples per block\n", cycles_per_ns, BENCH_SIZE);
+    printf("%-18s  %10s", "kernel", "cyc/sample");
+    for (size_t pitch = 0; pitch < BENCH_NUM_PITCHES; ++pitch)
+    {
+        printf("  %6.0f Hz", ((double)bench_bins[pitch] * BENCH_SAMPLE_RATE) / BENCH_SIZE);
+    }
+    printf("\n");
+
+    double thdn[BENCH_NUM_ROWS][BENCH_NUM_PITCHES];
+
+    for (size_t row_idx = 0; row_idx < BENCH_NUM_ROWS; ++row_idx)
+    {
+        struct bench_row_s const * row = &bench_rows[row_idx];
+        double elapsed_ns = 0.0;
+
+        for (size_t pitch = 0; pitch < BENCH_NUM_PITCHES; ++pitch)
+        {
+            uint32_t const phase_inc
+                = (uint32_t)llround((bench_bins[pitch] * 4294967296.0) / BENCH_SIZE);
+
+            bench_render(row, phase_inc);
+            thdn[row_idx][pitch] = bench_thdn_db(bench_bins[pitch], SINE != row->shape);
+
+            double const start_ns = bench_now_ns();
+            for (size_t iter = 0; iter < BENCH_ITERATIONS; ++iter)
+            {
+                bench_render(row, phase_inc);
+            }
+            elapsed_ns += bench_now_ns() - start_ns;
+        }
+
+        double const samples = (double)BENCH_SIZE * BENCH_ITERATIONS * BENCH_NUM_PITCHES;
+        printf("%-18s  %10.2f", row->name, (elapsed_ns * cycles_per_ns) / samples);
+        for (size_t pitch = 0; pitch < BENCH_NUM_PITCHES; ++pitch)
+        {
+            printf("  %6.1f dB", thdn[row_idx][pitch]);
+        }
+        printf("\n");
+    }
+
+    // The direct oscillators exist to alias less than the tables at high
+    // pitches.
+    int failed = 0;
+    size_t const top = BENCH_NUM_PITCHES - 1;
+    for (size_t row_idx = 0; row_idx < BENCH_NUM_ROWS; ++row_idx)
+    {
+        struct bench_row_s const * row = &bench_rows[row_idx];
+        if ((BENCH_DIRECT == row->kernel)
+            && (thdn[row_idx][top] >= thdn[bench_linear_row(row->shape)][top]))
+        {
+            printf("FAIL: %s aliases more than its table at the top pitch\n", row->name);
+            failed = 1;
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,95 @@
+// Host check of the integer pitch converter. Build and run with
+// make pitch-check.
+//
+// Sweeps every MIDI note with pitch bend and pitch modulation applied, and
+// compares wavetable_get_pitch_tune() against the float note to phase
+// increment conversion it replaced.
+
+#include "wavetable_pitch.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/// Mirrors of SAMPLE_RATE in audio_engine.h, VOICE_BEND_RANGE in voice.h and
+/// MOD_PITCH_RANGE and MOD_VALUE_BITS in mod_matrix.h, which do not build on
+/// the host.
+#define CHECK_SAMPLE_RATE 44100
+#define CHECK_BEND_RANGE 2
+#define CHECK_MOD_PITCH_RANGE 12
+#define CHECK_MOD_VALUE_BITS 15
+
+/// Largest error allowed, in cents.
+#define CHECK_MAX_ERROR_CENTS 0.1
+
+uint32_t wavetable_semitone_lut[12];
+uint32_t wavetable_pitch_frac_lut[WT_PITCH_LUT_SIZE];
+uint32_t wavetable_pitch_base;
+
+/// The float conversion: the note's frequency from Middle A, then the phase
+/// increment as wavetable_get_freq_tune() computes it.
+static double check_float_tune(int32_t pitch)
+{
+    float const note = (float)pitch / WT_PITCH_SEMITONE;
+    float const freq_hz = 440.0f * powf(2.0f, (note - 69.0f) / 12.0f);
+
+    return (freq_hz * 4294967296.0f) / CHECK_SAMPLE_RATE;
+}
+
+int main(void)
+{
+    wavetable_generate_pitch_luts(CHECK_SAMPLE_RATE);
+
+    static uint16_t const bends[] = { 0, 1, 4096, 8191, 8192, 8193, 12288, 16383 };
+    size_t const num_bends = sizeof(bends) / sizeof(bends[0]);
+
+    double worst_cents = 0.0;
+    int32_t worst_pitch = 0;
+    uint32_t num_checked = 0;
+
+    for (int32_t note = 0; note <= 127; ++note)
+    {
+        for (size_t bend_idx = 0; bend_idx < num_bends; ++bend_idx)
+        {
+            int32_t const bend = (((int32_t)bends[bend_idx] - 8192)
+                                  * (CHECK_BEND_RANGE << WT_PITCH_FRAC_BITS)) / 8192;
+
+            for (int32_t mod = -(1 << CHECK_MOD_VALUE_BITS); mod <= (1 << CHECK_MOD_VALUE_BITS);
+                 mod += 1000)
+            {
+                int32_t const mod_offset
+                    = (int32_t)(((int64_t)mod * (CHECK_MOD_PITCH_RANGE << WT_PITCH_FRAC_BITS))
+                                >> CHECK_MOD_VALUE_BITS);
+
+                int32_t pitch = (note << WT_PITCH_FRAC_BITS) + bend + mod_offset;
+                uint32_t const tune = wavetable_get_pitch_tune(pitch);
+
+                // The converter clamps to its range, so the reference does too.
+                if (pitch < 0)
+                    pitch = 0;
+                else if (pitch > WT_PITCH_MAX)
+                    pitch = WT_PITCH_MAX;
+
+                double const cents = fabs(1200.0 * log2(tune / check_float_tune(pitch)));
+                if (cents > worst_cents)
+                {
+                    worst_cents = cents;
+                    worst_pitch = pitch;
+                }
+                ++num_checked;
+            }
+        }
+    }
+
+    printf("%lu pitches checked, largest error %.4f cents at note %.3f, limit %.1f cents\n",
+           (unsigned long)num_checked, worst_cents, (double)worst_pitch / WT_PITCH_SEMITONE,
+           CHECK_MAX_ERROR_CENTS);
+
+    if (worst_cents > CHECK_MAX_ERROR_CENTS)
+    {
+        printf("FAIL: pitch converter error above the limit\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+// Host benchmark of the spectrum analyzer's FFT kernel. Build and run with
+// make spectrum-bench.
+//
+// Checks the configured transform size against the main loop budget of one
+// frame under the VR4300 cost model, checks the kernel's accuracy against a
+// double precision DFT, and times the kernel on the host.
+
+#include "spectrum_fft.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS 20000
+
+/// Largest error allowed in any bin, relative to a full scale bin: below
+/// the analyzer's 72 dB floor, so the error never shows on the bars.
+#define BENCH_MAX_ERROR_DB -75.0
+
+static int16_t twiddle_cos[SPECTRUM_FFT_SIZE / 2];
+static int16_t twiddle_sin[SPECTRUM_FFT_SIZE / 2];
+static int16_t input[SPECTRUM_FFT_SIZE];
+static int32_t fft_re[SPECTRUM_FFT_SIZE];
+static int32_t fft_im[SPECTRUM_FFT_SIZE];
+
+static double bench_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1e6) + (ts.tv_nsec / 1e3);
+}
+
+static void bench_load(void)
+{
+    for (size_t idx = 0; idx < SPECTRUM_FFT_SIZE; ++idx)
+    {
+        fft_re[idx] = input[idx];
+        fft_im[idx] = 0;
+    }
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    printf("points  butterflies  VR4300 model (us)  budget %u us\n", SPECTRUM_FFT_BUDGET_US);
+    for (size_t bits = 7; bits <= 12; ++bits)
+    {
+        uint32_t const model_us = spectrum_fft_model_us(bits);
+        printf("%6u  %11u  %17lu  %s%s\n", 1u << bits, (1u << (bits - 1)) * (unsigned)bits,
+               (unsigned long)model_us, (model_us <= SPECTRUM_FFT_BUDGET_US) ? "fits" : "over",
+               (SPECTRUM_FFT_BITS == bits) ? "  <- configured" : "");
+    }
+
+    if (spectrum_fft_model_us(SPECTRUM_FFT_BITS) > SPECTRUM_FFT_BUDGET_US)
+    {
+        printf("FAIL: %u points exceeds the frame budget\n", SPECTRUM_FFT_SIZE);
+        failed = 1;
+    }
+
+    // Two full scale tones and some noise, the worst case for headroom.
+    srand(1);
+    for (size_t idx = 0; idx < SPECTRUM_FFT_SIZE; ++idx)
+    {
+        double const x = (2.0 * M_PI * idx) / SPECTRUM_FFT_SIZE;
+        double const sample = (16000.0 * sin(x * 37.0)) + (16000.0 * cos(x * 101.5))
+                              + ((rand() % 512) - 256);
+        input[idx] = (int16_t)lrint(sample);
+    }
+
+    spectrum_fft_twiddles(twiddle_cos, twiddle_sin);
+    bench_load();
+    spectrum_fft(fft_re, fft_im, twiddle_cos, twiddle_sin);
+
+    double max_error = 0.0;
+    for (size_t bin = 0; bin < SPECTRUM_FFT_SIZE; ++bin)
+    {
+        double ref_re = 0.0;
+        double ref_im = 0.0;
+        for (size_t idx = 0; idx < SPECTRUM_FFT_SIZE; ++idx)
+        {
+            double const angle = (2.0 * M_PI * bin * idx) / SPECTRUM_FFT_SIZE;
+            ref_re += input[idx] * cos(angle);
+            ref_im -= input[idx] * sin(angle);
+        }
+
+        double const error = hypot(fft_re[bin] - ref_re, fft_im[bin] - ref_im);
+        if (error > max_error)
+        {
+            max_error = error;
+        }
+    }
+
+    double const full_scale = (double)INT16_MAX * SPECTRUM_FFT_SIZE / 2;
+    double const error_db = 20.0 * log10((max_error + 1e-9) / full_scale);
+    printf("largest bin error %.1f dB below full scale, limit %.1f dB\n",
+           -error_db, -BENCH_MAX_ERROR_DB);
+    if (error_db > BENCH_MAX_ERROR_DB)
+    {
+        printf("FAIL: kernel error above the limit\n");
+        failed = 1;
+    }
+
+    double const start_us = bench_now_us();
+    for (size_t iter = 0; iter < BENCH_ITERATIONS; ++iter)
+    {
+        bench_load();
+        spectrum_fft(fft_re, fft_im, twiddle_cos, twiddle_sin);
+    }
+    double const host_us = (bench_now_us() - start_us) / BENCH_ITERATIONS;
+    printf("host: %.2f us per %u point transform\n", host_us, SPECTRUM_FFT_SIZE);
+
+    return failed;
+}